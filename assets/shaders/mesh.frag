@@ -0,0 +1,51 @@
+#version 450
+#extension GL_EXT_buffer_reference : require
+
+layout (location = 0) in vec3 inColor;
+layout (location = 1) in vec2 inUV;
+layout (location = 2) in vec3 inNormal;
+layout (location = 3) flat in uint inTexture;
+
+layout (location = 0) out vec4 outFragColor;
+
+// Matches MAX_STREAMED_TEXTURES in texture_streamer.h.
+const uint MAX_STREAMED_TEXTURES = 4096;
+
+// Matches DebugView in renderer.h, folded in per pipeline so the default variant carries no debug code.
+layout(constant_id = 0) const uint DEBUG_VIEW = 0;
+const uint DEBUG_VIEW_NORMALS = 1;
+const uint DEBUG_VIEW_UV = 2;
+const uint DEBUG_VIEW_TEXTURE_LOD = 3;
+
+layout(buffer_reference, std430) buffer TextureFeedback {
+    uint requests[];
+};
+
+layout(push_constant) uniform constants {
+    layout(offset = 64) TextureFeedback texture_feedback;
+} push_constants;
+
+void main()  {
+    outFragColor = vec4(inColor, 1.0f);
+
+    // The footprint is taken in uv space so the CPU can turn it into a level for any resolution. Only one pixel
+    // in each 4x4 tile reports, which keeps atomic traffic low and still covers every visible surface.
+    vec2 footprint = max(abs(dFdx(inUV)), abs(dFdy(inUV)));
+
+    if (DEBUG_VIEW == DEBUG_VIEW_NORMALS) {
+        outFragColor = vec4(normalize(inNormal) * 0.5 + 0.5, 1.0f);
+    } else if (DEBUG_VIEW == DEBUG_VIEW_UV) {
+        outFragColor = vec4(fract(inUV), 0.0f, 1.0f);
+    } else if (DEBUG_VIEW == DEBUG_VIEW_TEXTURE_LOD) {
+        // Mip level a 1024 texel texture would sample, green at the top level through red at level 5.
+        float level = clamp(log2(max(max(footprint.x, footprint.y), 1e-9)) + 10.0, 0.0, 5.0) / 5.0;
+        outFragColor = vec4(level, 1.0f - level, 0.0f, 1.0f);
+    }
+
+    uvec2 pixel = uvec2(gl_FragCoord.xy);
+    if (inTexture < MAX_STREAMED_TEXTURES && (pixel.x & 3u) == 0u && (pixel.y & 3u) == 0u) {
+        float lod = log2(max(max(footprint.x, footprint.y), 1e-9));
+        uint request = uint(clamp((lod + 32.0) * 16.0, 0.0, 65535.0));
+        atomicMin(push_constants.texture_feedback.requests[inTexture], request);
+    }
+}
@@ -1,9 +1,24 @@
 #version 450
 #extension GL_EXT_buffer_reference : require
 
+// Set per permutation by the renderer, see mesh_variants in renderer.cpp.
+#ifndef QUANTIZED_VERTICES
+#define QUANTIZED_VERTICES 0
+#endif
+
 layout (location = 0) out vec3 outColor;
 layout (location = 1) out vec2 outUV;
+layout (location = 2) out vec3 outNormal;
+layout (location = 3) flat out uint outTexture;
 
+#if QUANTIZED_VERTICES
+struct Vertex {
+    uint position_xy;
+    uint position_z_color;
+    uint normal;
+    uint uv;
+};
+#else
 struct Vertex {
     vec3 position;
     float uv_x;
@@ -11,21 +26,59 @@ struct Vertex {
     float uv_y;
     vec4 color;
 };
+#endif
 
 layout(buffer_reference, std430) readonly buffer VertexBuffer {
     Vertex vertices[];
 };
 
+struct Instance {
+    mat4 model;
+    vec4 color;
+    uint material_id;
+    uint texture;
+};
+
+layout(buffer_reference, std430) readonly buffer InstanceBuffer {
+    Instance instances[];
+};
+
 layout(push_constant) uniform constants {
     mat4 render_matrix;
+    uvec2 texture_feedback;
     VertexBuffer vertex_buffer;
+    InstanceBuffer instance_buffer;
 } push_constants;
 
+#if QUANTIZED_VERTICES
+vec3 decode_rgb565(uint c) {
+    return vec3(uvec3(c >> 11, c >> 5, c) & uvec3(31, 63, 31)) / vec3(31.0, 63.0, 31.0);
+}
+
+vec3 decode_octahedral(vec2 e) {
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+#endif
+
 void main()  {
-	Vertex v = push_constants.vertex_buffer.vertices[gl_VertexIndex];
+    Vertex v = push_constants.vertex_buffer.vertices[gl_VertexIndex];
+    Instance instance = push_constants.instance_buffer.instances[gl_InstanceIndex];
 
-    gl_Position = push_constants.render_matrix * vec4(v.position, 1.0f);
-	outColor = v.color.xyz;
-	outUV.x = v.uv_x;
-	outUV.y = v.uv_y;
-}
\ No newline at end of file
+#if QUANTIZED_VERTICES
+    vec3 position = vec3(unpackUnorm2x16(v.position_xy), float(v.position_z_color & 0xFFFFu) / 65535.0);
+    gl_Position = push_constants.render_matrix * instance.model * vec4(position, 1.0f);
+    outColor = decode_rgb565(v.position_z_color >> 16) * instance.color.xyz;
+    outUV = unpackHalf2x16(v.uv);
+    outNormal = decode_octahedral(unpackSnorm2x16(v.normal));
+#else
+    gl_Position = push_constants.render_matrix * instance.model * vec4(v.position, 1.0f);
+    outColor = v.color.xyz * instance.color.xyz;
+    outUV = vec2(v.uv_x, v.uv_y);
+    outNormal = v.normal;
+#endif
+    outTexture = instance.texture;
+}
@@ -0,0 +1,58 @@
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "render/frustum_culling.h"
+
+using namespace Posideon;
+
+namespace {
+    constexpr uint32_t OBJECT_COUNT = 1'000'000;
+    constexpr uint32_t ITERATIONS = 50;
+
+    template<typename F>
+    double measure(F&& function) {
+        double best = 1e30;
+        for (uint32_t i = 0; i < ITERATIONS; i++) {
+            const auto start = std::chrono::high_resolution_clock::now();
+            function();
+            const auto end = std::chrono::high_resolution_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return best;
+    }
+}
+
+int main() {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.1f, 4.0f);
+
+    CullingBounds bounds;
+    bounds.reserve(OBJECT_COUNT);
+    for (uint32_t i = 0; i < OBJECT_COUNT; i++) {
+        bounds.push(glm::vec3(position(random), position(random), position(random)), size(random), i);
+    }
+
+    ExtractedView view {
+        .projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 10000.0f, 0.1f),
+        .view = glm::lookAt(glm::vec3(0.0f, 0.0f, -600.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+    };
+    view.projection[1][1] *= -1;
+    const Frustum frustum = extract_frustum(view);
+
+    std::vector<uint32_t> visible;
+    visible.reserve(OBJECT_COUNT);
+
+    const double sphere_ms = measure([&] {
+        visible.clear();
+        cull_spheres(bounds, frustum, visible);
+    });
+    const size_t sphere_visible = visible.size();
+
+    printf("kernel: %s, objects: %u\n", culling_kernel_name(), OBJECT_COUNT);
+    printf("spheres: %.3f ms (%.2f ns/object), %zu visible\n", sphere_ms, sphere_ms * 1e6 / OBJECT_COUNT, sphere_visible);
+    return 0;
+}
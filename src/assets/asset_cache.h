@@ -0,0 +1,23 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+namespace Posideon {
+    // Generated data, such as baked textures, mesh caches, SPIR-V and the pipeline cache, is written under
+    // cache/<kind> in the working directory, the build directory the app and asset_bake run from. The
+    // asset tree only holds sources.
+    [[nodiscard]] inline std::filesystem::path asset_cache_directory(std::string_view kind) {
+        return std::filesystem::path("cache") / kind;
+    }
+
+    [[nodiscard]] inline uint64_t fnv1a(std::span<const uint8_t> bytes, uint64_t hash = 0xcbf29ce484222325ull) {
+        for (const uint8_t byte : bytes) {
+            hash = (hash ^ byte) * 0x100000001b3ull;
+        }
+        return hash;
+    }
+}
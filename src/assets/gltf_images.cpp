@@ -0,0 +1,83 @@
+#include "gltf_images.h"
+
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <variant>
+
+namespace Posideon {
+    std::span<const uint8_t> gltf_image_bytes(const fastgltf::Asset& gltf, const fastgltf::Image& image, const std::filesystem::path& directory, std::vector<uint8_t>& storage) {
+        return std::visit([&](const auto& source) -> std::span<const uint8_t> {
+            using SourceType = std::decay_t<decltype(source)>;
+            if constexpr (std::is_same_v<SourceType, fastgltf::sources::Vector>) {
+                return source.bytes;
+            } else if constexpr (std::is_same_v<SourceType, fastgltf::sources::URI>) {
+                std::ifstream file(directory / std::filesystem::path(std::string(source.uri.path())), std::ios::binary | std::ios::ate);
+                if (!file.is_open()) {
+                    return {};
+                }
+                storage.resize(static_cast<size_t>(file.tellg()));
+                file.seekg(0);
+                file.read(reinterpret_cast<char*>(storage.data()), static_cast<std::streamsize>(storage.size()));
+                return storage;
+            } else if constexpr (std::is_same_v<SourceType, fastgltf::sources::BufferView>) {
+                const fastgltf::BufferView& view = gltf.bufferViews[source.bufferViewIndex];
+                const auto* buffer = std::get_if<fastgltf::sources::Vector>(&gltf.buffers[view.bufferIndex].data);
+                if (buffer == nullptr) {
+                    return {};
+                }
+                return std::span(buffer->bytes).subspan(view.byteOffset, view.byteLength);
+            } else {
+                return {};
+            }
+        }, image.data);
+    }
+
+    std::vector<TextureUsage> gltf_image_usages(const fastgltf::Asset& gltf) {
+        // Colour data is stored in sRGB, everything else (normals, roughness, occlusion) is linear.
+        std::vector<TextureUsage> usages(gltf.images.size(), TextureUsage::Data);
+        const auto mark = [&](const auto& texture_info, TextureUsage usage) {
+            if (texture_info) {
+                const fastgltf::Texture& texture = gltf.textures[texture_info->textureIndex];
+                if (texture.imageIndex && usages[*texture.imageIndex] == TextureUsage::Data) {
+                    usages[*texture.imageIndex] = usage;
+                }
+            }
+        };
+        std::vector<bool> packed(gltf.images.size());
+        for (const fastgltf::Material& material : gltf.materials) {
+            mark(material.pbrData.baseColorTexture, TextureUsage::Color);
+            mark(material.emissiveTexture, TextureUsage::Color);
+            mark(material.normalTexture, TextureUsage::Normal);
+            if (const auto& metallic_roughness = material.pbrData.metallicRoughnessTexture) {
+                if (const auto& image = gltf.textures[metallic_roughness->textureIndex].imageIndex) {
+                    packed[*image] = true;
+                }
+            }
+        }
+        for (const fastgltf::Material& material : gltf.materials) {
+            if (material.occlusionTexture) {
+                const auto& image = gltf.textures[material.occlusionTexture->textureIndex].imageIndex;
+                if (image && !packed[*image]) {
+                    mark(material.occlusionTexture, TextureUsage::SingleChannel);
+                }
+            }
+        }
+        return usages;
+    }
+
+    std::optional<size_t> gltf_mesh_image(const fastgltf::Asset& gltf, const fastgltf::Mesh& mesh) {
+        if (mesh.primitives.empty() || !mesh.primitives[0].materialIndex) {
+            return {};
+        }
+        const fastgltf::Material& material = gltf.materials[*mesh.primitives[0].materialIndex];
+        if (!material.pbrData.baseColorTexture) {
+            return {};
+        }
+        const fastgltf::Texture& texture = gltf.textures[material.pbrData.baseColorTexture->textureIndex];
+        if (!texture.imageIndex) {
+            return {};
+        }
+        return *texture.imageIndex;
+    }
+}
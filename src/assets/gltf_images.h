@@ -0,0 +1,24 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+#include <fastgltf/types.hpp>
+
+#include "assets/texture_bake.h"
+
+namespace Posideon {
+    // Encoded bytes of the image, external files are read into storage.
+    [[nodiscard]] std::span<const uint8_t> gltf_image_bytes(const fastgltf::Asset& gltf, const fastgltf::Image& image, const std::filesystem::path& directory, std::vector<uint8_t>& storage);
+
+    // Usage of every image as referenced by the materials, images referenced in several roles keep the
+    // first colour or normal role they were found in. Occlusion maps are single channel unless the image
+    // also holds metallic-roughness, as packed ORM textures do.
+    [[nodiscard]] std::vector<TextureUsage> gltf_image_usages(const fastgltf::Asset& gltf);
+
+    // Base colour image of the first primitive's material. Draws of the mesh report streaming feedback for it.
+    [[nodiscard]] std::optional<size_t> gltf_mesh_image(const fastgltf::Asset& gltf, const fastgltf::Mesh& mesh);
+}
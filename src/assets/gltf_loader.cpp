@@ -3,112 +3,386 @@
 #include <fastgltf/glm_element_traits.hpp>
 #include <fastgltf/parser.hpp>
 #include <fastgltf/tools.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+#include <variant>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 
+#include "assets/gltf_images.h"
+#include "assets/ktx2_loader.h"
+#include "assets/mesh_cache.h"
+#include "assets/texture_bake.h"
+#include "assets/texture_loader.h"
+#include "core/job_system.h"
 #include "render/renderer.h"
 
 namespace Posideon {
-    std::optional<std::vector<std::shared_ptr<GltfAsset>>> load_gltf_meshes(Renderer* renderer, std::filesystem::path path) {
-        fastgltf::GltfDataBuffer data;
-        data.loadFromFile(path);
+    const GPUSurface& GltfAsset::gpu_surface(size_t surface, uint32_t lod) const {
+        if (lod == 0) {
+            return mesh_buffers->surfaces[surface];
+        }
+        return mesh_buffers->surfaces[surfaces.size() + surface_lods[surface].lod_offset + lod - 1];
+    }
 
-        constexpr auto gltf_options = fastgltf::Options::LoadGLBBuffers | fastgltf::Options::LoadExternalBuffers;
-        
-        fastgltf::Parser parser {};
+    static BakedMesh import_gltf_mesh(fastgltf::Asset& gltf, fastgltf::Mesh& mesh) {
+        BakedMesh new_mesh;
+        new_mesh.name = mesh.name;
+        if (const std::optional<size_t> image = gltf_mesh_image(gltf, mesh)) {
+            new_mesh.image = static_cast<int32_t>(*image);
+        }
+        std::vector<uint32_t>& indices = new_mesh.indices;
+        std::vector<Vertex>& vertices = new_mesh.vertices;
 
-        auto load = parser.loadBinaryGLTF(&data, path.parent_path(), gltf_options);
-        POSIDEON_ASSERT(load)
-        fastgltf::Asset gltf = std::move(load.get());
+        for (auto&& p: mesh.primitives) {
+            size_t initial_vertex = vertices.size();
+
+            MeshSurface new_surface;
+            new_surface.start_index = static_cast<uint32_t>(indices.size());
+            new_surface.count = static_cast<uint32_t>(gltf.accessors[p.indicesAccessor.value()].count);
+            new_surface.first_vertex = static_cast<uint32_t>(initial_vertex);
+
+            {
+                fastgltf::Accessor& index_accessor = gltf.accessors[p.indicesAccessor.value()];
+                indices.reserve(indices.size() + index_accessor.count);
 
-        std::vector<std::shared_ptr<GltfAsset>> meshes;
-        std::vector<uint32_t> indices;
-        std::vector<Vertex> vertices;
-        for (fastgltf::Mesh& mesh : gltf.meshes) {
-            GltfAsset new_mesh;
-            new_mesh.name = mesh.name;
-
-            indices.clear();
-            vertices.clear();
-
-            for (auto&& p: mesh.primitives) {
-                GltfSurface new_surface;
-                new_surface.start_index = static_cast<uint32_t>(indices.size());
-                new_surface.count = static_cast<uint32_t>(gltf.accessors[p.indicesAccessor.value()].count);
-
-                size_t initial_vertex = vertices.size();
-                {
-                    fastgltf::Accessor& index_accessor = gltf.accessors[p.indicesAccessor.value()];
-                    indices.reserve(indices.size() + index_accessor.count);
-
-                    fastgltf::iterateAccessor<uint32_t>(gltf, index_accessor,
-                        [&](uint32_t idx) {
-                            indices.push_back(idx + initial_vertex);      
+                fastgltf::iterateAccessor<uint32_t>(gltf, index_accessor,
+                    [&](uint32_t idx) {
+                        indices.push_back(idx);
+                    }
+                );
+            }
+
+            {
+                fastgltf::Accessor& position_accessor = gltf.accessors[p.findAttribute("POSITION")->second];
+                vertices.resize(vertices.size() + position_accessor.count);
+                fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, position_accessor,
+                    [&](glm::vec3 v, size_t index) {
+                        Vertex new_vertex;
+                        new_vertex.position = v;
+                        new_vertex.normal = { 1, 0, 0 };
+                        new_vertex.color = glm::vec4(1.0f),
+                        new_vertex.uv_x = 0;
+                        new_vertex.uv_y = 0;
+                        vertices[initial_vertex + index] = new_vertex;
+                    }
+                );
+            }
+
+            {
+                auto normals = p.findAttribute("NORMAL");
+                if (normals != p.attributes.end()) {
+                    fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, gltf.accessors[normals->second],
+                        [&](glm::vec3 v, size_t index) {
+                            vertices[initial_vertex + index].normal = v;
                         }
                     );
                 }
+            }
 
-                {
-                    fastgltf::Accessor& position_accessor = gltf.accessors[p.findAttribute("POSITION")->second];
-                    vertices.resize(vertices.size() + position_accessor.count);
-                    fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, position_accessor,
-                        [&](glm::vec3 v, size_t index) {
-                            Vertex new_vertex;
-                            new_vertex.position = v;
-                            new_vertex.normal = { 1, 0, 0 };
-                            new_vertex.color = glm::vec4(1.0f),
-                            new_vertex.uv_x = 0;
-                            new_vertex.uv_y = 0;
-                            vertices[initial_vertex + index] = new_vertex;
+            {
+                auto uv = p.findAttribute("TEXCOORD_0");
+                if (uv != p.attributes.end()) {
+                    fastgltf::iterateAccessorWithIndex<glm::vec2>(gltf, gltf.accessors[uv->second],
+                        [&](glm::vec2 v, size_t index) {
+                            vertices[initial_vertex + index].uv_x = v.x;
+                            vertices[initial_vertex + index].uv_y = v.y;
                         }
                     );
                 }
+            }
 
-                {
-                    auto normals = p.findAttribute("NORMAL");
-                    if (normals != p.attributes.end()) {
-                        fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, gltf.accessors[normals->second],
-                            [&](glm::vec3 v, size_t index) {
-                                vertices[initial_vertex + index].normal = v;
-                            }
-                        );
-                    }
+            {
+                auto colors = p.findAttribute("COLOR_0");
+                if (colors != p.attributes.end()) {
+                    fastgltf::iterateAccessorWithIndex<glm::vec4>(gltf, gltf.accessors[colors->second],
+                        [&](glm::vec4 v, size_t index) {
+                            vertices[initial_vertex + index].color = v;
+                        }
+                    );
                 }
+            }
+
+            new_mesh.surfaces.push_back(new_surface);
+        }
+
+        constexpr bool override_colors = true;
+        if (override_colors) {
+            for (Vertex& vertex: vertices) {
+                vertex.color = glm::vec4(vertex.normal, 1.0f);
+            }
+        }
+
+        optimize_mesh(vertices, indices, new_mesh.surfaces);
+        new_mesh.meshlets = build_meshlets(vertices, indices, new_mesh.surfaces);
+        build_lod_chains(vertices, indices, new_mesh.surfaces, new_mesh.surface_lods, new_mesh.lods);
+        return new_mesh;
+    }
+
+    static glm::mat4 node_matrix(const fastgltf::Node& node) {
+        return std::visit([](const auto& transform) {
+            using TransformType = std::decay_t<decltype(transform)>;
+            if constexpr (std::is_same_v<TransformType, fastgltf::Node::TransformMatrix>) {
+                glm::mat4 matrix;
+                memcpy(&matrix, transform.data(), sizeof(matrix));
+                return matrix;
+            } else {
+                const glm::vec3 translation(transform.translation[0], transform.translation[1], transform.translation[2]);
+                const glm::quat rotation(transform.rotation[3], transform.rotation[0], transform.rotation[1], transform.rotation[2]);
+                const glm::vec3 scale(transform.scale[0], transform.scale[1], transform.scale[2]);
+                return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+            }
+        }, node.transform);
+    }
+
+    static std::vector<BakedNode> import_gltf_nodes(const fastgltf::Asset& gltf) {
+        std::vector<BakedNode> nodes;
+        if (gltf.scenes.empty()) {
+            return nodes;
+        }
+
+        // Breadth first from the scene roots, a node's slot in the queue is its slot in the output.
+        const fastgltf::Scene& scene = gltf.scenes[gltf.defaultScene.value_or(0)];
+        std::vector<std::pair<size_t, int32_t>> queue;
+        for (const size_t root : scene.nodeIndices) {
+            queue.emplace_back(root, -1);
+        }
+        for (size_t i = 0; i < queue.size(); i++) {
+            const auto [node_index, parent] = queue[i];
+            const fastgltf::Node& node = gltf.nodes[node_index];
+            nodes.push_back(BakedNode {
+                .name = std::string(node.name.begin(), node.name.end()),
+                .parent = parent,
+                .mesh = node.meshIndex ? static_cast<int32_t>(*node.meshIndex) : -1,
+                .local = node_matrix(node),
+            });
+            for (const size_t child : node.children) {
+                queue.emplace_back(child, static_cast<int32_t>(i));
+            }
+        }
+        return nodes;
+    }
+
+    static std::optional<BakedScene> import_gltf(const std::filesystem::path& path, JobSystem& jobs) {
+        fastgltf::GltfDataBuffer data;
+        data.loadFromFile(path);
+
+        constexpr auto gltf_options = fastgltf::Options::LoadGLBBuffers | fastgltf::Options::LoadExternalBuffers;
+        
+        fastgltf::Parser parser {};
 
-                {
-                    auto uv = p.findAttribute("TEXCOORD_0");
-                    if (uv != p.attributes.end()) {
-                        fastgltf::iterateAccessorWithIndex<glm::vec2>(gltf, gltf.accessors[uv->second],
-                            [&](glm::vec2 v, size_t index) {
-                                vertices[initial_vertex + index].uv_x = v.x;
-                                vertices[initial_vertex + index].uv_y = v.y;
-                            }
-                        );
+        auto load = parser.loadBinaryGLTF(&data, path.parent_path(), gltf_options);
+        if (!load) {
+            std::cout << "Failed to parse glTF " << path << std::endl;
+            return {};
+        }
+        fastgltf::Asset gltf = std::move(load.get());
+
+        // Meshes decode and bake independently, accessors are only read.
+        BakedScene scene;
+        scene.meshes.resize(gltf.meshes.size());
+        jobs.parallel_for(static_cast<uint32_t>(gltf.meshes.size()), 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t mesh_index = begin; mesh_index < end; mesh_index++) {
+                scene.meshes[mesh_index] = import_gltf_mesh(gltf, gltf.meshes[mesh_index]);
+            }
+        });
+        scene.nodes = import_gltf_nodes(gltf);
+        return scene;
+    }
+
+    std::vector<TextureHandle> load_gltf_textures(Renderer* renderer, const std::filesystem::path& path) {
+        fastgltf::GltfDataBuffer data;
+        data.loadFromFile(path);
+
+        constexpr auto gltf_options = fastgltf::Options::LoadGLBBuffers | fastgltf::Options::LoadExternalBuffers;
+        fastgltf::Parser parser {};
+        auto load = parser.loadBinaryGLTF(&data, path.parent_path(), gltf_options);
+        POSIDEON_ASSERT(load)
+        const fastgltf::Asset gltf = std::move(load.get());
+
+        const std::vector<TextureUsage> usages = gltf_image_usages(gltf);
+        std::vector<bool> streamed(gltf.images.size(), false);
+        for (const fastgltf::Mesh& mesh : gltf.meshes) {
+            if (const std::optional<size_t> image = gltf_mesh_image(gltf, mesh)) {
+                streamed[*image] = true;
+            }
+        }
+        const std::filesystem::path cache_directory = texture_cache_directory();
+        // Devices with BC7 sampling get baked block compressed textures, decoded PNG and JPEG data is only
+        // uploaded as RGBA8 when they cannot sample it.
+        const bool bake = renderer->bc7_supported;
+
+        // KTX2 payloads stay block compressed and are skipped when the device cannot sample their format, anything
+        // else goes through the bake cache or stb_image.
+        enum class Decoded : uint8_t { Failed, Cached, Pixels, Compressed };
+        std::vector<TextureImage> images(gltf.images.size());
+        std::vector<CompressedTexture> compressed(gltf.images.size());
+        std::vector<Decoded> decoded(gltf.images.size(), Decoded::Failed);
+        renderer->jobs->parallel_for(static_cast<uint32_t>(gltf.images.size()), 1, [&](uint32_t begin, uint32_t end) {
+            std::vector<uint8_t> storage;
+            for (uint32_t i = begin; i < end; i++) {
+                const std::string name = path.string() + "#image" + std::to_string(i);
+                if (renderer->texture_cache.find(name)) {
+                    images[i].name = name;
+                    decoded[i] = Decoded::Cached;
+                    continue;
+                }
+                const std::span<const uint8_t> bytes = gltf_image_bytes(gltf, gltf.images[i], path.parent_path(), storage);
+                const bool srgb = usages[i] == TextureUsage::Color;
+                std::optional<CompressedTexture> texture;
+                if (is_ktx2(bytes)) {
+                    texture = load_ktx2(bytes);
+                    if (texture && !renderer->sampled_format_supported(texture->format)) {
+                        std::cout << "KTX2 image " << i << " of " << path << " uses format " << texture->format << ", which the device cannot sample" << std::endl;
+                        continue;
                     }
+                } else if (bake && !bytes.empty()) {
+                    texture = bake_texture(bytes, usages[i], cache_directory, *renderer->jobs);
                 }
-
-                {
-                    auto colors = p.findAttribute("COLOR_0");
-                    if (colors != p.attributes.end()) {
-                        fastgltf::iterateAccessorWithIndex<glm::vec4>(gltf, gltf.accessors[colors->second],
-                            [&](glm::vec4 v, size_t index) {
-                                vertices[initial_vertex + index].color = v;
-                            }
-                        );
+                if (texture) {
+                    compressed[i] = std::move(*texture);
+                    compressed[i].name = name;
+                    compressed[i].streamed = streamed[i];
+                    decoded[i] = Decoded::Compressed;
+                } else if (!is_ktx2(bytes)) {
+                    if (std::optional<TextureImage> image = decode_image(bytes, srgb)) {
+                        images[i] = std::move(*image);
+                        images[i].name = name;
+                        decoded[i] = Decoded::Pixels;
                     }
                 }
+                if (decoded[i] == Decoded::Failed) {
+                    std::cout << "Failed to decode image " << i << " of " << path << std::endl;
+                }
+            }
+        });
 
-                new_mesh.surfaces.push_back(new_surface);
+        std::vector<TextureImage> uploads;
+        std::vector<size_t> upload_indices;
+        std::vector<CompressedTexture> compressed_uploads;
+        std::vector<size_t> compressed_indices;
+        for (size_t i = 0; i < images.size(); i++) {
+            if (decoded[i] == Decoded::Cached || decoded[i] == Decoded::Pixels) {
+                uploads.push_back(std::move(images[i]));
+                upload_indices.push_back(i);
+            } else if (decoded[i] == Decoded::Compressed) {
+                compressed_uploads.push_back(std::move(compressed[i]));
+                compressed_indices.push_back(i);
             }
+        }
+        const std::vector<TextureHandle> uploaded = renderer->upload_textures(uploads);
+        const std::vector<TextureHandle> compressed_uploaded = renderer->upload_compressed_textures(compressed_uploads);
 
-            constexpr bool override_colors = true;
-            if (override_colors) {
-                for (Vertex& vertex: vertices) {
-                    vertex.color = glm::vec4(vertex.normal, 1.0f);
+        std::vector<TextureHandle> handles(gltf.images.size());
+        for (size_t i = 0; i < upload_indices.size(); i++) {
+            handles[upload_indices[i]] = uploaded[i];
+        }
+        for (size_t i = 0; i < compressed_indices.size(); i++) {
+            handles[compressed_indices[i]] = compressed_uploaded[i];
+        }
+        return handles;
+    }
+
+    static GltfAsset upload_gltf_mesh(Renderer* renderer, const BakedMesh& baked_mesh, const VertexCompressionSettings& compression) {
+        GltfAsset new_mesh;
+        new_mesh.name = baked_mesh.name;
+        new_mesh.surfaces = baked_mesh.surfaces;
+        new_mesh.surface_lods = baked_mesh.surface_lods;
+        new_mesh.lods = baked_mesh.lods;
+
+        std::vector<MeshSurface> lod_ranges;
+        lod_ranges.reserve(baked_mesh.lods.size());
+        for (size_t s = 0; s < baked_mesh.surfaces.size(); s++) {
+            const SurfaceLods& chain = baked_mesh.surface_lods[s];
+            for (uint32_t lod = 0; lod < chain.lod_count; lod++) {
+                const MeshLod& range = baked_mesh.lods[chain.lod_offset + lod];
+                lod_ranges.push_back(MeshSurface {
+                    .start_index = range.start_index,
+                    .count = range.count,
+                    .first_vertex = baked_mesh.surfaces[s].first_vertex,
+                });
+            }
+        }
+        const bool compact = can_compress_vertices(baked_mesh.vertices, compression);
+        if (compact) {
+            CompressedVertices compressed = compress_vertices(baked_mesh.vertices);
+            new_mesh.vertex_format = VertexFormat::Compact;
+            new_mesh.dequantization = compressed.dequantization;
+            new_mesh.mesh_buffers = renderer->create_mesh(baked_mesh.indices, compressed.vertices, new_mesh.surfaces, lod_ranges);
+        } else {
+            new_mesh.mesh_buffers = renderer->create_mesh(baked_mesh.indices, baked_mesh.vertices, new_mesh.surfaces, lod_ranges);
+        }
+        // The mesh shader only reads full vertices, compact meshes always draw through expanded indices.
+        new_mesh.meshlet_buffers = renderer->create_meshlets(baked_mesh.meshlets, compact || !renderer->mesh_shader_supported);
+        return new_mesh;
+    }
+
+    std::optional<BakedScene> bake_gltf_scene(const std::filesystem::path& path, JobSystem& jobs) {
+        std::optional<BakedScene> baked = load_mesh_cache(path);
+        if (!baked) {
+            baked = import_gltf(path, jobs);
+            if (baked) {
+                save_mesh_cache(path, *baked);
+            }
+        }
+        return baked;
+    }
+
+    std::optional<GltfScene> load_gltf_scene(Renderer* renderer, std::filesystem::path path, const VertexCompressionSettings& compression) {
+        std::optional<BakedScene> baked = bake_gltf_scene(path, *renderer->jobs);
+        if (!baked) {
+            return {};
+        }
+
+        GltfScene scene;
+        scene.nodes = std::move(baked->nodes);
+        scene.images = load_gltf_textures(renderer, path);
+        LoadedGltf loaded { .path = std::filesystem::weakly_canonical(path), .compression = compression };
+        for (const BakedMesh& baked_mesh : baked->meshes) {
+            scene.meshes.emplace_back(std::make_shared<GltfAsset>(upload_gltf_mesh(renderer, baked_mesh, compression)));
+            if (baked_mesh.image >= 0 && static_cast<size_t>(baked_mesh.image) < scene.images.size()) {
+                scene.meshes.back()->texture = scene.images[baked_mesh.image];
+            }
+            loaded.meshes.emplace_back(scene.meshes.back());
+        }
+        renderer->loaded_gltfs.push_back(std::move(loaded));
+
+        return scene;
+    }
+
+    std::vector<std::shared_ptr<GltfAsset>> reload_gltf_scene(Renderer* renderer, const std::filesystem::path& path, const BakedScene& baked) {
+        const std::filesystem::path canonical = std::filesystem::weakly_canonical(path);
+        std::vector<std::shared_ptr<GltfAsset>> reloaded;
+        for (LoadedGltf& loaded : renderer->loaded_gltfs) {
+            if (loaded.path != canonical) {
+                continue;
+            }
+            // Assigning releases the old buffers, their geometry ranges and meshlet buffers are retired
+            // until the frames that may still draw them have finished.
+            const size_t count = std::min(loaded.meshes.size(), baked.meshes.size());
+            for (size_t mesh = 0; mesh < count; mesh++) {
+                if (std::shared_ptr<GltfAsset> asset = loaded.meshes[mesh].lock()) {
+                    // Images are not reloaded, the mesh keeps the texture it was loaded with.
+                    const TextureHandle texture = asset->texture;
+                    *asset = upload_gltf_mesh(renderer, baked.meshes[mesh], loaded.compression);
+                    asset->texture = texture;
+                    reloaded.push_back(std::move(asset));
                 }
             }
-            new_mesh.mesh_buffers = renderer->create_mesh(indices, vertices);
-            meshes.emplace_back(std::make_shared<GltfAsset>(std::move(new_mesh)));
         }
+        std::erase_if(renderer->loaded_gltfs, [](const LoadedGltf& loaded) {
+            return std::ranges::none_of(loaded.meshes, [](const std::weak_ptr<GltfAsset>& mesh) { return !mesh.expired(); });
+        });
+        return reloaded;
+    }
 
-        return meshes;
+    std::optional<std::vector<std::shared_ptr<GltfAsset>>> load_gltf_meshes(Renderer* renderer, std::filesystem::path path, const VertexCompressionSettings& compression) {
+        std::optional<GltfScene> scene = load_gltf_scene(renderer, std::move(path), compression);
+        if (!scene) {
+            return {};
+        }
+        return std::move(scene->meshes);
     }
 }
\ No newline at end of file
@@ -8,21 +8,56 @@
 #include <filesystem>
 
 #include "graphics/vulkan/vulkan_types.h"
+#include "assets/mesh_cache.h"
+#include "assets/meshlet_builder.h"
+#include "assets/mesh_simplifier.h"
+#include "assets/vertex_compression.h"
+#include "render/texture_cache.h"
 
 namespace Posideon {
+    class JobSystem;
     struct Renderer;
     
-    struct GltfSurface {
-        uint32_t start_index;
-        uint32_t count;
-    };
-
     struct GltfAsset {
         std::string name;
-        std::vector<GltfSurface> surfaces;
+        std::vector<MeshSurface> surfaces;
+        std::vector<SurfaceLods> surface_lods;
+        std::vector<MeshLod> lods;
 
-        GPUMeshBuffers mesh_buffers;
+        VertexFormat vertex_format = VertexFormat::Full;
+        glm::mat4 dequantization { 1.0f };
+        std::shared_ptr<GPUMeshBuffers> mesh_buffers;
+        std::shared_ptr<GPUMeshlets> meshlet_buffers;
+        // Base colour texture, invalid when the mesh has none or it failed to load.
+        TextureHandle texture;
+
+        [[nodiscard]] const GPUSurface& gpu_surface(size_t surface, uint32_t lod) const;
     };
     
-    std::optional<std::vector<std::shared_ptr<GltfAsset>>> load_gltf_meshes(Renderer* renderer, std::filesystem::path path);
+    // Every mesh is uploaded once, however many nodes reference it. Node mesh indices point into meshes,
+    // images holds one texture per glTF image and stays invalid for images that failed to decode.
+    struct GltfScene {
+        std::vector<std::shared_ptr<GltfAsset>> meshes;
+        std::vector<BakedNode> nodes;
+        std::vector<TextureHandle> images;
+    };
+
+    // Meshes of one loaded file, kept so a reload can replace their contents in place. Nodes are not
+    // reloaded, entities instantiated from the scene keep their hierarchy.
+    struct LoadedGltf {
+        std::filesystem::path path;
+        VertexCompressionSettings compression;
+        std::vector<std::weak_ptr<GltfAsset>> meshes;
+    };
+
+    // Reads the mesh cache or imports and caches the file. Touches no GPU state, so it can run on any thread.
+    std::optional<BakedScene> bake_gltf_scene(const std::filesystem::path& path, JobSystem& jobs);
+    std::optional<GltfScene> load_gltf_scene(Renderer* renderer, std::filesystem::path path, const VertexCompressionSettings& compression = {});
+    // Decodes the images on the renderer's job system and uploads them as one batch. PNG and JPEG images are
+    // swapped for their baked BC versions from the texture cache when the device can sample BC7.
+    std::vector<TextureHandle> load_gltf_textures(Renderer* renderer, const std::filesystem::path& path);
+    std::optional<std::vector<std::shared_ptr<GltfAsset>>> load_gltf_meshes(Renderer* renderer, std::filesystem::path path, const VertexCompressionSettings& compression = {});
+    // Uploads a rebaked file over every mesh loaded from it, matched by mesh index, and returns the assets it
+    // replaced. Must run on the render thread between frames since draws read the assets directly.
+    std::vector<std::shared_ptr<GltfAsset>> reload_gltf_scene(Renderer* renderer, const std::filesystem::path& path, const BakedScene& baked);
 }
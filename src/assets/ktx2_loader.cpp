@@ -0,0 +1,215 @@
+#include "ktx2_loader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace Posideon {
+    namespace {
+        constexpr uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+        constexpr uint32_t SUPERCOMPRESSION_NONE = 0;
+        constexpr uint32_t SUPERCOMPRESSION_BASIS_LZ = 1;
+
+        struct Ktx2Header {
+            uint8_t identifier[12];
+            uint32_t vk_format;
+            uint32_t type_size;
+            uint32_t pixel_width;
+            uint32_t pixel_height;
+            uint32_t pixel_depth;
+            uint32_t layer_count;
+            uint32_t face_count;
+            uint32_t level_count;
+            uint32_t supercompression_scheme;
+            uint32_t dfd_byte_offset;
+            uint32_t dfd_byte_length;
+            uint32_t kvd_byte_offset;
+            uint32_t kvd_byte_length;
+            uint64_t sgd_byte_offset;
+            uint64_t sgd_byte_length;
+        };
+        static_assert(sizeof(Ktx2Header) == 80);
+
+        struct Ktx2Level {
+            uint64_t byte_offset;
+            uint64_t byte_length;
+            uint64_t uncompressed_byte_length;
+        };
+
+        // Khronos data format descriptor values for the block formats the bake step writes.
+        constexpr uint32_t DFD_MODEL_BC4 = 131;
+        constexpr uint32_t DFD_MODEL_BC5 = 132;
+        constexpr uint32_t DFD_MODEL_BC7 = 134;
+        constexpr uint32_t DFD_PRIMARIES_BT709 = 1;
+        constexpr uint32_t DFD_TRANSFER_LINEAR = 1;
+        constexpr uint32_t DFD_TRANSFER_SRGB = 2;
+
+        uint64_t level_size(VkFormat format, uint32_t width, uint32_t height) {
+            return static_cast<uint64_t>((width + 3) / 4) * ((height + 3) / 4) * block_size(format);
+        }
+
+        std::vector<uint32_t> basic_dfd(VkFormat format) {
+            uint32_t model = 0;
+            uint32_t sample_count = 1;
+            switch (format) {
+                case VK_FORMAT_BC4_UNORM_BLOCK: model = DFD_MODEL_BC4; break;
+                case VK_FORMAT_BC5_UNORM_BLOCK: model = DFD_MODEL_BC5; sample_count = 2; break;
+                case VK_FORMAT_BC7_UNORM_BLOCK:
+                case VK_FORMAT_BC7_SRGB_BLOCK: model = DFD_MODEL_BC7; break;
+                default: return {};
+            }
+            const uint32_t transfer = format == VK_FORMAT_BC7_SRGB_BLOCK ? DFD_TRANSFER_SRGB : DFD_TRANSFER_LINEAR;
+            const uint32_t block_bits = block_size(format) * 8 / sample_count;
+
+            const uint32_t block_size_bytes = 24 + 16 * sample_count;
+            std::vector<uint32_t> words {
+                4 + block_size_bytes,
+                0,
+                2 | (block_size_bytes << 16),
+                model | (DFD_PRIMARIES_BT709 << 8) | (transfer << 16),
+                3 | (3 << 8),
+                block_size(format),
+                0,
+            };
+            // BC5 stores red and green as two BC4 halves, every other format is one sample covering the block.
+            for (uint32_t sample = 0; sample < sample_count; sample++) {
+                words.push_back((sample * block_bits) | ((block_bits - 1) << 16) | (sample << 24));
+                words.push_back(0);
+                words.push_back(0);
+                words.push_back(0xFFFFFFFF);
+            }
+            return words;
+        }
+    }
+
+    uint32_t block_size(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+            case VK_FORMAT_BC4_SNORM_BLOCK:
+                return 8;
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+            case VK_FORMAT_BC5_SNORM_BLOCK:
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                return 16;
+            default:
+                return 0;
+        }
+    }
+
+    bool is_ktx2(std::span<const uint8_t> bytes) {
+        return bytes.size() >= sizeof(KTX2_IDENTIFIER) && memcmp(bytes.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0;
+    }
+
+    std::optional<CompressedTexture> load_ktx2(std::span<const uint8_t> bytes) {
+        if (!is_ktx2(bytes) || bytes.size() < sizeof(Ktx2Header)) {
+            return {};
+        }
+        Ktx2Header header;
+        memcpy(&header, bytes.data(), sizeof(header));
+
+        // Only plain 2D textures, arrays, cubemaps and volumes have no consumer yet.
+        if (header.pixel_width == 0 || header.pixel_height == 0 || header.pixel_depth > 1 || header.layer_count > 1 || header.face_count != 1) {
+            std::cout << "KTX2: only single layer 2D textures are supported" << std::endl;
+            return {};
+        }
+
+        const uint32_t level_count = std::max(header.level_count, 1u);
+        if (bytes.size() < sizeof(Ktx2Header) + level_count * sizeof(Ktx2Level)) {
+            return {};
+        }
+        std::vector<Ktx2Level> levels(level_count);
+        memcpy(levels.data(), bytes.data() + sizeof(Ktx2Header), level_count * sizeof(Ktx2Level));
+        for (const Ktx2Level& level : levels) {
+            if (level.byte_offset + level.byte_length > bytes.size()) {
+                return {};
+            }
+        }
+
+        const VkFormat format = static_cast<VkFormat>(header.vk_format);
+        if (header.supercompression_scheme == SUPERCOMPRESSION_BASIS_LZ || (format == VK_FORMAT_UNDEFINED && header.supercompression_scheme == SUPERCOMPRESSION_NONE)) {
+            std::cout << "KTX2: Basis Universal payloads are not supported" << std::endl;
+            return {};
+        }
+        if (header.supercompression_scheme != SUPERCOMPRESSION_NONE) {
+            std::cout << "KTX2: supercompression scheme " << header.supercompression_scheme << " is not supported" << std::endl;
+            return {};
+        }
+        if (block_size(format) == 0) {
+            std::cout << "KTX2: vkFormat " << header.vk_format << " is not a supported block format" << std::endl;
+            return {};
+        }
+
+        CompressedTexture texture {
+            .format = format,
+            .width = header.pixel_width,
+            .height = header.pixel_height,
+        };
+        // A level count of zero asks the loader to generate mips, which block formats cannot be blitted into.
+        uint64_t total_size = 0;
+        for (uint32_t level = 0; level < level_count; level++) {
+            const uint64_t expected = level_size(format, std::max(header.pixel_width >> level, 1u), std::max(header.pixel_height >> level, 1u));
+            if (levels[level].byte_length < expected) {
+                return {};
+            }
+            texture.level_offsets.push_back(total_size);
+            total_size += expected;
+        }
+        texture.data.resize(total_size);
+        for (uint32_t level = 0; level < level_count; level++) {
+            const uint64_t size = (level + 1 < level_count ? texture.level_offsets[level + 1] : total_size) - texture.level_offsets[level];
+            memcpy(texture.data.data() + texture.level_offsets[level], bytes.data() + levels[level].byte_offset, size);
+        }
+        return texture;
+    }
+
+    std::vector<uint8_t> write_ktx2(const CompressedTexture& texture) {
+        const std::vector<uint32_t> dfd = basic_dfd(texture.format);
+        if (dfd.empty() || texture.level_offsets.empty()) {
+            return {};
+        }
+
+        const uint32_t level_count = static_cast<uint32_t>(texture.level_offsets.size());
+        const uint64_t dfd_offset = sizeof(Ktx2Header) + level_count * sizeof(Ktx2Level);
+        const uint64_t dfd_size = dfd.size() * sizeof(uint32_t);
+        Ktx2Header header {
+            .vk_format = static_cast<uint32_t>(texture.format),
+            .type_size = 1,
+            .pixel_width = texture.width,
+            .pixel_height = texture.height,
+            .face_count = 1,
+            .level_count = level_count,
+            .supercompression_scheme = SUPERCOMPRESSION_NONE,
+            .dfd_byte_offset = static_cast<uint32_t>(dfd_offset),
+            .dfd_byte_length = static_cast<uint32_t>(dfd_size),
+        };
+        memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+
+        // Level data is stored smallest first, each level aligned to the block size.
+        const uint64_t alignment = block_size(texture.format);
+        std::vector<Ktx2Level> levels(level_count);
+        uint64_t offset = dfd_offset + dfd_size;
+        for (uint32_t level = level_count; level-- > 0;) {
+            const uint64_t size = (level + 1 < level_count ? texture.level_offsets[level + 1] : texture.data.size()) - texture.level_offsets[level];
+            offset = (offset + alignment - 1) / alignment * alignment;
+            levels[level] = Ktx2Level { .byte_offset = offset, .byte_length = size, .uncompressed_byte_length = size };
+            offset += size;
+        }
+
+        std::vector<uint8_t> bytes(offset);
+        memcpy(bytes.data(), &header, sizeof(header));
+        memcpy(bytes.data() + sizeof(header), levels.data(), level_count * sizeof(Ktx2Level));
+        memcpy(bytes.data() + dfd_offset, dfd.data(), dfd_size);
+        for (uint32_t level = 0; level < level_count; level++) {
+            memcpy(bytes.data() + levels[level].byte_offset, texture.data.data() + texture.level_offsets[level], levels[level].byte_length);
+        }
+        return bytes;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Posideon {
+    // Block compressed texture with its whole mip chain, levels packed back to back from the largest.
+    struct CompressedTexture {
+        std::string name;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint64_t> level_offsets;
+        std::vector<uint8_t> data;
+        // Upload only the mip tail and stream the rest in from shader feedback. Only set for textures some
+        // draw reports feedback for, anything else would stay at its tail.
+        bool streamed = false;
+    };
+
+    // Bytes per 4x4 block, zero for formats that are not block compressed.
+    [[nodiscard]] uint32_t block_size(VkFormat format);
+    [[nodiscard]] bool is_ktx2(std::span<const uint8_t> bytes);
+
+    // Accepts BC1/BC3/BC4/BC5/BC7 payloads without supercompression, they are uploaded as stored. Basis
+    // Universal payloads (BasisLZ, or UASTC with an undefined vkFormat) need a transcoder that is not part of
+    // the tree and are rejected, as are Zstandard and ZLIB supercompression.
+    [[nodiscard]] std::optional<CompressedTexture> load_ktx2(std::span<const uint8_t> bytes);
+    // Serialises a BC4/BC5/BC7 texture with a basic data format descriptor and no supercompression.
+    [[nodiscard]] std::vector<uint8_t> write_ktx2(const CompressedTexture& texture);
+}
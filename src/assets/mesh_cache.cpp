@@ -0,0 +1,173 @@
+#include "mesh_cache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <system_error>
+
+#include "assets/asset_cache.h"
+
+namespace Posideon {
+    namespace {
+        constexpr uint32_t MESH_CACHE_MAGIC = 0x48534d50; // "PMSH"
+        constexpr uint32_t MESH_CACHE_VERSION = 6;
+
+        struct MeshCacheHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t source_size;
+            int64_t source_time;
+            uint32_t mesh_count;
+            uint32_t node_count;
+        };
+
+        std::optional<MeshCacheHeader> source_header(const std::filesystem::path& source) {
+            std::error_code error;
+            const uint64_t size = std::filesystem::file_size(source, error);
+            if (error) {
+                return {};
+            }
+            const auto time = std::filesystem::last_write_time(source, error);
+            if (error) {
+                return {};
+            }
+            return MeshCacheHeader {
+                .magic = MESH_CACHE_MAGIC,
+                .version = MESH_CACHE_VERSION,
+                .source_size = size,
+                .source_time = static_cast<int64_t>(time.time_since_epoch().count()),
+                .mesh_count = 0,
+                .node_count = 0
+            };
+        }
+
+        template<typename T>
+        void write_value(std::ofstream& file, const T& value) {
+            file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template<typename T>
+        void write_array(std::ofstream& file, const std::vector<T>& values) {
+            write_value(file, static_cast<uint64_t>(values.size()));
+            file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+        }
+
+        template<typename T>
+        bool read_value(std::ifstream& file, T& value) {
+            return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+        }
+
+        uint64_t remaining_bytes(std::ifstream& file) {
+            const std::streampos position = file.tellg();
+            file.seekg(0, std::ios::end);
+            const std::streampos end = file.tellg();
+            file.seekg(position);
+            return position < 0 || end < position ? 0 : static_cast<uint64_t>(end - position);
+        }
+
+        // The count comes from the file, so it is checked against what is left before anything is allocated.
+        template<typename T>
+        bool read_array(std::ifstream& file, std::vector<T>& values) {
+            uint64_t count = 0;
+            if (!read_value(file, count) || count > remaining_bytes(file) / sizeof(T)) {
+                return false;
+            }
+            values.resize(count);
+            return static_cast<bool>(file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(T))));
+        }
+    }
+
+    std::filesystem::path mesh_cache_path(const std::filesystem::path& source) {
+        std::error_code error;
+        const std::string canonical = std::filesystem::weakly_canonical(source, error).generic_string();
+        const uint64_t hash = fnv1a(std::span(reinterpret_cast<const uint8_t*>(canonical.data()), canonical.size()));
+
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), ".%016llx.meshcache", static_cast<unsigned long long>(hash));
+        std::filesystem::path path = asset_cache_directory("meshes") / source.filename();
+        path += suffix;
+        return path;
+    }
+
+    std::optional<BakedScene> load_mesh_cache(const std::filesystem::path& source) {
+        const std::optional<MeshCacheHeader> expected = source_header(source);
+        if (!expected) {
+            return {};
+        }
+
+        std::ifstream file(mesh_cache_path(source), std::ios::binary);
+        if (!file.is_open()) {
+            return {};
+        }
+
+        MeshCacheHeader header {};
+        if (!read_value(file, header) || header.magic != expected->magic || header.version != expected->version ||
+            header.source_size != expected->source_size || header.source_time != expected->source_time) {
+            return {};
+        }
+        // Every mesh and node record starts with at least one array count.
+        if (static_cast<uint64_t>(header.mesh_count) + header.node_count > remaining_bytes(file) / sizeof(uint64_t)) {
+            return {};
+        }
+
+        BakedScene scene;
+        scene.meshes.resize(header.mesh_count);
+        for (BakedMesh& mesh : scene.meshes) {
+            std::vector<char> name;
+            if (!read_array(file, name) || !read_array(file, mesh.surfaces) || !read_array(file, mesh.vertices) ||
+                !read_array(file, mesh.indices) || !read_array(file, mesh.meshlets.meshlets) || !read_array(file, mesh.meshlets.vertices) ||
+                !read_array(file, mesh.meshlets.triangles) || !read_array(file, mesh.surface_lods) || !read_array(file, mesh.lods) ||
+                !read_value(file, mesh.image)) {
+                return {};
+            }
+            mesh.name.assign(name.begin(), name.end());
+        }
+
+        scene.nodes.resize(header.node_count);
+        for (BakedNode& node : scene.nodes) {
+            std::vector<char> name;
+            if (!read_array(file, name) || !read_value(file, node.parent) || !read_value(file, node.mesh) || !read_value(file, node.local)) {
+                return {};
+            }
+            node.name.assign(name.begin(), name.end());
+        }
+        return scene;
+    }
+
+    bool save_mesh_cache(const std::filesystem::path& source, const BakedScene& scene) {
+        std::optional<MeshCacheHeader> header = source_header(source);
+        if (!header) {
+            return false;
+        }
+        header->mesh_count = static_cast<uint32_t>(scene.meshes.size());
+        header->node_count = static_cast<uint32_t>(scene.nodes.size());
+
+        const std::filesystem::path path = mesh_cache_path(source);
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        write_value(file, *header);
+        for (const BakedMesh& mesh : scene.meshes) {
+            write_array(file, std::vector<char>(mesh.name.begin(), mesh.name.end()));
+            write_array(file, mesh.surfaces);
+            write_array(file, mesh.vertices);
+            write_array(file, mesh.indices);
+            write_array(file, mesh.meshlets.meshlets);
+            write_array(file, mesh.meshlets.vertices);
+            write_array(file, mesh.meshlets.triangles);
+            write_array(file, mesh.surface_lods);
+            write_array(file, mesh.lods);
+            write_value(file, mesh.image);
+        }
+        for (const BakedNode& node : scene.nodes) {
+            write_array(file, std::vector<char>(node.name.begin(), node.name.end()));
+            write_value(file, node.parent);
+            write_value(file, node.mesh);
+            write_value(file, node.local);
+        }
+        return static_cast<bool>(file);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "assets/mesh_optimizer.h"
+#include "assets/meshlet_builder.h"
+#include "assets/mesh_simplifier.h"
+
+namespace Posideon {
+    // Import output for a single glTF mesh after optimisation, ready for compression and upload.
+    struct BakedMesh {
+        std::string name;
+        std::vector<MeshSurface> surfaces;
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        MeshletData meshlets;
+        std::vector<SurfaceLods> surface_lods;
+        std::vector<MeshLod> lods;
+        // Index of gltf_mesh_image in the file's images, -1 when the mesh has no base colour texture.
+        int32_t image = -1;
+    };
+
+    // A node of the default glTF scene, ordered so that parents always come before their children.
+    struct BakedNode {
+        std::string name;
+        int32_t parent = -1;
+        int32_t mesh = -1;
+        glm::mat4 local { 1.0f };
+    };
+
+    struct BakedScene {
+        std::vector<BakedMesh> meshes;
+        std::vector<BakedNode> nodes;
+    };
+
+    // The cache lives in the mesh cache directory under the source's file name and a hash of its path, and
+    // is invalidated when the source size, modification time or the cache format version changes.
+    [[nodiscard]] std::filesystem::path mesh_cache_path(const std::filesystem::path& source);
+    [[nodiscard]] std::optional<BakedScene> load_mesh_cache(const std::filesystem::path& source);
+    bool save_mesh_cache(const std::filesystem::path& source, const BakedScene& scene);
+}
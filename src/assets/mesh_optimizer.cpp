@@ -0,0 +1,342 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace Posideon {
+    namespace {
+        constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+
+        struct CacheSimulation {
+            uint32_t misses = 0;
+            uint32_t unique_vertices = 0;
+        };
+
+        CacheSimulation simulate_fifo_cache(std::span<const uint32_t> indices, uint32_t cache_size) {
+            CacheSimulation result;
+            std::unordered_map<uint32_t, uint32_t> inserted_at;
+            uint32_t timestamp = 0;
+            for (const uint32_t index : indices) {
+                const auto it = inserted_at.find(index);
+                if (it == inserted_at.end()) {
+                    result.unique_vertices++;
+                }
+                if (it == inserted_at.end() || timestamp - it->second >= cache_size) {
+                    inserted_at[index] = timestamp++;
+                    result.misses++;
+                }
+            }
+            return result;
+        }
+
+        float forsyth_vertex_score(int32_t cache_position, uint32_t live_triangles) {
+            if (live_triangles == 0) {
+                return -1.0f;
+            }
+
+            float score = 0.0f;
+            if (cache_position >= 0) {
+                if (cache_position < 3) {
+                    score = 0.75f;
+                } else {
+                    const float scale = 1.0f / static_cast<float>(FORSYTH_CACHE_SIZE - 3);
+                    score = std::pow(1.0f - static_cast<float>(cache_position - 3) * scale, 1.5f);
+                }
+            }
+            return score + 2.0f / std::sqrt(static_cast<float>(live_triangles));
+        }
+
+        struct VertexHash {
+            size_t operator()(const Vertex& vertex) const {
+                const auto* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+                size_t hash = 14695981039346656037ull;
+                for (size_t i = 0; i < sizeof(Vertex); i++) {
+                    hash = (hash ^ bytes[i]) * 1099511628211ull;
+                }
+                return hash;
+            }
+        };
+
+        struct VertexEqual {
+            bool operator()(const Vertex& a, const Vertex& b) const {
+                return memcmp(&a, &b, sizeof(Vertex)) == 0;
+            }
+        };
+    }
+
+    VertexCacheStats analyze_vertex_cache(const std::vector<uint32_t>& indices, const std::vector<MeshSurface>& surfaces, uint32_t cache_size) {
+        uint64_t misses = 0;
+        uint64_t unique_vertices = 0;
+        for (const MeshSurface& surface : surfaces) {
+            const CacheSimulation simulation = simulate_fifo_cache(std::span(indices).subspan(surface.start_index, surface.count), cache_size);
+            misses += simulation.misses;
+            unique_vertices += simulation.unique_vertices;
+        }
+
+        VertexCacheStats stats;
+        if (indices.size() >= 3) {
+            stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+        }
+        if (unique_vertices > 0) {
+            stats.atvr = static_cast<float>(misses) / static_cast<float>(unique_vertices);
+        }
+        return stats;
+    }
+
+    void deduplicate_vertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+        std::unordered_map<Vertex, uint32_t, VertexHash, VertexEqual> unique;
+        unique.reserve(vertices.size());
+        std::vector<uint32_t> remap(vertices.size());
+        std::vector<Vertex> deduplicated;
+        deduplicated.reserve(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            const auto [it, inserted] = unique.try_emplace(vertices[i], static_cast<uint32_t>(deduplicated.size()));
+            if (inserted) {
+                deduplicated.push_back(vertices[i]);
+            }
+            remap[i] = it->second;
+        }
+
+        for (uint32_t& index : indices) {
+            index = remap[index];
+        }
+        vertices = std::move(deduplicated);
+    }
+
+    // Forsyth's linear-speed vertex cache optimisation: greedily emit the highest scoring triangle among
+    // those touching the simulated LRU cache, falling back to the next unemitted triangle in input order.
+    std::vector<uint32_t> optimize_vertex_cache(std::span<const uint32_t> indices, size_t vertex_count) {
+        const size_t triangle_count = indices.size() / 3;
+
+        std::vector<uint32_t> live_triangles(vertex_count, 0);
+        for (const uint32_t index : indices) {
+            live_triangles[index]++;
+        }
+
+        std::vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+        for (size_t v = 0; v < vertex_count; v++) {
+            adjacency_offsets[v + 1] = adjacency_offsets[v] + live_triangles[v];
+        }
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> cursor(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for (size_t t = 0; t < triangle_count; t++) {
+                for (size_t k = 0; k < 3; k++) {
+                    adjacency[cursor[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+                }
+            }
+        }
+
+        std::vector<int32_t> cache_position(vertex_count, -1);
+        std::vector<float> vertex_score(vertex_count);
+        for (size_t v = 0; v < vertex_count; v++) {
+            vertex_score[v] = forsyth_vertex_score(-1, live_triangles[v]);
+        }
+
+        std::vector<bool> emitted(triangle_count, false);
+        std::vector<uint32_t> cache;
+        std::vector<uint32_t> new_cache;
+        cache.reserve(FORSYTH_CACHE_SIZE + 3);
+        new_cache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+        std::vector<uint32_t> result;
+        result.reserve(triangle_count * 3);
+        size_t input_cursor = 0;
+        int64_t best_triangle = -1;
+        while (result.size() < triangle_count * 3) {
+            if (best_triangle < 0) {
+                while (emitted[input_cursor]) {
+                    input_cursor++;
+                }
+                best_triangle = static_cast<int64_t>(input_cursor);
+            }
+
+            const size_t t = static_cast<size_t>(best_triangle);
+            emitted[t] = true;
+            const uint32_t triangle[3] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] };
+            new_cache.clear();
+            for (const uint32_t v : triangle) {
+                result.push_back(v);
+
+                const uint32_t begin = adjacency_offsets[v];
+                const uint32_t end = begin + live_triangles[v];
+                const auto it = std::find(adjacency.begin() + begin, adjacency.begin() + end, static_cast<uint32_t>(t));
+                if (it != adjacency.begin() + end) {
+                    std::iter_swap(it, adjacency.begin() + end - 1);
+                    live_triangles[v]--;
+                }
+
+                if (std::find(new_cache.begin(), new_cache.end(), v) == new_cache.end()) {
+                    new_cache.push_back(v);
+                }
+            }
+            for (const uint32_t v : cache) {
+                if (std::find(new_cache.begin(), new_cache.end(), v) == new_cache.end()) {
+                    new_cache.push_back(v);
+                }
+            }
+
+            for (size_t i = 0; i < new_cache.size(); i++) {
+                const uint32_t v = new_cache[i];
+                cache_position[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+                vertex_score[v] = forsyth_vertex_score(cache_position[v], live_triangles[v]);
+            }
+
+            best_triangle = -1;
+            float best_score = std::numeric_limits<float>::lowest();
+            for (const uint32_t v : new_cache) {
+                const uint32_t begin = adjacency_offsets[v];
+                for (uint32_t i = begin; i < begin + live_triangles[v]; i++) {
+                    const uint32_t candidate = adjacency[i];
+                    const float score = vertex_score[indices[candidate * 3]] + vertex_score[indices[candidate * 3 + 1]] + vertex_score[indices[candidate * 3 + 2]];
+                    if (score > best_score) {
+                        best_score = score;
+                        best_triangle = candidate;
+                    }
+                }
+            }
+
+            cache.assign(new_cache.begin(), new_cache.begin() + std::min<size_t>(new_cache.size(), FORSYTH_CACHE_SIZE));
+        }
+
+        return result;
+    }
+
+    // Splits the cache optimised order into clusters at hard cache boundaries, then sorts clusters so that
+    // those facing away from the mesh centre, which tend to occlude the rest, are drawn first.
+    std::vector<uint32_t> optimize_overdraw(std::span<const uint32_t> indices, std::span<const Vertex> vertices, uint32_t cache_size, float threshold) {
+        const size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0) {
+            return { indices.begin(), indices.end() };
+        }
+
+        std::vector<size_t> cluster_starts;
+        {
+            std::unordered_map<uint32_t, uint32_t> inserted_at;
+            uint32_t timestamp = 0;
+            for (size_t t = 0; t < triangle_count; t++) {
+                uint32_t triangle_misses = 0;
+                for (size_t k = 0; k < 3; k++) {
+                    const uint32_t index = indices[t * 3 + k];
+                    const auto it = inserted_at.find(index);
+                    if (it == inserted_at.end() || timestamp - it->second >= cache_size) {
+                        inserted_at[index] = timestamp++;
+                        triangle_misses++;
+                    }
+                }
+                if (t == 0 || triangle_misses == 3) {
+                    cluster_starts.push_back(t);
+                }
+            }
+        }
+
+        glm::vec3 mesh_centroid(0.0f);
+        for (const Vertex& vertex : vertices) {
+            mesh_centroid += vertex.position;
+        }
+        mesh_centroid /= static_cast<float>(std::max<size_t>(vertices.size(), 1));
+
+        struct Cluster {
+            size_t first_triangle;
+            size_t triangle_count;
+            float sort_key;
+        };
+        std::vector<Cluster> clusters;
+        clusters.reserve(cluster_starts.size());
+        for (size_t c = 0; c < cluster_starts.size(); c++) {
+            const size_t first = cluster_starts[c];
+            const size_t last = c + 1 < cluster_starts.size() ? cluster_starts[c + 1] : triangle_count;
+
+            glm::vec3 centroid(0.0f);
+            glm::vec3 normal(0.0f);
+            float area = 0.0f;
+            for (size_t t = first; t < last; t++) {
+                const glm::vec3 p0 = vertices[indices[t * 3]].position;
+                const glm::vec3 p1 = vertices[indices[t * 3 + 1]].position;
+                const glm::vec3 p2 = vertices[indices[t * 3 + 2]].position;
+                const glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+                const float triangle_area = glm::length(cross);
+                centroid += (p0 + p1 + p2) * (triangle_area / 3.0f);
+                normal += cross;
+                area += triangle_area;
+            }
+
+            float sort_key = 0.0f;
+            const float normal_length = glm::length(normal);
+            if (area > 0.0f && normal_length > 0.0f) {
+                sort_key = glm::dot(centroid / area - mesh_centroid, normal / normal_length);
+            }
+            clusters.push_back(Cluster { first, last - first, sort_key });
+        }
+
+        std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+            return a.sort_key > b.sort_key;
+        });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for (const Cluster& cluster : clusters) {
+            const auto first = indices.begin() + cluster.first_triangle * 3;
+            result.insert(result.end(), first, first + cluster.triangle_count * 3);
+        }
+
+        const float original_misses = static_cast<float>(simulate_fifo_cache(indices, cache_size).misses);
+        const float sorted_misses = static_cast<float>(simulate_fifo_cache(result, cache_size).misses);
+        if (sorted_misses > original_misses * threshold) {
+            return { indices.begin(), indices.end() };
+        }
+        return result;
+    }
+
+    void optimize_vertex_fetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+        constexpr uint32_t unassigned = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> remap(vertices.size(), unassigned);
+        std::vector<Vertex> reordered;
+        reordered.reserve(vertices.size());
+        for (uint32_t& index : indices) {
+            if (remap[index] == unassigned) {
+                remap[index] = static_cast<uint32_t>(reordered.size());
+                reordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices = std::move(reordered);
+    }
+
+    MeshOptimizationStats optimize_mesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshSurface>& surfaces, const MeshOptimizationSettings& settings) {
+        MeshOptimizationStats stats;
+        stats.before = analyze_vertex_cache(indices, surfaces, settings.analysis_cache_size);
+        stats.vertices_before = static_cast<uint32_t>(vertices.size());
+
+        std::vector<Vertex> optimized_vertices;
+        std::vector<uint32_t> optimized_indices;
+        optimized_vertices.reserve(vertices.size());
+        optimized_indices.reserve(indices.size());
+        for (size_t s = 0; s < surfaces.size(); s++) {
+            MeshSurface& surface = surfaces[s];
+            const size_t vertex_end = s + 1 < surfaces.size() ? surfaces[s + 1].first_vertex : vertices.size();
+
+            std::vector<Vertex> surface_vertices(vertices.begin() + surface.first_vertex, vertices.begin() + vertex_end);
+            std::vector<uint32_t> surface_indices(indices.begin() + surface.start_index, indices.begin() + surface.start_index + surface.count);
+
+            deduplicate_vertices(surface_vertices, surface_indices);
+            surface_indices = optimize_vertex_cache(surface_indices, surface_vertices.size());
+            surface_indices = optimize_overdraw(surface_indices, surface_vertices, settings.analysis_cache_size, settings.overdraw_threshold);
+            optimize_vertex_fetch(surface_vertices, surface_indices);
+
+            surface.start_index = static_cast<uint32_t>(optimized_indices.size());
+            surface.first_vertex = static_cast<uint32_t>(optimized_vertices.size());
+            optimized_indices.insert(optimized_indices.end(), surface_indices.begin(), surface_indices.end());
+            optimized_vertices.insert(optimized_vertices.end(), surface_vertices.begin(), surface_vertices.end());
+        }
+        vertices = std::move(optimized_vertices);
+        indices = std::move(optimized_indices);
+
+        stats.after = analyze_vertex_cache(indices, surfaces, settings.analysis_cache_size);
+        stats.vertices_after = static_cast<uint32_t>(vertices.size());
+        return stats;
+    }
+}
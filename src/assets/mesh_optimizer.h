@@ -0,0 +1,39 @@
+#pragma once
+
+#include "defines.h"
+#include <span>
+#include <vector>
+
+#include "graphics/vulkan/vulkan_types.h"
+
+namespace Posideon {
+    // ACMR is transformed vertices per triangle, ATVR is transformed vertices per unique vertex. Both are
+    // measured with a FIFO cache simulation, ATVR of 1.0 is optimal.
+    struct VertexCacheStats {
+        float acmr = 0.0f;
+        float atvr = 0.0f;
+    };
+
+    struct MeshOptimizationStats {
+        VertexCacheStats before;
+        VertexCacheStats after;
+        uint32_t vertices_before = 0;
+        uint32_t vertices_after = 0;
+    };
+
+    struct MeshOptimizationSettings {
+        uint32_t analysis_cache_size = 16;
+        // Overdraw ordering is kept only while it costs less than this factor of the cache optimized ACMR.
+        float overdraw_threshold = 1.05f;
+    };
+
+    [[nodiscard]] VertexCacheStats analyze_vertex_cache(const std::vector<uint32_t>& indices, const std::vector<MeshSurface>& surfaces, uint32_t cache_size);
+
+    void deduplicate_vertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+    [[nodiscard]] std::vector<uint32_t> optimize_vertex_cache(std::span<const uint32_t> indices, size_t vertex_count);
+    [[nodiscard]] std::vector<uint32_t> optimize_overdraw(std::span<const uint32_t> indices, std::span<const Vertex> vertices, uint32_t cache_size, float threshold);
+    void optimize_vertex_fetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    // Runs every stage on each surface independently so surfaces keep their own vertex ranges.
+    MeshOptimizationStats optimize_mesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshSurface>& surfaces, const MeshOptimizationSettings& settings = {});
+}
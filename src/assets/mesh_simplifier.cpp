@@ -0,0 +1,155 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "assets/mesh_optimizer.h"
+
+namespace Posideon {
+    namespace {
+        struct ClusteredMesh {
+            std::vector<uint32_t> indices;
+            float error = 0.0f;
+        };
+
+        // Snaps every vertex to the most central vertex of its grid cell, so the result still indexes the
+        // original vertices, then drops collapsed and duplicated triangles.
+        ClusteredMesh cluster_vertices(std::span<const Vertex> vertices, std::span<const uint32_t> indices, glm::vec3 origin, float cell_size) {
+            const auto cell_key = [&](glm::vec3 position) {
+                const glm::vec3 cell = glm::floor((position - origin) / cell_size);
+                return (static_cast<uint64_t>(cell.x) & 0x1fffff) | ((static_cast<uint64_t>(cell.y) & 0x1fffff) << 21) | ((static_cast<uint64_t>(cell.z) & 0x1fffff) << 42);
+            };
+
+            std::unordered_map<uint64_t, uint32_t> cluster_ids;
+            std::vector<uint32_t> vertex_cluster(vertices.size(), std::numeric_limits<uint32_t>::max());
+            std::vector<glm::vec3> cluster_sum;
+            std::vector<uint32_t> cluster_count;
+            for (const uint32_t index : indices) {
+                if (vertex_cluster[index] != std::numeric_limits<uint32_t>::max()) {
+                    continue;
+                }
+                const auto [it, inserted] = cluster_ids.try_emplace(cell_key(vertices[index].position), static_cast<uint32_t>(cluster_sum.size()));
+                if (inserted) {
+                    cluster_sum.emplace_back(0.0f);
+                    cluster_count.push_back(0);
+                }
+                vertex_cluster[index] = it->second;
+                cluster_sum[it->second] += vertices[index].position;
+                cluster_count[it->second]++;
+            }
+
+            std::vector<uint32_t> representative(cluster_sum.size(), std::numeric_limits<uint32_t>::max());
+            std::vector<float> representative_distance(cluster_sum.size(), std::numeric_limits<float>::max());
+            for (uint32_t v = 0; v < vertices.size(); v++) {
+                const uint32_t cluster = vertex_cluster[v];
+                if (cluster == std::numeric_limits<uint32_t>::max()) {
+                    continue;
+                }
+                const glm::vec3 mean = cluster_sum[cluster] / static_cast<float>(cluster_count[cluster]);
+                const float distance = glm::length(vertices[v].position - mean);
+                if (distance < representative_distance[cluster]) {
+                    representative_distance[cluster] = distance;
+                    representative[cluster] = v;
+                }
+            }
+
+            ClusteredMesh result;
+            for (uint32_t v = 0; v < vertices.size(); v++) {
+                if (vertex_cluster[v] != std::numeric_limits<uint32_t>::max()) {
+                    const uint32_t target = representative[vertex_cluster[v]];
+                    result.error = std::max(result.error, glm::length(vertices[v].position - vertices[target].position));
+                }
+            }
+
+            std::unordered_set<uint64_t> emitted;
+            for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+                uint32_t triangle[3];
+                for (size_t k = 0; k < 3; k++) {
+                    triangle[k] = representative[vertex_cluster[indices[i + k]]];
+                }
+                if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2]) {
+                    continue;
+                }
+
+                uint32_t sorted[3] = { triangle[0], triangle[1], triangle[2] };
+                std::sort(sorted, sorted + 3);
+                const uint64_t key = static_cast<uint64_t>(sorted[0]) * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(sorted[1]) << 21 ^ static_cast<uint64_t>(sorted[2]) << 42;
+                if (emitted.insert(key).second) {
+                    result.indices.insert(result.indices.end(), triangle, triangle + 3);
+                }
+            }
+            return result;
+        }
+    }
+
+    void build_lod_chains(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<MeshSurface>& surfaces,
+        std::vector<SurfaceLods>& surface_lods, std::vector<MeshLod>& lods, const LodSettings& settings) {
+        surface_lods.clear();
+        lods.clear();
+
+        for (size_t s = 0; s < surfaces.size(); s++) {
+            const MeshSurface& surface = surfaces[s];
+            const size_t vertex_end = s + 1 < surfaces.size() ? surfaces[s + 1].first_vertex : vertices.size();
+            const std::span<const Vertex> surface_vertices(vertices.data() + surface.first_vertex, vertex_end - surface.first_vertex);
+            const std::vector<uint32_t> surface_indices(indices.begin() + surface.start_index, indices.begin() + surface.start_index + surface.count);
+
+            glm::vec3 min(std::numeric_limits<float>::max());
+            glm::vec3 max(std::numeric_limits<float>::lowest());
+            for (const uint32_t index : surface_indices) {
+                min = glm::min(min, surface_vertices[index].position);
+                max = glm::max(max, surface_vertices[index].position);
+            }
+
+            SurfaceLods chain {
+                .center = surface_indices.empty() ? glm::vec3(0.0f) : (min + max) * 0.5f,
+                .radius = surface_indices.empty() ? 0.0f : glm::length(max - min) * 0.5f,
+                .lod_offset = static_cast<uint32_t>(lods.size()),
+                .lod_count = 0,
+            };
+
+            const float extent = surface_indices.empty() ? 0.0f : std::max({ max.x - min.x, max.y - min.y, max.z - min.z });
+            size_t triangle_count = surface_indices.size() / 3;
+            while (chain.lod_count < settings.max_lods && extent > 0.0f) {
+                const size_t target = static_cast<size_t>(static_cast<float>(triangle_count) * settings.triangle_ratio);
+                if (target < settings.min_triangles) {
+                    break;
+                }
+
+                // Triangle count falls as cells grow, so search for the finest grid that reaches the target.
+                float low = 0.0f;
+                float high = extent;
+                ClusteredMesh best = cluster_vertices(surface_vertices, surface_indices, min, high);
+                for (uint32_t iteration = 0; iteration < 12; iteration++) {
+                    const float cell_size = (low + high) * 0.5f;
+                    ClusteredMesh candidate = cluster_vertices(surface_vertices, surface_indices, min, cell_size);
+                    if (candidate.indices.size() / 3 <= target) {
+                        high = cell_size;
+                        best = std::move(candidate);
+                    } else {
+                        low = cell_size;
+                    }
+                }
+
+                const size_t simplified_count = best.indices.size() / 3;
+                if (simplified_count == 0 || simplified_count > triangle_count * 9 / 10) {
+                    break;
+                }
+
+                const std::vector<uint32_t> optimized = optimize_vertex_cache(best.indices, surface_vertices.size());
+                lods.push_back(MeshLod {
+                    .start_index = static_cast<uint32_t>(indices.size()),
+                    .count = static_cast<uint32_t>(optimized.size()),
+                    .error = best.error,
+                });
+                indices.insert(indices.end(), optimized.begin(), optimized.end());
+                chain.lod_count++;
+                triangle_count = simplified_count;
+            }
+
+            surface_lods.push_back(chain);
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "defines.h"
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "graphics/vulkan/vulkan_types.h"
+
+namespace Posideon {
+    // A simplified index range of a surface. Indices are relative to the surface's first vertex, so every
+    // level shares the surface's vertices. error is the largest distance, in model units, that any vertex
+    // moved relative to the full detail surface.
+    struct MeshLod {
+        uint32_t start_index;
+        uint32_t count;
+        float error;
+    };
+
+    // Level 0 is the surface itself, levels 1..lod_count live at lods[lod_offset + level - 1].
+    struct SurfaceLods {
+        glm::vec3 center;
+        float radius;
+        uint32_t lod_offset;
+        uint32_t lod_count;
+    };
+
+    struct LodSettings {
+        uint32_t max_lods = 4;
+        float triangle_ratio = 0.5f;
+        uint32_t min_triangles = 32;
+    };
+
+    // Simplifies each surface by vertex clustering. New index ranges are appended to indices.
+    void build_lod_chains(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<MeshSurface>& surfaces,
+        std::vector<SurfaceLods>& surface_lods, std::vector<MeshLod>& lods, const LodSettings& settings = {});
+}
@@ -0,0 +1,120 @@
+#include "meshlet_builder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Posideon {
+    static void compute_meshlet_bounds(Meshlet& meshlet, const MeshletData& data, const std::vector<Vertex>& vertices) {
+        glm::vec3 min(std::numeric_limits<float>::max());
+        glm::vec3 max(std::numeric_limits<float>::lowest());
+        for (uint32_t i = 0; i < meshlet.vertex_count; i++) {
+            const glm::vec3 position = vertices[data.vertices[meshlet.vertex_offset + i]].position;
+            min = glm::min(min, position);
+            max = glm::max(max, position);
+        }
+        meshlet.center = (min + max) * 0.5f;
+        meshlet.radius = 0.0f;
+        for (uint32_t i = 0; i < meshlet.vertex_count; i++) {
+            const glm::vec3 position = vertices[data.vertices[meshlet.vertex_offset + i]].position;
+            meshlet.radius = std::max(meshlet.radius, glm::length(position - meshlet.center));
+        }
+
+        std::vector<glm::vec3> normals;
+        normals.reserve(meshlet.triangle_count);
+        glm::vec3 axis(0.0f);
+        for (uint32_t t = 0; t < meshlet.triangle_count; t++) {
+            const uint32_t packed = data.triangles[meshlet.triangle_offset + t];
+            const glm::vec3 p0 = vertices[data.vertices[meshlet.vertex_offset + (packed & 0xff)]].position;
+            const glm::vec3 p1 = vertices[data.vertices[meshlet.vertex_offset + ((packed >> 8) & 0xff)]].position;
+            const glm::vec3 p2 = vertices[data.vertices[meshlet.vertex_offset + ((packed >> 16) & 0xff)]].position;
+            const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            const float length = glm::length(normal);
+            if (length > 0.0f) {
+                normals.push_back(normal / length);
+                axis += normal / length;
+            }
+        }
+
+        // A cutoff of 1 can never satisfy the back facing test, which disables cone culling for the meshlet.
+        meshlet.cone_axis = glm::vec3(0.0f, 0.0f, 1.0f);
+        meshlet.cone_cutoff = 1.0f;
+        const float axis_length = glm::length(axis);
+        if (normals.empty() || axis_length == 0.0f) {
+            return;
+        }
+        axis /= axis_length;
+
+        float min_dot = 1.0f;
+        for (const glm::vec3& normal : normals) {
+            min_dot = std::min(min_dot, glm::dot(normal, axis));
+        }
+        if (min_dot <= 0.1f) {
+            return;
+        }
+        meshlet.cone_axis = axis;
+        meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+    }
+
+    MeshletData build_meshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, std::vector<MeshSurface>& surfaces) {
+        MeshletData data;
+        std::vector<int32_t> local_index(vertices.size(), -1);
+
+        for (MeshSurface& surface : surfaces) {
+            surface.meshlet_offset = static_cast<uint32_t>(data.meshlets.size());
+
+            Meshlet meshlet {};
+            const auto finish_meshlet = [&] {
+                if (meshlet.triangle_count == 0) {
+                    return;
+                }
+                for (uint32_t i = 0; i < meshlet.vertex_count; i++) {
+                    local_index[data.vertices[meshlet.vertex_offset + i]] = -1;
+                }
+                compute_meshlet_bounds(meshlet, data, vertices);
+                data.meshlets.push_back(meshlet);
+                meshlet = Meshlet {
+                    .vertex_offset = static_cast<uint32_t>(data.vertices.size()),
+                    .triangle_offset = static_cast<uint32_t>(data.triangles.size()),
+                };
+            };
+            meshlet.vertex_offset = static_cast<uint32_t>(data.vertices.size());
+            meshlet.triangle_offset = static_cast<uint32_t>(data.triangles.size());
+
+            for (uint32_t i = 0; i + 2 < surface.count; i += 3) {
+                const uint32_t triangle[3] = {
+                    surface.first_vertex + indices[surface.start_index + i],
+                    surface.first_vertex + indices[surface.start_index + i + 1],
+                    surface.first_vertex + indices[surface.start_index + i + 2]
+                };
+
+                uint32_t new_vertices = 0;
+                for (uint32_t k = 0; k < 3; k++) {
+                    const bool repeated = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+                    if (local_index[triangle[k]] < 0 && !repeated) {
+                        new_vertices++;
+                    }
+                }
+                if (meshlet.vertex_count + new_vertices > MAX_MESHLET_VERTICES || meshlet.triangle_count + 1 > MAX_MESHLET_TRIANGLES) {
+                    finish_meshlet();
+                }
+
+                uint32_t packed = 0;
+                for (uint32_t k = 0; k < 3; k++) {
+                    if (local_index[triangle[k]] < 0) {
+                        local_index[triangle[k]] = static_cast<int32_t>(meshlet.vertex_count++);
+                        data.vertices.push_back(triangle[k]);
+                    }
+                    packed |= static_cast<uint32_t>(local_index[triangle[k]]) << (k * 8);
+                }
+                data.triangles.push_back(packed);
+                meshlet.triangle_count++;
+            }
+            finish_meshlet();
+
+            surface.meshlet_count = static_cast<uint32_t>(data.meshlets.size()) - surface.meshlet_offset;
+        }
+
+        return data;
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "defines.h"
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "graphics/vulkan/vulkan_types.h"
+
+namespace Posideon {
+    static constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+    static constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+    // Matches the std430 layout read by meshlet_cull.comp and meshlet.mesh. The cone is stored in its
+    // sphere-relative form: a meshlet is back facing when
+    // dot(center - camera, cone_axis) >= cone_cutoff * length(center - camera) + radius.
+    struct Meshlet {
+        glm::vec3 center;
+        float radius;
+        glm::vec3 cone_axis;
+        float cone_cutoff;
+        uint32_t vertex_offset;
+        uint32_t triangle_offset;
+        uint32_t vertex_count;
+        uint32_t triangle_count;
+    };
+    static_assert(sizeof(Meshlet) == 48);
+
+    // vertices holds mesh-local vertex indices, triangles holds three 8 bit meshlet-local indices per entry.
+    struct MeshletData {
+        std::vector<Meshlet> meshlets;
+        std::vector<uint32_t> vertices;
+        std::vector<uint32_t> triangles;
+    };
+
+    // Splits every surface into meshlets in index order and records each surface's meshlet range.
+    [[nodiscard]] MeshletData build_meshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, std::vector<MeshSurface>& surfaces);
+}
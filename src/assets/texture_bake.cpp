@@ -0,0 +1,87 @@
+#include "texture_bake.h"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "assets/asset_cache.h"
+#include "assets/texture_loader.h"
+
+namespace Posideon {
+    namespace {
+        // Bumped whenever the encoders or the mip filter change output.
+        constexpr uint64_t TEXTURE_BAKE_VERSION = 1;
+
+        std::optional<std::vector<uint8_t>> read_file(const std::filesystem::path& path) {
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file.is_open()) {
+                return {};
+            }
+            std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            if (!file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+                return {};
+            }
+            return bytes;
+        }
+    }
+
+    TextureCompression texture_compression(TextureUsage usage) {
+        switch (usage) {
+            case TextureUsage::Normal: return TextureCompression::BC5;
+            case TextureUsage::SingleChannel: return TextureCompression::BC4;
+            default: return TextureCompression::BC7;
+        }
+    }
+
+    std::filesystem::path texture_cache_directory() {
+        return asset_cache_directory("textures");
+    }
+
+    std::filesystem::path baked_texture_path(const std::filesystem::path& cache_directory, std::span<const uint8_t> source, TextureUsage usage) {
+        const uint64_t key[2] = { TEXTURE_BAKE_VERSION, static_cast<uint64_t>(usage) };
+        const uint64_t hash = fnv1a(std::span(reinterpret_cast<const uint8_t*>(key), sizeof(key)), fnv1a(source));
+
+        char name[24];
+        snprintf(name, sizeof(name), "%016llx.ktx2", static_cast<unsigned long long>(hash));
+        return cache_directory / name;
+    }
+
+    std::optional<CompressedTexture> bake_texture(std::span<const uint8_t> source, TextureUsage usage, const std::filesystem::path& cache_directory, JobSystem& jobs) {
+        const std::filesystem::path path = baked_texture_path(cache_directory, source, usage);
+        if (const std::optional<std::vector<uint8_t>> cached = read_file(path)) {
+            if (std::optional<CompressedTexture> texture = load_ktx2(*cached)) {
+                return texture;
+            }
+        }
+
+        std::optional<TextureImage> image = decode_image(source, usage == TextureUsage::Color);
+        if (!image) {
+            return {};
+        }
+        CompressedTexture texture = compress_texture(*image, texture_compression(usage), jobs);
+
+        // Written to a per-thread temporary name first so a concurrent or interrupted bake never leaves a torn file
+        // behind. Identical images in one file, or in two files loaded at once, bake the same hash in parallel.
+        const std::vector<uint8_t> bytes = write_ktx2(texture);
+        std::error_code error;
+        std::filesystem::create_directories(cache_directory, error);
+        std::filesystem::path temporary = path;
+        temporary += "." + std::to_string(std::hash<std::thread::id> {}(std::this_thread::get_id())) + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            if (!file) {
+                std::cout << "Failed to write baked texture " << path << std::endl;
+                return texture;
+            }
+        }
+        std::filesystem::rename(temporary, path, error);
+        return texture;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+#include "assets/ktx2_loader.h"
+#include "assets/texture_compressor.h"
+
+namespace Posideon {
+    class JobSystem;
+
+    // How a texture is sampled decides its block format. Data covers packed material channels such as
+    // metallic-roughness, SingleChannel maps that are only read through red, such as occlusion.
+    enum class TextureUsage : uint8_t {
+        Color,
+        Normal,
+        Data,
+        SingleChannel
+    };
+
+    // Color is BC7 sRGB, Normal is BC5 with z reconstructed on sampling, Data is BC7 linear and
+    // SingleChannel is BC4 of the red channel.
+    [[nodiscard]] TextureCompression texture_compression(TextureUsage usage);
+
+    // Baked textures of every asset share one cache directory, each named by a hash of the encoded source
+    // bytes, the usage and the bake format version.
+    [[nodiscard]] std::filesystem::path texture_cache_directory();
+    [[nodiscard]] std::filesystem::path baked_texture_path(const std::filesystem::path& cache_directory, std::span<const uint8_t> source, TextureUsage usage);
+
+    // Loads the baked KTX2 for source when it is cached, otherwise decodes, compresses and writes it.
+    [[nodiscard]] std::optional<CompressedTexture> bake_texture(std::span<const uint8_t> source, TextureUsage usage, const std::filesystem::path& cache_directory, JobSystem& jobs);
+}
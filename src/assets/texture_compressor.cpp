@@ -0,0 +1,333 @@
+#include "texture_compressor.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include "core/job_system.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define POSIDEON_COMPRESSOR_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Posideon {
+    namespace {
+        constexpr std::array<uint32_t, 16> BC7_WEIGHTS_4 = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        struct BitWriter {
+            uint8_t* data;
+            uint32_t position = 0;
+
+            void write(uint32_t value, uint32_t bits) {
+                for (uint32_t i = 0; i < bits; i++, position++) {
+                    if ((value >> i) & 1u) {
+                        data[position >> 3] |= static_cast<uint8_t>(1u << (position & 7));
+                    }
+                }
+            }
+        };
+
+        // Splits an endpoint into 7 bit channels and a shared parity bit, choosing the parity that loses least.
+        void quantize_endpoint(const float* endpoint, uint32_t* quantized, uint32_t& parity) {
+            float best_error = 1e30f;
+            for (uint32_t p = 0; p < 2; p++) {
+                float error = 0.0f;
+                uint32_t candidate[4];
+                for (uint32_t c = 0; c < 4; c++) {
+                    candidate[c] = static_cast<uint32_t>(std::clamp(std::lround((endpoint[c] - static_cast<float>(p)) * 0.5f), 0l, 127l));
+                    const float reconstructed = static_cast<float>(candidate[c] * 2 + p);
+                    error += (reconstructed - endpoint[c]) * (reconstructed - endpoint[c]);
+                }
+                if (error < best_error) {
+                    best_error = error;
+                    parity = p;
+                    memcpy(quantized, candidate, sizeof(candidate));
+                }
+            }
+        }
+
+        // Nearest palette step along e0 -> e1 for every pixel, by projection onto the endpoint axis.
+        void project_indices(const float (&channels)[4][16], const float* e0, const float* e1, uint32_t* indices) {
+            float axis[4];
+            float length_squared = 0.0f;
+            for (uint32_t c = 0; c < 4; c++) {
+                axis[c] = e1[c] - e0[c];
+                length_squared += axis[c] * axis[c];
+            }
+            if (length_squared < 1e-6f) {
+                std::fill_n(indices, 16, 0u);
+                return;
+            }
+            const float scale = 15.0f / length_squared;
+#if defined(POSIDEON_COMPRESSOR_SSE)
+            for (uint32_t i = 0; i < 16; i += 4) {
+                __m128 t = _mm_setzero_ps();
+                for (uint32_t c = 0; c < 4; c++) {
+                    const __m128 offset = _mm_sub_ps(_mm_loadu_ps(&channels[c][i]), _mm_set1_ps(e0[c]));
+                    t = _mm_add_ps(t, _mm_mul_ps(offset, _mm_set1_ps(axis[c] * scale)));
+                }
+                t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(15.0f));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(indices + i), _mm_cvtps_epi32(t));
+            }
+#else
+            for (uint32_t i = 0; i < 16; i++) {
+                float t = 0.0f;
+                for (uint32_t c = 0; c < 4; c++) {
+                    t += (channels[c][i] - e0[c]) * axis[c] * scale;
+                }
+                indices[i] = static_cast<uint32_t>(std::lround(std::clamp(t, 0.0f, 15.0f)));
+            }
+#endif
+        }
+
+        float srgb_to_linear(float value) {
+            return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+        }
+
+        float linear_to_srgb(float value) {
+            return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+        }
+
+        TextureImage downsample(const TextureImage& source, const std::array<float, 256>& to_linear) {
+            TextureImage level {
+                .width = std::max(source.width / 2, 1u),
+                .height = std::max(source.height / 2, 1u),
+                .srgb = source.srgb,
+            };
+            level.pixels.resize(static_cast<size_t>(level.width) * level.height * 4);
+            for (uint32_t y = 0; y < level.height; y++) {
+                for (uint32_t x = 0; x < level.width; x++) {
+                    const uint32_t x0 = std::min(x * 2, source.width - 1), x1 = std::min(x * 2 + 1, source.width - 1);
+                    const uint32_t y0 = std::min(y * 2, source.height - 1), y1 = std::min(y * 2 + 1, source.height - 1);
+                    const uint8_t* samples[4] = {
+                        &source.pixels[(static_cast<size_t>(y0) * source.width + x0) * 4],
+                        &source.pixels[(static_cast<size_t>(y0) * source.width + x1) * 4],
+                        &source.pixels[(static_cast<size_t>(y1) * source.width + x0) * 4],
+                        &source.pixels[(static_cast<size_t>(y1) * source.width + x1) * 4],
+                    };
+                    uint8_t* destination = &level.pixels[(static_cast<size_t>(y) * level.width + x) * 4];
+                    for (uint32_t c = 0; c < 4; c++) {
+                        const bool linearize = source.srgb && c < 3;
+                        float sum = 0.0f;
+                        for (const uint8_t* sample : samples) {
+                            sum += linearize ? to_linear[sample[c]] : static_cast<float>(sample[c]) / 255.0f;
+                        }
+                        const float average = linearize ? linear_to_srgb(sum * 0.25f) : sum * 0.25f;
+                        destination[c] = static_cast<uint8_t>(std::clamp(std::lround(average * 255.0f), 0l, 255l));
+                    }
+                }
+            }
+            return level;
+        }
+    }
+
+    VkFormat compressed_format(TextureCompression compression, bool srgb) {
+        switch (compression) {
+            case TextureCompression::BC7: return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+            case TextureCompression::BC5: return VK_FORMAT_BC5_UNORM_BLOCK;
+            case TextureCompression::BC4: return VK_FORMAT_BC4_UNORM_BLOCK;
+        }
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    void encode_bc7_block(const uint8_t* pixels, uint8_t* block) {
+        float channels[4][16];
+        float mean[4] = {};
+        for (uint32_t i = 0; i < 16; i++) {
+            for (uint32_t c = 0; c < 4; c++) {
+                channels[c][i] = pixels[i * 4 + c];
+                mean[c] += channels[c][i] / 16.0f;
+            }
+        }
+
+        // Principal axis of the block by power iteration on the covariance matrix.
+        float covariance[4][4] = {};
+        for (uint32_t i = 0; i < 16; i++) {
+            for (uint32_t a = 0; a < 4; a++) {
+                for (uint32_t b = 0; b < 4; b++) {
+                    covariance[a][b] += (channels[a][i] - mean[a]) * (channels[b][i] - mean[b]);
+                }
+            }
+        }
+        float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        for (uint32_t iteration = 0; iteration < 8; iteration++) {
+            float next[4] = {};
+            float length = 0.0f;
+            for (uint32_t a = 0; a < 4; a++) {
+                for (uint32_t b = 0; b < 4; b++) {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                length = std::max(length, std::abs(next[a]));
+            }
+            if (length < 1e-6f) {
+                break;
+            }
+            for (uint32_t a = 0; a < 4; a++) {
+                axis[a] = next[a] / length;
+            }
+        }
+        const float axis_length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3]);
+        for (float& value : axis) {
+            value /= axis_length;
+        }
+
+        float t_min = 0.0f, t_max = 0.0f;
+        for (uint32_t i = 0; i < 16; i++) {
+            float t = 0.0f;
+            for (uint32_t c = 0; c < 4; c++) {
+                t += (channels[c][i] - mean[c]) * axis[c];
+            }
+            t_min = std::min(t_min, t);
+            t_max = std::max(t_max, t);
+        }
+
+        float endpoints[2][4];
+        uint32_t quantized[2][4];
+        uint32_t parity[2];
+        for (uint32_t c = 0; c < 4; c++) {
+            endpoints[0][c] = std::clamp(mean[c] + axis[c] * t_min, 0.0f, 255.0f);
+            endpoints[1][c] = std::clamp(mean[c] + axis[c] * t_max, 0.0f, 255.0f);
+        }
+        quantize_endpoint(endpoints[0], quantized[0], parity[0]);
+        quantize_endpoint(endpoints[1], quantized[1], parity[1]);
+
+        float reconstructed[2][4];
+        for (uint32_t e = 0; e < 2; e++) {
+            for (uint32_t c = 0; c < 4; c++) {
+                reconstructed[e][c] = static_cast<float>(quantized[e][c] * 2 + parity[e]);
+            }
+        }
+        uint32_t indices[16];
+        project_indices(channels, reconstructed[0], reconstructed[1], indices);
+
+        // Projection rounds in a uniform space, the weights are not quite uniform, so check the neighbours.
+        for (uint32_t i = 0; i < 16; i++) {
+            float best_error = 1e30f;
+            const uint32_t first = indices[i] == 0 ? 0 : indices[i] - 1;
+            const uint32_t last = std::min(indices[i] + 1, 15u);
+            for (uint32_t candidate = first; candidate <= last; candidate++) {
+                const uint32_t weight = BC7_WEIGHTS_4[candidate];
+                float error = 0.0f;
+                for (uint32_t c = 0; c < 4; c++) {
+                    const uint32_t e0 = quantized[0][c] * 2 + parity[0];
+                    const uint32_t e1 = quantized[1][c] * 2 + parity[1];
+                    const float value = static_cast<float>(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+                    error += (value - channels[c][i]) * (value - channels[c][i]);
+                }
+                if (error < best_error) {
+                    best_error = error;
+                    indices[i] = candidate;
+                }
+            }
+        }
+
+        // The anchor index drops its top bit, so it must sit in the lower half of the palette.
+        if (indices[0] & 8u) {
+            std::swap(quantized[0], quantized[1]);
+            std::swap(parity[0], parity[1]);
+            for (uint32_t& index : indices) {
+                index = 15 - index;
+            }
+        }
+
+        memset(block, 0, 16);
+        BitWriter writer { block };
+        writer.write(1u << 6, 7);
+        for (uint32_t c = 0; c < 4; c++) {
+            writer.write(quantized[0][c], 7);
+            writer.write(quantized[1][c], 7);
+        }
+        writer.write(parity[0], 1);
+        writer.write(parity[1], 1);
+        writer.write(indices[0], 3);
+        for (uint32_t i = 1; i < 16; i++) {
+            writer.write(indices[i], 4);
+        }
+    }
+
+    void encode_bc4_block(const uint8_t* pixels, uint32_t channel, uint8_t* block) {
+        uint8_t low = 255, high = 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            low = std::min(low, pixels[i * 4 + channel]);
+            high = std::max(high, pixels[i * 4 + channel]);
+        }
+
+        memset(block, 0, 8);
+        block[0] = high;
+        block[1] = low;
+        if (high == low) {
+            return;
+        }
+
+        // With red0 > red1 the palette is red0, red1 and six steps between them, step k of 7 from low
+        // is index 1 for k = 0, index 0 for k = 7 and index 8 - k in between.
+        BitWriter writer { block, 16 };
+        const float scale = 7.0f / static_cast<float>(high - low);
+        for (uint32_t i = 0; i < 16; i++) {
+            const long step = std::lround(static_cast<float>(pixels[i * 4 + channel] - low) * scale);
+            const uint32_t index = step == 0 ? 1u : step == 7 ? 0u : static_cast<uint32_t>(8 - step);
+            writer.write(index, 3);
+        }
+    }
+
+    void encode_bc5_block(const uint8_t* pixels, uint8_t* block) {
+        encode_bc4_block(pixels, 0, block);
+        encode_bc4_block(pixels, 1, block + 8);
+    }
+
+    CompressedTexture compress_texture(const TextureImage& image, TextureCompression compression, JobSystem& jobs) {
+        std::array<float, 256> to_linear;
+        for (uint32_t i = 0; i < 256; i++) {
+            to_linear[i] = srgb_to_linear(static_cast<float>(i) / 255.0f);
+        }
+
+        const VkFormat format = compressed_format(compression, image.srgb);
+        CompressedTexture texture {
+            .name = image.name,
+            .format = format,
+            .width = image.width,
+            .height = image.height,
+        };
+
+        TextureImage level_image;
+        const TextureImage* level = &image;
+        while (true) {
+            const uint32_t blocks_x = (level->width + 3) / 4;
+            const uint32_t blocks_y = (level->height + 3) / 4;
+            const size_t offset = texture.data.size();
+            texture.level_offsets.push_back(offset);
+            texture.data.resize(offset + static_cast<size_t>(blocks_x) * blocks_y * block_size(format));
+
+            jobs.parallel_for(blocks_y, 4, [&](uint32_t begin, uint32_t end) {
+                uint8_t pixels[64];
+                for (uint32_t by = begin; by < end; by++) {
+                    for (uint32_t bx = 0; bx < blocks_x; bx++) {
+                        // Edge blocks repeat the last row and column.
+                        for (uint32_t y = 0; y < 4; y++) {
+                            for (uint32_t x = 0; x < 4; x++) {
+                                const uint32_t sx = std::min(bx * 4 + x, level->width - 1);
+                                const uint32_t sy = std::min(by * 4 + y, level->height - 1);
+                                memcpy(&pixels[(y * 4 + x) * 4], &level->pixels[(static_cast<size_t>(sy) * level->width + sx) * 4], 4);
+                            }
+                        }
+                        uint8_t* block = &texture.data[offset + (static_cast<size_t>(by) * blocks_x + bx) * block_size(format)];
+                        switch (compression) {
+                            case TextureCompression::BC7: encode_bc7_block(pixels, block); break;
+                            case TextureCompression::BC5: encode_bc5_block(pixels, block); break;
+                            case TextureCompression::BC4: encode_bc4_block(pixels, 0, block); break;
+                        }
+                    }
+                }
+            });
+
+            if (level->width == 1 && level->height == 1) {
+                break;
+            }
+            level_image = downsample(*level, to_linear);
+            level = &level_image;
+        }
+        return texture;
+    }
+}
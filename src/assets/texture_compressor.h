@@ -0,0 +1,31 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <vulkan/vulkan.hpp>
+
+#include "assets/ktx2_loader.h"
+#include "assets/texture_loader.h"
+
+namespace Posideon {
+    class JobSystem;
+
+    // BC7 for colour and packed material data, BC5 for two channel normal maps, BC4 for single channels.
+    enum class TextureCompression : uint8_t {
+        BC7,
+        BC5,
+        BC4
+    };
+
+    [[nodiscard]] VkFormat compressed_format(TextureCompression compression, bool srgb);
+
+    // Each takes a 4x4 block of RGBA8 pixels in row order. BC7 only emits mode 6, a single subset with
+    // 4 bit indices, which is fast to search and holds up well on everything but sharp multi-colour edges.
+    void encode_bc7_block(const uint8_t* pixels, uint8_t* block);
+    void encode_bc4_block(const uint8_t* pixels, uint32_t channel, uint8_t* block);
+    void encode_bc5_block(const uint8_t* pixels, uint8_t* block);
+
+    // Builds a box filtered mip chain down to 1x1 and compresses every level, block rows are spread over
+    // the job system. sRGB images are filtered in linear space.
+    [[nodiscard]] CompressedTexture compress_texture(const TextureImage& image, TextureCompression compression, JobSystem& jobs);
+}
@@ -0,0 +1,35 @@
+#include "texture_loader.h"
+
+#include <cstring>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+namespace Posideon {
+    static std::optional<TextureImage> take_pixels(stbi_uc* pixels, int width, int height, bool srgb) {
+        if (pixels == nullptr) {
+            return {};
+        }
+        TextureImage image {
+            .width = static_cast<uint32_t>(width),
+            .height = static_cast<uint32_t>(height),
+            .srgb = srgb,
+        };
+        image.pixels.resize(static_cast<size_t>(width) * height * 4);
+        memcpy(image.pixels.data(), pixels, image.pixels.size());
+        stbi_image_free(pixels);
+        return image;
+    }
+
+    std::optional<TextureImage> decode_image(std::span<const uint8_t> encoded, bool srgb) {
+        int width, height, channels;
+        stbi_uc* pixels = stbi_load_from_memory(encoded.data(), static_cast<int>(encoded.size()), &width, &height, &channels, STBI_rgb_alpha);
+        return take_pixels(pixels, width, height, srgb);
+    }
+
+    std::optional<TextureImage> decode_image_file(const std::filesystem::path& path, bool srgb) {
+        int width, height, channels;
+        stbi_uc* pixels = stbi_load(path.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
+        return take_pixels(pixels, width, height, srgb);
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace Posideon {
+    // Tightly packed RGBA8 pixels of the top mip level, ready for upload. The name is the texture cache key.
+    struct TextureImage {
+        std::string name;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        bool srgb = false;
+        std::vector<uint8_t> pixels;
+    };
+
+    // stb_image keeps no shared state while decoding, both are safe to call from worker threads.
+    [[nodiscard]] std::optional<TextureImage> decode_image(std::span<const uint8_t> encoded, bool srgb);
+    [[nodiscard]] std::optional<TextureImage> decode_image_file(const std::filesystem::path& path, bool srgb);
+}
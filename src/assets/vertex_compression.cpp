@@ -0,0 +1,71 @@
+#include "vertex_compression.h"
+
+#include <algorithm>
+#include <limits>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace Posideon {
+    static void compute_bounds(const std::vector<Vertex>& vertices, glm::vec3& min, glm::vec3& max) {
+        min = glm::vec3(std::numeric_limits<float>::max());
+        max = glm::vec3(std::numeric_limits<float>::lowest());
+        for (const Vertex& vertex : vertices) {
+            min = glm::min(min, vertex.position);
+            max = glm::max(max, vertex.position);
+        }
+    }
+
+    static glm::vec2 encode_octahedral(glm::vec3 normal) {
+        normal /= std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+        glm::vec2 encoded(normal.x, normal.y);
+        if (normal.z < 0.0f) {
+            encoded = (1.0f - glm::abs(glm::vec2(normal.y, normal.x))) *
+                glm::vec2(normal.x >= 0.0f ? 1.0f : -1.0f, normal.y >= 0.0f ? 1.0f : -1.0f);
+        }
+        return encoded;
+    }
+
+    static uint32_t pack_rgb565(glm::vec4 color) {
+        const glm::uvec3 rgb = glm::uvec3(glm::round(glm::clamp(glm::vec3(color), 0.0f, 1.0f) * glm::vec3(31.0f, 63.0f, 31.0f)));
+        return rgb.r << 11 | rgb.g << 5 | rgb.b;
+    }
+
+    bool can_compress_vertices(const std::vector<Vertex>& vertices, const VertexCompressionSettings& settings) {
+        if (vertices.empty()) {
+            return false;
+        }
+
+        glm::vec3 min, max;
+        compute_bounds(vertices, min, max);
+        const glm::vec3 extent = max - min;
+        const float step = std::max({ extent.x, extent.y, extent.z }) / 65535.0f;
+        if (step * 0.5f > settings.max_position_error) {
+            return false;
+        }
+
+        return std::all_of(vertices.begin(), vertices.end(), [&](const Vertex& vertex) {
+            return std::abs(vertex.uv_x) <= settings.max_uv && std::abs(vertex.uv_y) <= settings.max_uv;
+        });
+    }
+
+    CompressedVertices compress_vertices(const std::vector<Vertex>& vertices) {
+        glm::vec3 min, max;
+        compute_bounds(vertices, min, max);
+        const glm::vec3 extent = glm::max(max - min, glm::vec3(std::numeric_limits<float>::min()));
+
+        CompressedVertices compressed;
+        compressed.dequantization = glm::scale(glm::translate(glm::mat4(1.0f), min), extent);
+        compressed.vertices.reserve(vertices.size());
+        for (const Vertex& vertex : vertices) {
+            const glm::vec3 position = (vertex.position - min) / extent;
+            const glm::vec3 normal = glm::length(vertex.normal) > 0.0f ? glm::normalize(vertex.normal) : glm::vec3(0.0f, 0.0f, 1.0f);
+            compressed.vertices.emplace_back(CompactVertex {
+                .position_xy = glm::packUnorm2x16(glm::vec2(position.x, position.y)),
+                .position_z_color = glm::packUnorm1x16(position.z) | pack_rgb565(vertex.color) << 16,
+                .normal = glm::packSnorm2x16(encode_octahedral(normal)),
+                .uv = glm::packHalf2x16(glm::vec2(vertex.uv_x, vertex.uv_y)),
+            });
+        }
+        return compressed;
+    }
+}
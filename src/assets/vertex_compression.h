@@ -0,0 +1,26 @@
+#pragma once
+
+#include "defines.h"
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "graphics/vulkan/vulkan_types.h"
+
+namespace Posideon {
+    struct CompressedVertices {
+        std::vector<CompactVertex> vertices;
+        // Maps unorm positions back to model space, folded into the draw's world matrix.
+        glm::mat4 dequantization;
+    };
+
+    // max_position_error is absolute, in model units. Positions are quantized to 1/65535 of the mesh's
+    // largest extent, so meshes larger than 131070 * max_position_error (about 65 units by default) are
+    // kept at full precision. Raise it for large meshes that tolerate coarser positions.
+    struct VertexCompressionSettings {
+        float max_position_error = 0.0005f;
+        float max_uv = 2.0f;
+    };
+
+    [[nodiscard]] bool can_compress_vertices(const std::vector<Vertex>& vertices, const VertexCompressionSettings& settings);
+    [[nodiscard]] CompressedVertices compress_vertices(const std::vector<Vertex>& vertices);
+}
@@ -1,8 +1,15 @@
 #include "application.h"
+#include <thread>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "core/flecs_jobs.h"
+#include "scene/camera.h"
+#include "scene/gltf_scene.h"
+#include "scene/mesh_renderer.h"
+#include "scene/transform.h"
+
 namespace Posideon {
-    Application::Application() {
+    Application::Application(): m_world(create_world(m_jobs)), m_transforms(m_world), m_scene_bvh(m_world) {
         m_running = true;
     }
 
@@ -11,54 +18,50 @@ namespace Posideon {
         uint32_t height = 480;
 
         m_window = std::make_unique<Win32Window>(Win32Window(width, height));
-        m_renderer = std::make_unique<Renderer>(init_renderer(width, height, m_window.get()));
+        m_renderer = init_renderer(width, height, m_window.get(), m_jobs);
+        m_hot_reloader = std::make_unique<HotReloader>(*m_renderer, m_jobs, "../assets");
+
+        {
+            const float aspect_ratio = static_cast<float>(width) / static_cast<float>(height);
+            Camera camera { .projection = glm::perspective(glm::radians(70.0f), aspect_ratio, 10000.0f, 0.1f) };
+            camera.projection[1][1] *= -1;
+            m_world.entity()
+                .set<Camera>(camera)
+                .set<LocalTransform>(LocalTransform { .matrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 5.0f)) });
+        }
 
-        // Mesh mesh{
-        //     .vertices = {
-        //         { { -1.0f, -1.0f, -1.0f },  {0.0f, 0.0f, 1.0f, 1.0f} },
-        //         { { 1.0f, -1.0f, -1.0f },   {0.0f, 1.0f, 1.0f, 1.0f} },
-        //         { { 1.0f, 1.0f, -1.0f },    {0.0f, 1.0f, 0.0f, 1.0f} },
-        //         { { -1.0f, 1.0f, -1.0f },   {1.0f, 0.0f, 0.0f, 1.0f} },
-        //         { { -1.0f, -1.0f, 1.0f },   {1.0f, 0.0f, 1.0f, 1.0f} },
-        //         { { 1.0f, -1.0f, 1.0f },    {1.0f, 1.0f, 1.0f, 1.0f} },
-        //         { { 1.0f, 1.0f, 1.0f },     {1.0f, 1.0f, 0.0f, 1.0f} },
-        //         { { -1.0f, 1.0f, 1.0f },    {0.0f, 0.0f, 0.0f, 1.0f} }
-        //     },
-        //     .indices = {
-        //         0, 1, 3, 3, 1, 2,
-        //         1, 5, 2, 2, 5, 6,
-        //         5, 4, 6, 6, 4, 7,
-        //         4, 0, 7, 7, 0, 3,
-        //         3, 2, 7, 7, 2, 6,
-        //         4, 5, 0, 0, 5, 1
-        //     }
-        // };
-        //
-        // {
-        //     Transform transform { .model = glm::mat4(1.0f) };
-        //     auto entity = m_world.entity();
-        //     entity.set<Mesh>(mesh);
-        //     entity.set<Transform>(transform);
-        //     m_renderer->add_gpu_mesh(mesh);
-        // }
-        //
-        // {
-        //     float aspect_ratio = static_cast<float>(width) / static_cast<float>(height);
-        //     Transform transform { .model = glm::lookAt(glm::vec3(2.0f, -4.0f, 5.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)) };
-        //     Camera camera { .projection = glm::perspective(glm::radians(60.0f), aspect_ratio, 0.1f, 1000.0f) };
-        //     auto entity = m_world.entity();
-        //     entity.set<Camera>(camera);
-        //     entity.set<Transform>(transform);
-        // }
-        //
-        // transform_query = m_world.query<Transform>();
+        instantiate_gltf_scene(m_world, m_renderer->test_scene);
     }
 
     void Application::run() {
+        // The render thread records frame N from its snapshot while this thread simulates and extracts N + 1.
+        // Reloaded assets are swapped in between two frames, where nothing is being recorded.
+        std::thread render_thread([this] {
+            while (const RenderWorld* world = m_render_worlds.acquire()) {
+                m_hot_reloader->apply();
+                m_renderer->render(*world);
+                m_render_worlds.release();
+            }
+        });
+
         while (m_running) {
             m_window->run();
+            m_world.progress();
+            m_transforms.update(m_jobs);
+            m_hot_reloader->apply_bounds(m_world);
+            m_scene_bvh.update(m_world);
 
-            m_renderer->render();
+            extract_render_world(m_world, m_scene_bvh, m_render_worlds.begin_extract());
+            m_render_worlds.publish();
         }
+
+        m_render_worlds.close();
+        render_thread.join();
+        m_hot_reloader.reset();
+
+        // Assets referenced by the scene and the snapshots have to go before the renderer tears down the device.
+        m_world.remove_all<MeshRenderer>();
+        m_render_worlds.clear();
+        m_renderer->cleanup();
     }
 }
\ No newline at end of file
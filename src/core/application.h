@@ -3,14 +3,25 @@
 #include "defines.h"
 #include <memory>
 #include <flecs.h>
+#include "core/job_system.h"
 #include "window/win32/win32_window.h"
+#include "render/hot_reloader.h"
+#include "render/render_world.h"
 #include "render/renderer.h"
+#include "scene/scene_bvh.h"
+#include "scene/transform_hierarchy.h"
 
 namespace Posideon {
     class Application {
+        // Declared first so the renderer and the world are torn down before the workers stop.
+        JobSystem m_jobs;
         std::unique_ptr<Win32Window> m_window;
         std::unique_ptr<Renderer> m_renderer;
+        std::unique_ptr<HotReloader> m_hot_reloader;
         flecs::world m_world;
+        TransformHierarchy m_transforms;
+        SceneBvh m_scene_bvh;
+        RenderWorldBuffer m_render_worlds;
 
         bool m_running;
     public:
@@ -0,0 +1,169 @@
+#include "file_watcher.h"
+
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <system_error>
+
+#if defined(POSIDEON_PLATFORM_WINDOWS)
+#include <windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <unordered_map>
+#endif
+
+namespace Posideon {
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        constexpr std::chrono::milliseconds DEBOUNCE { 100 };
+        // How long a wait blocks before the thread checks for shutdown and flushes settled changes.
+        constexpr uint32_t POLL_INTERVAL_MS = 50;
+
+        struct PendingChanges {
+            std::set<std::filesystem::path> paths;
+            Clock::time_point last_change;
+
+            void add(std::filesystem::path path) {
+                paths.insert(std::move(path));
+                last_change = Clock::now();
+            }
+
+            void flush(const FileWatcher::Callback& callback) {
+                if (paths.empty() || Clock::now() - last_change < DEBOUNCE) {
+                    return;
+                }
+                callback(std::vector(paths.begin(), paths.end()));
+                paths.clear();
+            }
+        };
+    }
+
+    FileWatcher::FileWatcher(std::filesystem::path root, Callback callback): m_callback(std::move(callback)) {
+        std::error_code error;
+        m_root = std::filesystem::weakly_canonical(root, error);
+        if (error) {
+            m_root = std::move(root);
+        }
+        m_thread = std::thread([this] { watch(); });
+    }
+
+    FileWatcher::~FileWatcher() {
+        m_stop = true;
+        m_thread.join();
+    }
+
+#if defined(POSIDEON_PLATFORM_WINDOWS)
+    void FileWatcher::watch() {
+        HANDLE directory = CreateFileW(m_root.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (directory == INVALID_HANDLE_VALUE) {
+            std::cout << "Failed to watch " << m_root << std::endl;
+            return;
+        }
+
+        OVERLAPPED overlapped {};
+        overlapped.hEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        alignas(DWORD) std::byte buffer[16 * 1024];
+        constexpr DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME;
+
+        PendingChanges changes;
+        bool reading = false;
+        while (!m_stop) {
+            if (!reading) {
+                reading = ReadDirectoryChangesW(directory, buffer, sizeof(buffer), TRUE, filter, nullptr, &overlapped, nullptr);
+                if (!reading) {
+                    std::cout << "Stopped watching " << m_root << std::endl;
+                    break;
+                }
+            }
+
+            if (WaitForSingleObject(overlapped.hEvent, POLL_INTERVAL_MS) == WAIT_OBJECT_0) {
+                reading = false;
+                DWORD bytes = 0;
+                // Zero bytes means the buffer overflowed and the individual changes were lost.
+                if (GetOverlappedResult(directory, &overlapped, &bytes, FALSE) && bytes > 0) {
+                    size_t offset = 0;
+                    while (true) {
+                        const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer + offset);
+                        if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+                            changes.add(m_root / std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR)));
+                        }
+                        if (info->NextEntryOffset == 0) {
+                            break;
+                        }
+                        offset += info->NextEntryOffset;
+                    }
+                }
+            }
+            changes.flush(m_callback);
+        }
+
+        if (reading) {
+            DWORD bytes = 0;
+            CancelIoEx(directory, &overlapped);
+            GetOverlappedResult(directory, &overlapped, &bytes, TRUE);
+        }
+        CloseHandle(overlapped.hEvent);
+        CloseHandle(directory);
+    }
+#elif defined(__linux__)
+    void FileWatcher::watch() {
+        const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+            std::cout << "Failed to watch " << m_root << std::endl;
+            return;
+        }
+
+        // inotify is not recursive, every directory in the tree gets its own watch.
+        std::unordered_map<int, std::filesystem::path> directories;
+        const auto add_directory = [&](const std::filesystem::path& path) {
+            const int watch = inotify_add_watch(fd, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+            if (watch >= 0) {
+                directories[watch] = path;
+            }
+        };
+        add_directory(m_root);
+        std::error_code error;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(m_root, error)) {
+            if (entry.is_directory(error)) {
+                add_directory(entry.path());
+            }
+        }
+
+        PendingChanges changes;
+        alignas(inotify_event) char buffer[4096];
+        while (!m_stop) {
+            pollfd descriptor { .fd = fd, .events = POLLIN, .revents = 0 };
+            if (poll(&descriptor, 1, POLL_INTERVAL_MS) > 0) {
+                ssize_t length;
+                while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+                    for (const char* cursor = buffer; cursor < buffer + length;) {
+                        const auto* event = reinterpret_cast<const inotify_event*>(cursor);
+                        cursor += sizeof(inotify_event) + event->len;
+
+                        const auto directory = directories.find(event->wd);
+                        if (event->len == 0 || directory == directories.end()) {
+                            continue;
+                        }
+                        std::filesystem::path path = directory->second / event->name;
+                        if (event->mask & IN_ISDIR) {
+                            add_directory(path);
+                        } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                            changes.add(std::move(path));
+                        }
+                    }
+                }
+            }
+            changes.flush(m_callback);
+        }
+        close(fd);
+    }
+#else
+    void FileWatcher::watch() {
+        std::cout << "File watching is not supported on this platform, " << m_root << " will not be reloaded" << std::endl;
+    }
+#endif
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "defines.h"
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace Posideon {
+    // Watches a directory tree on its own thread, through inotify on Linux and ReadDirectoryChangesW on Windows.
+    // Changed files are collected until the tree has been quiet for a short while, so an editor saving through
+    // several writes reports the file once, and are then passed to the callback on the watcher thread.
+    class FileWatcher {
+    public:
+        using Callback = std::function<void(const std::vector<std::filesystem::path>& changed)>;
+
+    private:
+        std::filesystem::path m_root;
+        Callback m_callback;
+        std::atomic<bool> m_stop { false };
+        std::thread m_thread;
+
+        void watch();
+
+    public:
+        FileWatcher(std::filesystem::path root, Callback callback);
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+        // Joins the watcher thread, no callback runs after this returns.
+        ~FileWatcher();
+    };
+}
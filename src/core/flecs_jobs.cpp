@@ -0,0 +1,49 @@
+#include "flecs_jobs.h"
+
+#include "core/job_system.h"
+
+namespace Posideon {
+    namespace {
+        JobSystem* g_flecs_jobs = nullptr;
+
+        struct FlecsTask {
+            JobHandle job;
+            void* result = nullptr;
+        };
+
+        ecs_os_thread_t flecs_task_new(ecs_os_thread_callback_t callback, void* param) {
+            auto* task = new FlecsTask;
+            task->job = g_flecs_jobs->submit([task, callback, param] {
+                task->result = callback(param);
+            });
+            return reinterpret_cast<ecs_os_thread_t>(task);
+        }
+
+        void* flecs_task_join(ecs_os_thread_t thread) {
+            auto* task = reinterpret_cast<FlecsTask*>(thread);
+            g_flecs_jobs->wait(task->job);
+            void* result = task->result;
+            delete task;
+            return result;
+        }
+    }
+
+    void install_flecs_job_backend(JobSystem& jobs) {
+        g_flecs_jobs = &jobs;
+
+        ecs_os_set_api_defaults();
+        ecs_os_api_t api = ecs_os_api;
+        api.task_new_ = flecs_task_new;
+        api.task_join_ = flecs_task_join;
+        ecs_os_set_api(&api);
+    }
+
+    flecs::world create_world(JobSystem& jobs) {
+        install_flecs_job_backend(jobs);
+
+        flecs::world world;
+        // Tasks block on each other at pipeline sync points, so there must never be more of them than workers.
+        world.set_task_threads(static_cast<int32_t>(jobs.worker_count()));
+        return world;
+    }
+}
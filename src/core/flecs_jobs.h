@@ -0,0 +1,13 @@
+#pragma once
+
+#include "defines.h"
+#include <flecs.h>
+
+namespace Posideon {
+    class JobSystem;
+
+    // Routes flecs task threads through the job system instead of threads of their own. Has to be installed
+    // before the first world is created, the system must outlive every world.
+    void install_flecs_job_backend(JobSystem& jobs);
+    [[nodiscard]] flecs::world create_world(JobSystem& jobs);
+}
@@ -0,0 +1,266 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+namespace Posideon {
+    struct JobTask {
+        std::function<void()> function;
+        // Unfinished dependencies, plus one held by submit() until every dependency is registered.
+        std::atomic<uint32_t> pending { 1 };
+        std::atomic<bool> done { false };
+        // The parallel_for a chunk belongs to, the only jobs a waiting thread outside the pool may take.
+        const void* group = nullptr;
+        std::mutex mutex;
+        std::vector<JobHandle> continuations;
+    };
+
+    // Shared with every chunk job so a stolen chunk never outlives what it reads.
+    struct JobSystem::ParallelForState {
+        const std::function<void(uint32_t begin, uint32_t end)>* function;
+        uint32_t min_chunk;
+        std::atomic<uint32_t> remaining;
+    };
+
+    namespace {
+        constexpr uint32_t NOT_A_WORKER = ~0u;
+
+        thread_local JobSystem* t_system = nullptr;
+        thread_local uint32_t t_worker = NOT_A_WORKER;
+
+        bool matches(const JobHandle& job, const void* waited) {
+            return job.get() == waited || (job->group != nullptr && job->group == waited);
+        }
+    }
+
+    JobSystem::JobSystem(uint32_t worker_count) {
+        if (worker_count == 0) {
+            worker_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+        }
+        for (uint32_t i = 0; i < worker_count; i++) {
+            m_queues.push_back(std::make_unique<WorkerQueue>());
+        }
+        for (uint32_t i = 0; i < worker_count; i++) {
+            m_workers.emplace_back([this, i] { worker_main(i); });
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        m_stop = true;
+        wake_all();
+        for (std::thread& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    JobHandle JobSystem::submit(std::function<void()> job, std::span<const JobHandle> dependencies) {
+        JobHandle task = std::make_shared<JobTask>();
+        task->function = std::move(job);
+        task->pending = static_cast<uint32_t>(dependencies.size()) + 1;
+        for (const JobHandle& dependency : dependencies) {
+            const std::lock_guard lock(dependency->mutex);
+            if (dependency->done) {
+                task->pending--;
+            } else {
+                dependency->continuations.push_back(task);
+            }
+        }
+        if (--task->pending == 0) {
+            schedule(task);
+        }
+        return task;
+    }
+
+    void JobSystem::wait(const JobHandle& job) {
+        while (!job->done) {
+            if (!run_pending_job(job.get())) {
+                sleep_until([&] { return job->done || can_help(job.get()); });
+            }
+        }
+    }
+
+    bool JobSystem::is_done(const JobHandle& job) const {
+        return job->done;
+    }
+
+    void JobSystem::parallel_for(uint32_t count, uint32_t min_chunk, const std::function<void(uint32_t begin, uint32_t end)>& function) {
+        if (count == 0) {
+            return;
+        }
+
+        const auto state = std::make_shared<ParallelForState>();
+        state->function = &function;
+        state->min_chunk = std::max(min_chunk, 1u);
+        state->remaining = count;
+        run_range(state, 0, count);
+
+        while (state->remaining > 0) {
+            if (!run_pending_job(state.get())) {
+                sleep_until([&] { return state->remaining == 0 || can_help(state.get()); });
+            }
+        }
+    }
+
+    void JobSystem::run_range(const std::shared_ptr<ParallelForState>& state, uint32_t begin, uint32_t end) {
+        while (end - begin > state->min_chunk && local_queue_empty(state.get())) {
+            const uint32_t middle = begin + (end - begin) / 2;
+            JobHandle chunk = std::make_shared<JobTask>();
+            chunk->function = [this, state, middle, end] { run_range(state, middle, end); };
+            chunk->group = state.get();
+            chunk->pending = 0;
+            schedule(std::move(chunk));
+            end = middle;
+        }
+        (*state->function)(begin, end);
+        if (state->remaining.fetch_sub(end - begin) == end - begin) {
+            wake_all();
+        }
+    }
+
+    bool JobSystem::run_pending_job(const void* waited) {
+        JobHandle job = pop_job(waited);
+        if (!job) {
+            return false;
+        }
+        job->function();
+        finish(job);
+        return true;
+    }
+
+    void JobSystem::worker_main(uint32_t index) {
+        t_system = this;
+        t_worker = index;
+        while (!m_stop) {
+            if (!run_pending_job(nullptr)) {
+                sleep_until([&] { return m_stop || m_queued > 0; });
+            }
+        }
+    }
+
+    void JobSystem::schedule(JobHandle job) {
+        WorkerQueue& queue = t_system == this && t_worker != NOT_A_WORKER ? *m_queues[t_worker] : m_injection_queue;
+        {
+            const std::lock_guard lock(queue.mutex);
+            queue.jobs.push_back(std::move(job));
+            m_queued++;
+        }
+        // Threads outside the pool share the condition variable but may not be allowed to take this job, so a
+        // single notify could land on one of them and leave the job queued with every worker asleep.
+        wake_all();
+    }
+
+    void JobSystem::finish(const JobHandle& job) {
+        std::vector<JobHandle> continuations;
+        {
+            const std::lock_guard lock(job->mutex);
+            job->done = true;
+            continuations.swap(job->continuations);
+        }
+        job->function = nullptr;
+        for (JobHandle& continuation : continuations) {
+            if (--continuation->pending == 0) {
+                schedule(std::move(continuation));
+            }
+        }
+        wake_all();
+    }
+
+    JobHandle JobSystem::pop_job(const void* waited) {
+        if (m_queued == 0) {
+            return {};
+        }
+
+        const bool is_worker = t_system == this && t_worker != NOT_A_WORKER;
+        if (!is_worker) {
+            // Oldest first, like a steal. Queues are short, so a linear scan is cheaper than tracking owners.
+            const auto take_waited = [&](WorkerQueue& queue) -> JobHandle {
+                const std::lock_guard lock(queue.mutex);
+                const auto found = std::ranges::find_if(queue.jobs, [&](const JobHandle& job) { return matches(job, waited); });
+                if (found == queue.jobs.end()) {
+                    return {};
+                }
+                JobHandle job = std::move(*found);
+                queue.jobs.erase(found);
+                m_queued--;
+                return job;
+            };
+            if (JobHandle job = take_waited(m_injection_queue)) {
+                return job;
+            }
+            for (const std::unique_ptr<WorkerQueue>& queue : m_queues) {
+                if (JobHandle job = take_waited(*queue)) {
+                    return job;
+                }
+            }
+            return {};
+        }
+
+        const auto take = [&](WorkerQueue& queue, bool back) -> JobHandle {
+            const std::lock_guard lock(queue.mutex);
+            if (queue.jobs.empty()) {
+                return {};
+            }
+            JobHandle job;
+            if (back) {
+                job = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+            } else {
+                job = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+            }
+            m_queued--;
+            return job;
+        };
+
+        if (JobHandle job = take(*m_queues[t_worker], true)) {
+            return job;
+        }
+        if (JobHandle job = take(m_injection_queue, false)) {
+            return job;
+        }
+        const uint32_t start = t_worker + 1;
+        for (uint32_t i = 0; i < m_queues.size(); i++) {
+            if (JobHandle job = take(*m_queues[(start + i) % m_queues.size()], false)) {
+                return job;
+            }
+        }
+        return {};
+    }
+
+    bool JobSystem::can_help(const void* waited) {
+        if (m_queued == 0) {
+            return false;
+        }
+        if (t_system == this && t_worker != NOT_A_WORKER) {
+            return true;
+        }
+        const auto has_waited = [&](WorkerQueue& queue) {
+            const std::lock_guard lock(queue.mutex);
+            return std::ranges::any_of(queue.jobs, [&](const JobHandle& job) { return matches(job, waited); });
+        };
+        return has_waited(m_injection_queue) || std::ranges::any_of(m_queues, [&](const std::unique_ptr<WorkerQueue>& queue) { return has_waited(*queue); });
+    }
+
+    // Outside the pool only the range's own chunks count, unrelated jobs in the injection queue must not stop
+    // a parallel_for from splitting.
+    bool JobSystem::local_queue_empty(const void* group) {
+        if (t_system == this && t_worker != NOT_A_WORKER) {
+            const std::lock_guard lock(m_queues[t_worker]->mutex);
+            return m_queues[t_worker]->jobs.empty();
+        }
+        const std::lock_guard lock(m_injection_queue.mutex);
+        return std::ranges::none_of(m_injection_queue.jobs, [&](const JobHandle& job) { return job->group == group; });
+    }
+
+    void JobSystem::wake_all() {
+        {
+            const std::lock_guard lock(m_sleep_mutex);
+        }
+        m_condition.notify_all();
+    }
+
+    template<typename Predicate>
+    void JobSystem::sleep_until(Predicate&& predicate) {
+        std::unique_lock lock(m_sleep_mutex);
+        m_condition.wait(lock, predicate);
+    }
+}
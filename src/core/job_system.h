@@ -0,0 +1,74 @@
+#pragma once
+
+#include "defines.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace Posideon {
+    struct JobTask;
+    using JobHandle = std::shared_ptr<JobTask>;
+
+    // Work-stealing scheduler. Each worker owns a deque it pushes to and pops from at the back, idle workers
+    // steal from the front of the others. Threads outside the pool submit through a shared injection queue.
+    // Waiting from inside a job runs any queued job, so it never blocks a worker. A thread outside the pool
+    // only helps with what it waits for: the job itself, or the chunks of its own parallel_for. It never
+    // picks up flecs tasks that block at sync points or long background jobs submitted by other threads.
+    class JobSystem {
+        struct ParallelForState;
+
+        struct WorkerQueue {
+            std::mutex mutex;
+            std::deque<JobHandle> jobs;
+        };
+
+        std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+        WorkerQueue m_injection_queue;
+        std::vector<std::thread> m_workers;
+        std::atomic<uint32_t> m_queued { 0 };
+        std::atomic<bool> m_stop { false };
+        std::mutex m_sleep_mutex;
+        std::condition_variable m_condition;
+
+        void worker_main(uint32_t index);
+        void run_range(const std::shared_ptr<ParallelForState>& state, uint32_t begin, uint32_t end);
+        void schedule(JobHandle job);
+        void finish(const JobHandle& job);
+        // Runs one queued job on the calling thread, returns false when none was available. Outside the pool
+        // only the job or parallel_for chunks identified by waited are taken.
+        bool run_pending_job(const void* waited);
+        [[nodiscard]] JobHandle pop_job(const void* waited);
+        // Whether the calling thread could take a queued job while waiting for waited.
+        [[nodiscard]] bool can_help(const void* waited);
+        [[nodiscard]] bool local_queue_empty(const void* group);
+        void wake_all();
+        template<typename Predicate>
+        void sleep_until(Predicate&& predicate);
+
+    public:
+        // Zero picks one worker per hardware thread, minus the thread that owns the system.
+        explicit JobSystem(uint32_t worker_count = 0);
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+        ~JobSystem();
+
+        // The job runs once every dependency has finished.
+        JobHandle submit(std::function<void()> job, std::span<const JobHandle> dependencies = {});
+        void wait(const JobHandle& job);
+        [[nodiscard]] bool is_done(const JobHandle& job) const;
+
+        // Calls function over [begin, end) chunks covering [0, count). Ranges are split lazily, only while the
+        // local queue is empty, so chunks shrink towards min_chunk when other threads are stealing and stay
+        // large when they are not.
+        void parallel_for(uint32_t count, uint32_t min_chunk, const std::function<void(uint32_t begin, uint32_t end)>& function);
+
+        [[nodiscard]] uint32_t worker_count() const { return static_cast<uint32_t>(m_workers.size()); }
+    };
+}
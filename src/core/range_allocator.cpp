@@ -0,0 +1,89 @@
+#include "range_allocator.h"
+
+#include <algorithm>
+
+namespace Posideon {
+    RangeAllocator::RangeAllocator(uint64_t capacity): m_capacity(capacity) {
+        if (capacity > 0) {
+            m_free_ranges.emplace(0, capacity);
+        }
+    }
+
+    std::optional<uint64_t> RangeAllocator::allocate(uint64_t size, uint64_t alignment) {
+        if (size == 0) {
+            return {};
+        }
+
+        for (auto it = m_free_ranges.begin(); it != m_free_ranges.end(); ++it) {
+            const uint64_t range_offset = it->first;
+            const uint64_t range_size = it->second;
+            const uint64_t aligned = (range_offset + alignment - 1) / alignment * alignment;
+            if (aligned + size > range_offset + range_size) {
+                continue;
+            }
+
+            m_free_ranges.erase(it);
+            if (aligned > range_offset) {
+                m_free_ranges.emplace(range_offset, aligned - range_offset);
+            }
+            if (aligned + size < range_offset + range_size) {
+                m_free_ranges.emplace(aligned + size, range_offset + range_size - aligned - size);
+            }
+            m_used += size;
+            return aligned;
+        }
+
+        return {};
+    }
+
+    void RangeAllocator::free(uint64_t offset, uint64_t size) {
+        if (size == 0) {
+            return;
+        }
+        POSIDEON_ASSERT(offset + size <= m_capacity)
+        m_used -= size;
+        insert_free_range(offset, size);
+    }
+
+    void RangeAllocator::grow(uint64_t new_capacity) {
+        if (new_capacity <= m_capacity) {
+            return;
+        }
+        const uint64_t old_capacity = m_capacity;
+        m_capacity = new_capacity;
+        insert_free_range(old_capacity, new_capacity - old_capacity);
+    }
+
+    void RangeAllocator::insert_free_range(uint64_t offset, uint64_t size) {
+        auto next = m_free_ranges.lower_bound(offset);
+        if (next != m_free_ranges.begin()) {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset) {
+                offset = previous->first;
+                size += previous->second;
+                m_free_ranges.erase(previous);
+            }
+        }
+        if (next != m_free_ranges.end() && offset + size == next->first) {
+            size += next->second;
+            m_free_ranges.erase(next);
+        }
+        m_free_ranges.emplace(offset, size);
+    }
+
+    uint64_t RangeAllocator::largest_free_range() const {
+        uint64_t largest = 0;
+        for (const auto& [offset, size] : m_free_ranges) {
+            largest = std::max(largest, size);
+        }
+        return largest;
+    }
+
+    float RangeAllocator::fragmentation() const {
+        const uint64_t free_bytes = m_capacity - m_used;
+        if (free_bytes == 0) {
+            return 0.0f;
+        }
+        return 1.0f - static_cast<float>(largest_free_range()) / static_cast<float>(free_bytes);
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <map>
+#include <optional>
+
+namespace Posideon {
+    // First-fit free-list allocator over an abstract [0, capacity) range. Neighbouring free ranges are
+    // coalesced on free, and alignment may be any non-zero value (e.g. a 48 byte vertex stride).
+    class RangeAllocator {
+        std::map<uint64_t, uint64_t> m_free_ranges;
+        uint64_t m_capacity = 0;
+        uint64_t m_used = 0;
+
+        void insert_free_range(uint64_t offset, uint64_t size);
+
+    public:
+        RangeAllocator() = default;
+        explicit RangeAllocator(uint64_t capacity);
+
+        [[nodiscard]] std::optional<uint64_t> allocate(uint64_t size, uint64_t alignment);
+        void free(uint64_t offset, uint64_t size);
+        void grow(uint64_t new_capacity);
+
+        [[nodiscard]] uint64_t capacity() const { return m_capacity; }
+        [[nodiscard]] uint64_t used() const { return m_used; }
+        [[nodiscard]] uint64_t largest_free_range() const;
+        [[nodiscard]] float fragmentation() const;
+    };
+}
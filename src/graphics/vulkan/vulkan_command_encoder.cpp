@@ -1,6 +1,24 @@
 #include "vulkan_command_encoder.h"
+#include "vulkan_debug.h"
+
+#include <algorithm>
+#include <cstring>
 
 namespace Posideon {
+    static PFN_vkCmdDrawMeshTasksIndirectEXT draw_mesh_tasks_indirect_fn = nullptr;
+
+    void load_mesh_shader_functions(VkInstance instance) {
+        draw_mesh_tasks_indirect_fn = reinterpret_cast<PFN_vkCmdDrawMeshTasksIndirectEXT>(vkGetInstanceProcAddr(instance, "vkCmdDrawMeshTasksIndirectEXT"));
+    }
+
+    ScopedDebugLabel::ScopedDebugLabel(VkCommandBuffer buffer, const char* name): m_buffer(buffer) {
+        begin_debug_label(m_buffer, name);
+    }
+
+    ScopedDebugLabel::~ScopedDebugLabel() {
+        end_debug_label(m_buffer);
+    }
+
     void VulkanCommandEncoder::reset() const {
         vkResetCommandBuffer(m_buffer, 0);
     }
@@ -12,6 +30,43 @@ namespace Posideon {
         };
         const VkResult res = vkBeginCommandBuffer(m_buffer, &begin_info);
         POSIDEON_ASSERT(res == VK_SUCCESS)
+        invalidate_state();
+        m_stats = {};
+    }
+
+    void VulkanCommandEncoder::begin_secondary(VkFormat color_format, VkFormat depth_format) const {
+        const VkCommandBufferInheritanceRenderingInfo rendering_info {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+            .colorAttachmentCount = 1,
+            .pColorAttachmentFormats = &color_format,
+            .depthAttachmentFormat = depth_format,
+            .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT
+        };
+        const VkCommandBufferInheritanceInfo inheritance_info {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+            .pNext = &rendering_info
+        };
+        const VkCommandBufferBeginInfo begin_info {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+            .pInheritanceInfo = &inheritance_info
+        };
+        const VkResult res = vkBeginCommandBuffer(m_buffer, &begin_info);
+        POSIDEON_ASSERT(res == VK_SUCCESS)
+        invalidate_state();
+        m_stats = {};
+    }
+
+    void VulkanCommandEncoder::begin_label(const char* name) const {
+        begin_debug_label(m_buffer, name);
+    }
+
+    void VulkanCommandEncoder::end_label() const {
+        end_debug_label(m_buffer);
+    }
+
+    ScopedDebugLabel VulkanCommandEncoder::scoped_label(const char* name) const {
+        return { m_buffer, name };
     }
 
     void VulkanCommandEncoder::transition_image(VkImage image, VkImageLayout current_layout, VkImageLayout new_layout) const {
@@ -28,7 +83,7 @@ namespace Posideon {
            .subresourceRange = {
                .aspectMask = static_cast<VkImageAspectFlags>(aspect_mask),
                .baseMipLevel = 0,
-               .levelCount = 1,
+               .levelCount = VK_REMAINING_MIP_LEVELS,
                .baseArrayLayer = 0,
                .layerCount = 1,
            },
@@ -43,9 +98,28 @@ namespace Posideon {
         vkCmdPipelineBarrier2(m_buffer, &dependency_info);
     }
 
-    void VulkanCommandEncoder::start_rendering(VkRect2D render_area, const std::vector<VkRenderingAttachmentInfo>& attachments, const VkRenderingAttachmentInfo* depth_attachment, const VkRenderingAttachmentInfo* stencil_attachment) const {
+    void VulkanCommandEncoder::memory_barrier(VkPipelineStageFlags2 src_stage, VkAccessFlags2 src_access, VkPipelineStageFlags2 dst_stage, VkAccessFlags2 dst_access) const {
+        const VkMemoryBarrier2 memory_barrier {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .srcStageMask = src_stage,
+            .srcAccessMask = src_access,
+            .dstStageMask = dst_stage,
+            .dstAccessMask = dst_access,
+        };
+
+        const VkDependencyInfo dependency_info {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .memoryBarrierCount = 1,
+            .pMemoryBarriers = &memory_barrier,
+        };
+
+        vkCmdPipelineBarrier2(m_buffer, &dependency_info);
+    }
+
+    void VulkanCommandEncoder::start_rendering(VkRect2D render_area, const std::vector<VkRenderingAttachmentInfo>& attachments, const VkRenderingAttachmentInfo* depth_attachment, const VkRenderingAttachmentInfo* stencil_attachment, VkRenderingFlags flags) const {
         const VkRenderingInfo rendering_info {
             .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+            .flags = flags,
             .renderArea = render_area,
             .layerCount = 1,
             .colorAttachmentCount = static_cast<uint32_t>(attachments.size()),
@@ -82,7 +156,16 @@ namespace Posideon {
     }
 
     void VulkanCommandEncoder::bind_pipeline(VkPipelineBindPoint bind_point, VkPipeline pipeline) const {
+        VkPipeline& bound = bind_point == VK_PIPELINE_BIND_POINT_COMPUTE ? m_state.compute_pipeline : m_state.graphics_pipeline;
+        if (bound == pipeline) {
+            m_stats.pipeline_binds_elided++;
+            return;
+        }
         vkCmdBindPipeline(m_buffer, bind_point, pipeline);
+        bound = pipeline;
+        m_stats.pipeline_binds++;
+        // A pipeline with an incompatible layout disturbs push constants, the encoder does not know the layout.
+        m_state.push_layout = VK_NULL_HANDLE;
     }
 
     void VulkanCommandEncoder::bind_descriptor_set(VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout, uint32_t set, const std::vector<VkDescriptorSet> &sets, const std::vector<uint32_t>& dynamic_offsets) const {
@@ -93,11 +176,19 @@ namespace Posideon {
         vkCmdBindVertexBuffers(m_buffer, 0, 1, &buffer, &offset);
     }
 
-    void VulkanCommandEncoder::bind_index_buffer(VkBuffer buffer, VkIndexType index_type) const {
-        vkCmdBindIndexBuffer(m_buffer, buffer, 0, index_type);
+    void VulkanCommandEncoder::bind_index_buffer(VkBuffer buffer, VkIndexType index_type, VkDeviceSize offset) const {
+        if (m_state.index_buffer == buffer && m_state.index_type == index_type && m_state.index_offset == offset) {
+            m_stats.index_buffer_binds_elided++;
+            return;
+        }
+        vkCmdBindIndexBuffer(m_buffer, buffer, offset, index_type);
+        m_state.index_buffer = buffer;
+        m_state.index_type = index_type;
+        m_state.index_offset = offset;
+        m_stats.index_buffer_binds++;
     }
 
-    void VulkanCommandEncoder::copy_buffer_to_buffer(VkBuffer source, VkBuffer destination, size_t size, uint32_t src_offset, uint32_t dst_offset) const {
+    void VulkanCommandEncoder::copy_buffer_to_buffer(VkBuffer source, VkBuffer destination, VkDeviceSize size, VkDeviceSize src_offset, VkDeviceSize dst_offset) const {
         VkBufferCopy copy {
             .srcOffset = src_offset,
             .dstOffset = dst_offset,
@@ -106,6 +197,121 @@ namespace Posideon {
         vkCmdCopyBuffer(m_buffer, source, destination, 1, &copy);
     }
 
+    void VulkanCommandEncoder::update_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const void* data) const {
+        vkCmdUpdateBuffer(m_buffer, buffer, offset, size, data);
+    }
+
+    void VulkanCommandEncoder::copy_buffer_to_image(VkBuffer source, VkImage destination, VkExtent2D extent, VkDeviceSize src_offset, uint32_t mip_level) const {
+        const VkBufferImageCopy copy {
+            .bufferOffset = src_offset,
+            .imageSubresource = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = mip_level,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+            .imageExtent = { extent.width, extent.height, 1 }
+        };
+        vkCmdCopyBufferToImage(m_buffer, source, destination, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+    }
+
+    static void mip_barrier(VkCommandBuffer buffer, VkImage image, uint32_t level, uint32_t level_count, VkImageLayout old_layout, VkImageLayout new_layout,
+                            VkPipelineStageFlags2 dst_stage, VkAccessFlags2 dst_access) {
+        const VkImageMemoryBarrier2 barrier {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask = dst_stage,
+            .dstAccessMask = dst_access,
+            .oldLayout = old_layout,
+            .newLayout = new_layout,
+            .image = image,
+            .subresourceRange = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = level,
+                .levelCount = level_count,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+        };
+        const VkDependencyInfo dependency_info {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers = &barrier,
+        };
+        vkCmdPipelineBarrier2(buffer, &dependency_info);
+    }
+
+    void VulkanCommandEncoder::generate_mipmaps(VkImage image, VkExtent2D extent, uint32_t mip_levels) const {
+        int32_t width = static_cast<int32_t>(extent.width);
+        int32_t height = static_cast<int32_t>(extent.height);
+        for (uint32_t level = 1; level < mip_levels; level++) {
+            // Each level is read as soon as the previous blit has written it.
+            mip_barrier(m_buffer, image, level - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+
+            const int32_t next_width = std::max(width / 2, 1);
+            const int32_t next_height = std::max(height / 2, 1);
+            VkImageBlit2 blit_region {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_BLIT_2,
+                .srcSubresource = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = level - 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+                .dstSubresource = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = level,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                }
+            };
+            blit_region.srcOffsets[1] = { width, height, 1 };
+            blit_region.dstOffsets[1] = { next_width, next_height, 1 };
+
+            const VkBlitImageInfo2 blit_info {
+                .sType = VK_STRUCTURE_TYPE_BLIT_IMAGE_INFO_2,
+                .srcImage = image,
+                .srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                .dstImage = image,
+                .dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .regionCount = 1,
+                .pRegions = &blit_region,
+                .filter = VK_FILTER_LINEAR
+            };
+            vkCmdBlitImage2(m_buffer, &blit_info);
+            width = next_width;
+            height = next_height;
+        }
+
+        if (mip_levels > 1) {
+            mip_barrier(m_buffer, image, 0, mip_levels - 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                        VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+        }
+        mip_barrier(m_buffer, image, mip_levels - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+    }
+
+    void VulkanCommandEncoder::copy_image_level(VkImage source, VkImage destination, VkExtent2D extent, uint32_t src_mip, uint32_t dst_mip) const {
+        const VkImageCopy copy {
+            .srcSubresource = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = src_mip,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+            .dstSubresource = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = dst_mip,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+            .extent = { extent.width, extent.height, 1 }
+        };
+        vkCmdCopyImage(m_buffer, source, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, destination, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+    }
+
     void VulkanCommandEncoder::copy_image_to_image(VkImage source, VkImage destination, VkExtent2D src_size, VkExtent2D dst_size) const {
         VkImageBlit2 blit_region {
             .sType = VK_STRUCTURE_TYPE_IMAGE_BLIT_2,
@@ -146,8 +352,17 @@ namespace Posideon {
         vkCmdDraw(m_buffer, vertex_count, 1, 0, 0);
     }
 
-    void VulkanCommandEncoder::draw_indexed(uint32_t index_count, uint32_t start_index) const {
-        vkCmdDrawIndexed(m_buffer, index_count, 1, start_index, 0, 0);
+    void VulkanCommandEncoder::draw_indexed(uint32_t index_count, uint32_t start_index, int32_t vertex_offset, uint32_t instance_count, uint32_t first_instance) const {
+        vkCmdDrawIndexed(m_buffer, index_count, instance_count, start_index, vertex_offset, first_instance);
+    }
+
+    void VulkanCommandEncoder::draw_indexed_indirect(VkBuffer buffer, VkDeviceSize offset) const {
+        vkCmdDrawIndexedIndirect(m_buffer, buffer, offset, 1, sizeof(VkDrawIndexedIndirectCommand));
+    }
+
+    void VulkanCommandEncoder::draw_mesh_tasks_indirect(VkBuffer buffer, VkDeviceSize offset) const {
+        POSIDEON_ASSERT(draw_mesh_tasks_indirect_fn != nullptr)
+        draw_mesh_tasks_indirect_fn(m_buffer, buffer, offset, 1, sizeof(VkDrawMeshTasksIndirectCommandEXT));
     }
 
     void VulkanCommandEncoder::dispatch(uint32_t x, uint32_t y) const {
@@ -155,9 +370,26 @@ namespace Posideon {
     }
 
     void VulkanCommandEncoder::push_constants(VkPipelineLayout pipeline_layout, VkShaderStageFlags stage, uint32_t size, const void* values) const {
-        vkCmdPushConstants(m_buffer, pipeline_layout, stage, 0, size, values);   
+        POSIDEON_ASSERT(size <= m_state.push_data.size())
+        if (m_state.push_layout == pipeline_layout && m_state.push_stages == stage && m_state.push_size == size &&
+            memcmp(m_state.push_data.data(), values, size) == 0) {
+            m_stats.push_constants_elided++;
+            return;
+        }
+        vkCmdPushConstants(m_buffer, pipeline_layout, stage, 0, size, values);
+        m_state.push_layout = pipeline_layout;
+        m_state.push_stages = stage;
+        m_state.push_size = size;
+        memcpy(m_state.push_data.data(), values, size);
+        m_stats.push_constants++;
     }
     
+    void VulkanCommandEncoder::execute_commands(std::span<const VkCommandBuffer> buffers) const {
+        vkCmdExecuteCommands(m_buffer, static_cast<uint32_t>(buffers.size()), buffers.data());
+        // Secondary buffers leave the primary's bound state undefined.
+        invalidate_state();
+    }
+
     void VulkanCommandEncoder::end_rendering() const {
         vkCmdEndRendering(m_buffer);
     }
@@ -167,4 +399,8 @@ namespace Posideon {
         POSIDEON_ASSERT(res == VK_SUCCESS)
         return m_buffer;
     }
-}
\ No newline at end of file
+
+    void VulkanCommandEncoder::invalidate_state() const {
+        m_state = {};
+    }
+}
@@ -1,31 +1,98 @@
 #pragma once
 
 #include "defines.h"
+#include <array>
+#include <span>
 #include <vulkan/vulkan.hpp>
 
 namespace Posideon {
+    void load_mesh_shader_functions(VkInstance instance);
+
+    struct ScopedDebugLabel {
+        VkCommandBuffer m_buffer;
+
+        ScopedDebugLabel(VkCommandBuffer buffer, const char* name);
+        ScopedDebugLabel(const ScopedDebugLabel&) = delete;
+        ScopedDebugLabel& operator=(const ScopedDebugLabel&) = delete;
+        ~ScopedDebugLabel();
+    };
+
+    // State changes recorded and skipped since the command buffer began.
+    struct EncoderStats {
+        uint32_t pipeline_binds = 0;
+        uint32_t pipeline_binds_elided = 0;
+        uint32_t index_buffer_binds = 0;
+        uint32_t index_buffer_binds_elided = 0;
+        uint32_t push_constants = 0;
+        uint32_t push_constants_elided = 0;
+
+        EncoderStats& operator+=(const EncoderStats& other) {
+            pipeline_binds += other.pipeline_binds;
+            pipeline_binds_elided += other.pipeline_binds_elided;
+            index_buffer_binds += other.index_buffer_binds;
+            index_buffer_binds_elided += other.index_buffer_binds_elided;
+            push_constants += other.push_constants;
+            push_constants_elided += other.push_constants_elided;
+            return *this;
+        }
+    };
+
+    // Last state bound on the command buffer, used to skip redundant binds.
+    struct EncoderState {
+        VkPipeline graphics_pipeline = VK_NULL_HANDLE;
+        VkPipeline compute_pipeline = VK_NULL_HANDLE;
+        VkBuffer index_buffer = VK_NULL_HANDLE;
+        VkIndexType index_type = VK_INDEX_TYPE_MAX_ENUM;
+        VkDeviceSize index_offset = 0;
+        VkPipelineLayout push_layout = VK_NULL_HANDLE;
+        VkShaderStageFlags push_stages = 0;
+        uint32_t push_size = 0;
+        std::array<uint8_t, 128> push_data {};
+    };
+
     struct VulkanCommandEncoder {
         VkCommandBuffer m_buffer;
+        mutable EncoderState m_state {};
+        mutable EncoderStats m_stats {};
 
         explicit VulkanCommandEncoder(VkCommandBuffer buffer): m_buffer(buffer) {}
 
         void reset() const;
         void begin() const;
+        // Begins a secondary buffer that continues a dynamic rendering pass with these attachment formats.
+        void begin_secondary(VkFormat color_format, VkFormat depth_format) const;
+        void begin_label(const char* name) const;
+        void end_label() const;
+        [[nodiscard]] ScopedDebugLabel scoped_label(const char* name) const;
         void transition_image(VkImage image, VkImageLayout current_layout, VkImageLayout new_layout) const;
-        void start_rendering(VkRect2D render_area, const std::vector<VkRenderingAttachmentInfo>& attachments, const VkRenderingAttachmentInfo* depth_attachment, const VkRenderingAttachmentInfo* stencil_attachment) const;
+        void memory_barrier(VkPipelineStageFlags2 src_stage, VkAccessFlags2 src_access, VkPipelineStageFlags2 dst_stage, VkAccessFlags2 dst_access) const;
+        void start_rendering(VkRect2D render_area, const std::vector<VkRenderingAttachmentInfo>& attachments, const VkRenderingAttachmentInfo* depth_attachment, const VkRenderingAttachmentInfo* stencil_attachment, VkRenderingFlags flags = 0) const;
         void set_viewport(uint32_t width, uint32_t height) const;
         void set_scissor(uint32_t width, uint32_t height) const;
         void bind_pipeline(VkPipelineBindPoint bind_point, VkPipeline pipeline) const;
         void bind_descriptor_set(VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout, uint32_t set, const std::vector<VkDescriptorSet>& sets, const std::vector<uint32_t>& dynamic_offsets) const;
         void bind_vertex_buffer(VkBuffer buffer, VkDeviceSize offset) const;
-        void bind_index_buffer(VkBuffer buffer, VkIndexType index_type) const;
-        void copy_buffer_to_buffer(VkBuffer source, VkBuffer destination, size_t size, uint32_t src_offset, uint32_t dst_offset) const;
+        void bind_index_buffer(VkBuffer buffer, VkIndexType index_type, VkDeviceSize offset = 0) const;
+        void copy_buffer_to_buffer(VkBuffer source, VkBuffer destination, VkDeviceSize size, VkDeviceSize src_offset, VkDeviceSize dst_offset) const;
+        void update_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const void* data) const;
+        void copy_buffer_to_image(VkBuffer source, VkImage destination, VkExtent2D extent, VkDeviceSize src_offset, uint32_t mip_level = 0) const;
+        // Expects every level in TRANSFER_DST_OPTIMAL with level 0 filled, leaves them all SHADER_READ_ONLY_OPTIMAL.
+        void generate_mipmaps(VkImage image, VkExtent2D extent, uint32_t mip_levels) const;
         void copy_image_to_image(VkImage source, VkImage destination, VkExtent2D src_size, VkExtent2D dst_size) const;
+        // Unscaled copy of one mip level, valid for block compressed formats unlike a blit.
+        void copy_image_level(VkImage source, VkImage destination, VkExtent2D extent, uint32_t src_mip, uint32_t dst_mip) const;
         void draw(uint32_t vertex_count) const;
-        void draw_indexed(uint32_t index_count, uint32_t start_index = 0) const;
+        void draw_indexed(uint32_t index_count, uint32_t start_index = 0, int32_t vertex_offset = 0, uint32_t instance_count = 1, uint32_t first_instance = 0) const;
+        void draw_indexed_indirect(VkBuffer buffer, VkDeviceSize offset) const;
+        void draw_mesh_tasks_indirect(VkBuffer buffer, VkDeviceSize offset) const;
         void dispatch(uint32_t x, uint32_t y) const;
         void push_constants(VkPipelineLayout pipeline_layout, VkShaderStageFlags stage, uint32_t size, const void* values) const;
+        void execute_commands(std::span<const VkCommandBuffer> buffers) const;
         void end_rendering() const;
         [[nodiscard]] VkCommandBuffer finish() const;
+
+        // Forgets the tracked state, for when commands are recorded behind the encoder's back.
+        void invalidate_state() const;
+        [[nodiscard]] const EncoderStats& stats() const { return m_stats; }
     };
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "vulkan_debug.h"
+
+#ifdef POSIDEON_DEBUG_LABELS
+namespace Posideon {
+    static PFN_vkSetDebugUtilsObjectNameEXT set_object_name_fn = nullptr;
+    static PFN_vkCmdBeginDebugUtilsLabelEXT begin_label_fn = nullptr;
+    static PFN_vkCmdEndDebugUtilsLabelEXT end_label_fn = nullptr;
+
+    void load_debug_utils(VkInstance instance) {
+        set_object_name_fn = reinterpret_cast<PFN_vkSetDebugUtilsObjectNameEXT>(vkGetInstanceProcAddr(instance, "vkSetDebugUtilsObjectNameEXT"));
+        begin_label_fn = reinterpret_cast<PFN_vkCmdBeginDebugUtilsLabelEXT>(vkGetInstanceProcAddr(instance, "vkCmdBeginDebugUtilsLabelEXT"));
+        end_label_fn = reinterpret_cast<PFN_vkCmdEndDebugUtilsLabelEXT>(vkGetInstanceProcAddr(instance, "vkCmdEndDebugUtilsLabelEXT"));
+    }
+
+    void set_debug_name(VkDevice device, VkObjectType object_type, uint64_t handle, const char* name) {
+        if (set_object_name_fn == nullptr || name == nullptr || handle == 0) {
+            return;
+        }
+
+        const VkDebugUtilsObjectNameInfoEXT name_info {
+            .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
+            .objectType = object_type,
+            .objectHandle = handle,
+            .pObjectName = name
+        };
+        set_object_name_fn(device, &name_info);
+    }
+
+    void begin_debug_label(VkCommandBuffer buffer, const char* name) {
+        if (begin_label_fn == nullptr) {
+            return;
+        }
+
+        const VkDebugUtilsLabelEXT label {
+            .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT,
+            .pLabelName = name,
+        };
+        begin_label_fn(buffer, &label);
+    }
+
+    void end_debug_label(VkCommandBuffer buffer) {
+        if (end_label_fn == nullptr) {
+            return;
+        }
+
+        end_label_fn(buffer);
+    }
+}
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "defines.h"
+#include <vulkan/vulkan.hpp>
+
+namespace Posideon {
+#ifdef POSIDEON_DEBUG_LABELS
+    void load_debug_utils(VkInstance instance);
+    void set_debug_name(VkDevice device, VkObjectType object_type, uint64_t handle, const char* name);
+    void begin_debug_label(VkCommandBuffer buffer, const char* name);
+    void end_debug_label(VkCommandBuffer buffer);
+#else
+    inline void load_debug_utils(VkInstance) {}
+    inline void set_debug_name(VkDevice, VkObjectType, uint64_t, const char*) {}
+    inline void begin_debug_label(VkCommandBuffer, const char*) {}
+    inline void end_debug_label(VkCommandBuffer) {}
+#endif
+
+    template <typename T>
+    uint64_t debug_handle(T handle) {
+        return reinterpret_cast<uint64_t>(handle);
+    }
+}
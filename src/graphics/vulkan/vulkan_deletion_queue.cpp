@@ -0,0 +1,45 @@
+#include "vulkan_deletion_queue.h"
+
+namespace Posideon {
+    void DeletionQueue::push(uint64_t frame, std::function<void()>&& deletor) {
+        std::lock_guard lock(m_mutex);
+        m_entries.emplace_back(Entry { frame, std::move(deletor) });
+    }
+
+    void DeletionQueue::collect(uint64_t completed_frame) {
+        std::deque<Entry> completed;
+        {
+            std::lock_guard lock(m_mutex);
+            while (!m_entries.empty() && m_entries.front().frame <= completed_frame) {
+                completed.push_back(std::move(m_entries.front()));
+                m_entries.pop_front();
+            }
+        }
+        for (Entry& entry : completed) {
+            entry.deletor();
+        }
+    }
+
+    void DeletionQueue::flush() {
+        // Deletors that retire more objects refill the queue, keep going until nothing is left.
+        std::deque<Entry> entries;
+        while (true) {
+            {
+                std::lock_guard lock(m_mutex);
+                if (m_entries.empty()) {
+                    return;
+                }
+                entries.swap(m_entries);
+            }
+            for (Entry& entry : entries) {
+                entry.deletor();
+            }
+            entries.clear();
+        }
+    }
+
+    size_t DeletionQueue::size() const {
+        std::lock_guard lock(m_mutex);
+        return m_entries.size();
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace Posideon {
+    // Objects are retired from the render thread, the main thread and asset jobs, so every access takes the
+    // lock. Deletors run outside it, they may release resources that retire again.
+    class DeletionQueue {
+        struct Entry {
+            uint64_t frame;
+            std::function<void()> deletor;
+        };
+
+        mutable std::mutex m_mutex;
+        std::deque<Entry> m_entries;
+
+    public:
+        void push(uint64_t frame, std::function<void()>&& deletor);
+        void collect(uint64_t completed_frame);
+        void flush();
+
+        [[nodiscard]] size_t size() const;
+    };
+}
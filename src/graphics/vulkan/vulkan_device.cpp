@@ -1,4 +1,7 @@
 #include "vulkan_device.h"
+#include "vulkan_debug.h"
+
+#include <algorithm>
 
 namespace Posideon {
     std::optional<uint32_t> VulkanDevice::get_memory_type_index(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
@@ -11,6 +14,43 @@ namespace Posideon {
         return {};
     }
 
+    void VulkanDevice::set_object_name(VkObjectType object_type, uint64_t handle, const char* name) const {
+        set_debug_name(m_device, object_type, handle, name);
+    }
+
+    void VulkanDevice::track_allocation(VmaAllocation allocation, int64_t sign) const {
+        VmaAllocationInfo allocation_info;
+        vmaGetAllocationInfo(m_allocator, allocation, &allocation_info);
+        const auto category = static_cast<size_t>(reinterpret_cast<uintptr_t>(allocation_info.pUserData));
+        if (sign > 0) {
+            m_category_usage[category] += allocation_info.size;
+        } else {
+            m_category_usage[category] -= allocation_info.size;
+        }
+    }
+
+    void VulkanDevice::track_retiring(VmaAllocation allocation, int64_t sign) const {
+        VmaAllocationInfo allocation_info;
+        vmaGetAllocationInfo(m_allocator, allocation, &allocation_info);
+        const uint32_t heap = m_physicalDevice.device_memory_properties.memoryTypes[allocation_info.memoryType].heapIndex;
+        if (sign > 0) {
+            m_retiring_bytes[heap] += allocation_info.size;
+        } else {
+            m_retiring_bytes[heap] -= allocation_info.size;
+        }
+    }
+
+    uint64_t VulkanDevice::evict(MemoryCategory category, uint64_t bytes_to_free) const {
+        uint64_t freed = 0;
+        for (const EvictionCallback& evictor : m_budget_policy.evictors[static_cast<size_t>(category)]) {
+            if (freed >= bytes_to_free) {
+                break;
+            }
+            freed += evictor(bytes_to_free - freed);
+        }
+        return freed;
+    }
+
     VkQueue VulkanDevice::get_queue() const {
         VkQueue queue;
         vkGetDeviceQueue(m_device, m_physicalDevice.graphics_family_index, 0, &queue);
@@ -61,28 +101,32 @@ namespace Posideon {
         return address;
     }
 
-    std::vector<VkCommandBuffer> VulkanDevice::allocate_command_buffers(VkCommandPool command_pool, uint32_t buffer_count) const {
+    std::vector<VkCommandBuffer> VulkanDevice::allocate_command_buffers(VkCommandPool command_pool, uint32_t buffer_count, const char* name, VkCommandBufferLevel level) const {
         VkCommandBufferAllocateInfo command_buffer_allocate_info {
             .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
             .commandPool = command_pool,
-            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .level = level,
             .commandBufferCount = buffer_count
         };
 
         std::vector<VkCommandBuffer> buffers(buffer_count);
         const VkResult res = vkAllocateCommandBuffers(m_device, &command_buffer_allocate_info, buffers.data());
         POSIDEON_ASSERT(res == VK_SUCCESS)
+        for (VkCommandBuffer buffer : buffers) {
+            set_object_name(VK_OBJECT_TYPE_COMMAND_BUFFER, debug_handle(buffer), name);
+        }
         return buffers;
     }
 
-    VkSwapchainKHR VulkanDevice::create_swapchain(const VkSwapchainCreateInfoKHR& create_info) const {
+    VkSwapchainKHR VulkanDevice::create_swapchain(const VkSwapchainCreateInfoKHR& create_info, const char* name) const {
         VkSwapchainKHR swapchain;
         const VkResult res = vkCreateSwapchainKHR(m_device, &create_info, nullptr, &swapchain);
         POSIDEON_ASSERT(res == VK_SUCCESS)
+        set_object_name(VK_OBJECT_TYPE_SWAPCHAIN_KHR, debug_handle(swapchain), name);
         return swapchain;
     }
 
-    VkCommandPool VulkanDevice::create_command_pool() const {
+    VkCommandPool VulkanDevice::create_command_pool(const char* name) const {
         const VkCommandPoolCreateInfo create_info {
             .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
             .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
@@ -91,10 +135,11 @@ namespace Posideon {
         VkCommandPool pool;
         const VkResult res = vkCreateCommandPool(m_device, &create_info, nullptr, &pool);
         POSIDEON_ASSERT(res == VK_SUCCESS)
+        set_object_name(VK_OBJECT_TYPE_COMMAND_POOL, debug_handle(pool), name);
         return pool;
     }
 
-    VkSemaphore VulkanDevice::create_semaphore() const {
+    VkSemaphore VulkanDevice::create_semaphore(const char* name) const {
         VkSemaphoreCreateInfo create_info {
             .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
         };
@@ -102,10 +147,11 @@ namespace Posideon {
         VkSemaphore semaphore;
         const VkResult res = vkCreateSemaphore(m_device, &create_info, nullptr, &semaphore);
         POSIDEON_ASSERT(res == VK_SUCCESS)
+        set_object_name(VK_OBJECT_TYPE_SEMAPHORE, debug_handle(semaphore), name);
         return semaphore;
     }
 
-    VkFence VulkanDevice::create_fence(bool signaled) const {
+    VkFence VulkanDevice::create_fence(bool signaled, const char* name) const {
         VkFenceCreateInfo create_info{
             .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
             .flags = signaled ? VK_FENCE_CREATE_SIGNALED_BIT : VkFenceCreateFlags(0),
@@ -114,10 +160,34 @@ namespace Posideon {
         VkFence fence;
         VkResult res = vkCreateFence(m_device, &create_info, nullptr, &fence);
         POSIDEON_ASSERT(res == VK_SUCCESS);
+        set_object_name(VK_OBJECT_TYPE_FENCE, debug_handle(fence), name);
         return fence;
     }
 
-    VkPipelineLayout VulkanDevice::create_pipeline_layout(const std::vector<VkDescriptorSetLayout>& set_layouts, const std::vector<VkPushConstantRange>& push_constants) const {
+    void VulkanDevice::create_pipeline_cache(std::span<const char> initial_data) {
+        const VkPipelineCacheCreateInfo create_info {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            .initialDataSize = initial_data.size(),
+            .pInitialData = initial_data.data(),
+        };
+        const VkResult res = vkCreatePipelineCache(m_device, &create_info, nullptr, &m_pipeline_cache);
+        POSIDEON_ASSERT(res == VK_SUCCESS)
+        set_object_name(VK_OBJECT_TYPE_PIPELINE_CACHE, debug_handle(m_pipeline_cache), "pipeline_cache");
+    }
+
+    std::vector<char> VulkanDevice::get_pipeline_cache_data() const {
+        if (m_pipeline_cache == VK_NULL_HANDLE) {
+            return {};
+        }
+        size_t size = 0;
+        vkGetPipelineCacheData(m_device, m_pipeline_cache, &size, nullptr);
+        std::vector<char> data(size);
+        vkGetPipelineCacheData(m_device, m_pipeline_cache, &size, data.data());
+        data.resize(size);
+        return data;
+    }
+
+    VkPipelineLayout VulkanDevice::create_pipeline_layout(const std::vector<VkDescriptorSetLayout>& set_layouts, const std::vector<VkPushConstantRange>& push_constants, const char* name) const {
         const VkPipelineLayoutCreateInfo create_info{
             .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
             .setLayoutCount = static_cast<uint32_t>(set_layouts.size()),
@@ -129,19 +199,21 @@ namespace Posideon {
         VkPipelineLayout pipeline_layout;
         VkResult res = vkCreatePipelineLayout(m_device, &create_info, nullptr, &pipeline_layout);
         POSIDEON_ASSERT(res == VK_SUCCESS);
+        set_object_name(VK_OBJECT_TYPE_PIPELINE_LAYOUT, debug_handle(pipeline_layout), name);
 
         return pipeline_layout;
     }
 
-    VkPipeline VulkanDevice::create_graphics_pipeline(const VkGraphicsPipelineCreateInfo& descriptor) const {
+    VkPipeline VulkanDevice::create_graphics_pipeline(const VkGraphicsPipelineCreateInfo& descriptor, const char* name) const {
         VkPipeline pipeline;
-        const VkResult res = vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &descriptor, nullptr, &pipeline);
+        const VkResult res = vkCreateGraphicsPipelines(m_device, m_pipeline_cache, 1, &descriptor, nullptr, &pipeline);
         POSIDEON_ASSERT(res == VK_SUCCESS)
+        set_object_name(VK_OBJECT_TYPE_PIPELINE, debug_handle(pipeline), name);
 
         return pipeline;
     }
 
-    VkPipeline VulkanDevice::create_compute_pipeline(const ComputePipelineDescriptor& descriptor) const {
+    VkPipeline VulkanDevice::create_compute_pipeline(const ComputePipelineDescriptor& descriptor, const char* name) const {
         const VkComputePipelineCreateInfo pipeline_create_info {
             .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
             .stage = descriptor.shader_stage,
@@ -149,13 +221,14 @@ namespace Posideon {
         };
 
         VkPipeline pipeline;
-        const VkResult res = vkCreateComputePipelines(m_device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &pipeline);
+        const VkResult res = vkCreateComputePipelines(m_device, m_pipeline_cache, 1, &pipeline_create_info, nullptr, &pipeline);
         POSIDEON_ASSERT(res == VK_SUCCESS)
+        set_object_name(VK_OBJECT_TYPE_PIPELINE, debug_handle(pipeline), name);
 
         return pipeline;
     }
 
-    VkShaderModule VulkanDevice::create_shader_module(const std::vector<char>& code) const {
+    VkShaderModule VulkanDevice::create_shader_module(const std::vector<char>& code, const char* name) const {
         VkShaderModuleCreateInfo create_info{
                 .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
                 .codeSize = code.size(),
@@ -165,6 +238,7 @@ namespace Posideon {
         VkShaderModule shader_module;
         VkResult res = vkCreateShaderModule(m_device, &create_info, nullptr, &shader_module);
         POSIDEON_ASSERT(res == VK_SUCCESS);
+        set_object_name(VK_OBJECT_TYPE_SHADER_MODULE, debug_handle(shader_module), name);
 
         return shader_module;
     }
@@ -176,6 +250,12 @@ namespace Posideon {
         return image_index;
     }
 
+    void VulkanDevice::destroy_image(VulkanImage image) const {
+        track_allocation(image.allocation, -1);
+        vkDestroyImageView(m_device, image.image_view, nullptr);
+        vmaDestroyImage(m_allocator, image.image, image.allocation);
+    }
+
     void VulkanDevice::destroy_image_view(VkImageView image_view) const {
         vkDestroyImageView(m_device, image_view, nullptr);
     }
@@ -188,11 +268,16 @@ namespace Posideon {
         return vkResetFences(m_device, 1, &fence);
     }
 
+    void VulkanDevice::wait_idle() const {
+        const VkResult res = vkDeviceWaitIdle(m_device);
+        POSIDEON_ASSERT(res == VK_SUCCESS)
+    }
+
     void VulkanDevice::destroy_swapchain(VkSwapchainKHR swapchain) const {
         vkDestroySwapchainKHR(m_device, swapchain, nullptr);
     }
 
-    VkDescriptorPool VulkanDevice::create_descriptor_pool(const std::vector<VkDescriptorPoolSize> &pool_sizes) const {
+    VkDescriptorPool VulkanDevice::create_descriptor_pool(const std::vector<VkDescriptorPoolSize> &pool_sizes, const char* name) const {
         const VkDescriptorPoolCreateInfo create_info {
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
             .maxSets = 100,
@@ -202,10 +287,11 @@ namespace Posideon {
         VkDescriptorPool pool;
         VkResult res = vkCreateDescriptorPool(m_device, &create_info, nullptr, &pool);
         POSIDEON_ASSERT(res == VK_SUCCESS)
+        set_object_name(VK_OBJECT_TYPE_DESCRIPTOR_POOL, debug_handle(pool), name);
         return pool;
     }
 
-    VkDescriptorSetLayout VulkanDevice::create_descriptor_set_layout(const std::vector<VkDescriptorSetLayoutBinding> &bindings) const {
+    VkDescriptorSetLayout VulkanDevice::create_descriptor_set_layout(const std::vector<VkDescriptorSetLayoutBinding> &bindings, const char* name) const {
         const VkDescriptorSetLayoutCreateInfo create_info {
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
             .bindingCount = static_cast<uint32_t>(bindings.size()),
@@ -214,10 +300,11 @@ namespace Posideon {
         VkDescriptorSetLayout layout;
         VkResult res = vkCreateDescriptorSetLayout(m_device, &create_info, nullptr, &layout);
         POSIDEON_ASSERT(res == VK_SUCCESS)
+        set_object_name(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, debug_handle(layout), name);
         return layout;
     }
 
-    VulkanImage VulkanDevice::create_image(const ImageDescriptor &descriptor) const {
+    VulkanImage VulkanDevice::create_image(const ImageDescriptor &descriptor, MemoryCategory category, const char* name) const {
         const VkImageCreateInfo create_info {
             .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
             .imageType = descriptor.image_type,
@@ -227,7 +314,7 @@ namespace Posideon {
                 .height = descriptor.height,
                 .depth = 1,
             },
-            .mipLevels = 1,
+            .mipLevels = descriptor.mip_levels,
             .arrayLayers = 1,
             .samples = VK_SAMPLE_COUNT_1_BIT,
             .tiling = VK_IMAGE_TILING_OPTIMAL,
@@ -235,25 +322,45 @@ namespace Posideon {
             .initialLayout = descriptor.initial_layout,
         };
 
-        constexpr VmaAllocationCreateInfo image_allocation_info {
+        const bool streamed = category == MemoryCategory::Texture;
+        VmaAllocationCreateInfo image_allocation_info {
+            .flags = streamed ? VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT : VmaAllocationCreateFlags(0),
             .usage = VMA_MEMORY_USAGE_GPU_ONLY,
-            .requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            .requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            .pUserData = reinterpret_cast<void*>(static_cast<uintptr_t>(category))
         };
 
         VkImage image;
         VmaAllocation allocation;
-        vmaCreateImage(m_allocator, &create_info, &image_allocation_info, &image, &allocation, nullptr);
+        VkResult res = vmaCreateImage(m_allocator, &create_info, &image_allocation_info, &image, &allocation, nullptr);
+        if (res == VK_ERROR_OUT_OF_DEVICE_MEMORY && streamed) {
+            // The failed allocation left no image to query, a bare one gives the size the driver would need.
+            VkImage probe;
+            res = vkCreateImage(m_device, &create_info, nullptr, &probe);
+            POSIDEON_ASSERT(res == VK_SUCCESS)
+            VkMemoryRequirements requirements;
+            vkGetImageMemoryRequirements(m_device, probe, &requirements);
+            vkDestroyImage(m_device, probe, nullptr);
+
+            evict(category, requirements.size);
+            image_allocation_info.flags &= ~VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+            res = vmaCreateImage(m_allocator, &create_info, &image_allocation_info, &image, &allocation, nullptr);
+        }
+        POSIDEON_ASSERT(res == VK_SUCCESS)
+        track_allocation(allocation, 1);
+        set_object_name(VK_OBJECT_TYPE_IMAGE, debug_handle(image), name);
 
         VkImageView image_view = create_image_view(image, {
             .image_view_type = descriptor.image_view_type,
             .format = descriptor.format,
-            .aspect_mask = descriptor.aspect_mask
-        });
+            .aspect_mask = descriptor.aspect_mask,
+            .mip_levels = descriptor.mip_levels
+        }, name);
 
         return { image, image_view, allocation, create_info.extent, descriptor.format };
     }
 
-    VkImageView VulkanDevice::create_image_view(VkImage image, const ImageViewDescriptor &descriptor) const {
+    VkImageView VulkanDevice::create_image_view(VkImage image, const ImageViewDescriptor &descriptor, const char* name) const {
         VkImageViewCreateInfo create_info {
             .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
             .image = image,
@@ -262,7 +369,7 @@ namespace Posideon {
             .subresourceRange = {
                 .aspectMask = descriptor.aspect_mask,
                 .baseMipLevel = 0,
-                .levelCount = 1,
+                .levelCount = descriptor.mip_levels,
                 .baseArrayLayer = 0,
                 .layerCount = 1
             }
@@ -270,29 +377,49 @@ namespace Posideon {
         VkImageView image_view;
         VkResult res = vkCreateImageView(m_device, &create_info, nullptr, &image_view);
         POSIDEON_ASSERT(res == VK_SUCCESS)
+        set_object_name(VK_OBJECT_TYPE_IMAGE_VIEW, debug_handle(image_view), name);
 
         return image_view;
     }
 
-    VulkanBuffer VulkanDevice::create_buffer(size_t alloc_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) const {
+    VkSampler VulkanDevice::create_sampler(const VkSamplerCreateInfo& create_info, const char* name) const {
+        VkSampler sampler;
+        const VkResult res = vkCreateSampler(m_device, &create_info, nullptr, &sampler);
+        POSIDEON_ASSERT(res == VK_SUCCESS)
+        set_object_name(VK_OBJECT_TYPE_SAMPLER, debug_handle(sampler), name);
+        return sampler;
+    }
+
+    VulkanBuffer VulkanDevice::create_buffer(size_t alloc_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage, MemoryCategory category, const char* name) const {
         VkBufferCreateInfo create_info {
             .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
             .size = alloc_size,
             .usage = usage
         };
 
+        const bool streamed = category == MemoryCategory::Mesh || category == MemoryCategory::Texture;
         VmaAllocationCreateInfo alloc_info {
-            .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            .flags = static_cast<VmaAllocationCreateFlags>(VMA_ALLOCATION_CREATE_MAPPED_BIT | (streamed ? VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT : 0)),
             .usage = memory_usage,
+            .pUserData = reinterpret_cast<void*>(static_cast<uintptr_t>(category))
         };
 
         VkBuffer buffer;
         VmaAllocation allocation;
         VmaAllocationInfo allocation_info;
-        const VkResult res = vmaCreateBuffer(m_allocator, &create_info, &alloc_info, &buffer, &allocation, &allocation_info);
+        VkResult res = vmaCreateBuffer(m_allocator, &create_info, &alloc_info, &buffer, &allocation, &allocation_info);
+        if (res == VK_ERROR_OUT_OF_DEVICE_MEMORY && streamed) {
+            // Evicted memory is only released once the frames using it retire, so this allocation
+            // is allowed to exceed the budget instead of failing.
+            evict(category, alloc_size);
+            alloc_info.flags &= ~VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+            res = vmaCreateBuffer(m_allocator, &create_info, &alloc_info, &buffer, &allocation, &allocation_info);
+        }
         POSIDEON_ASSERT(res == VK_SUCCESS)
+        track_allocation(allocation, 1);
+        set_object_name(VK_OBJECT_TYPE_BUFFER, debug_handle(buffer), name);
 
-        return { buffer, allocation, allocation_info };
+        return { buffer, allocation, allocation_info, alloc_size, usage };
     }
     
     std::vector<VkDescriptorSet> VulkanDevice::allocate_descriptor_sets(VkDescriptorPool descriptor_pool, const std::vector<VkDescriptorSetLayout> &descriptor_layouts) const {
@@ -329,7 +456,18 @@ namespace Posideon {
         //vkUnmapMemory(m_device, buffer.memory);
     }
 
+    void VulkanDevice::flush_buffer(const VulkanBuffer& buffer) const {
+        const VkResult res = vmaFlushAllocation(m_allocator, buffer.allocation, 0, VK_WHOLE_SIZE);
+        POSIDEON_ASSERT(res == VK_SUCCESS)
+    }
+
+    void VulkanDevice::invalidate_buffer(const VulkanBuffer& buffer) const {
+        const VkResult res = vmaInvalidateAllocation(m_allocator, buffer.allocation, 0, VK_WHOLE_SIZE);
+        POSIDEON_ASSERT(res == VK_SUCCESS)
+    }
+
     void VulkanDevice::destroy_buffer(VulkanBuffer buffer) const {
+        track_allocation(buffer.allocation, -1);
         vmaDestroyBuffer(m_allocator, buffer.buffer, buffer.allocation);
     }
 
@@ -338,7 +476,139 @@ namespace Posideon {
     }
 
     void VulkanDevice::destroy_descriptor_pool(VkDescriptorPool pool) const {
-        vkResetDescriptorPool(m_device, pool, 0);   
+        vkDestroyDescriptorPool(m_device, pool, nullptr);
+    }
+
+    void VulkanDevice::destroy_descriptor_set_layout(VkDescriptorSetLayout layout) const {
+        vkDestroyDescriptorSetLayout(m_device, layout, nullptr);
+    }
+
+    void VulkanDevice::destroy_pipeline(VkPipeline pipeline) const {
+        vkDestroyPipeline(m_device, pipeline, nullptr);
+    }
+
+    void VulkanDevice::destroy_pipeline_layout(VkPipelineLayout layout) const {
+        vkDestroyPipelineLayout(m_device, layout, nullptr);
+    }
+
+    void VulkanDevice::destroy_shader_module(VkShaderModule shader_module) const {
+        vkDestroyShaderModule(m_device, shader_module, nullptr);
+    }
+
+    void VulkanDevice::destroy_command_pool(VkCommandPool pool) const {
+        vkDestroyCommandPool(m_device, pool, nullptr);
+    }
+
+    void VulkanDevice::destroy_fence(VkFence fence) const {
+        vkDestroyFence(m_device, fence, nullptr);
+    }
+
+    void VulkanDevice::destroy_sampler(VkSampler sampler) const {
+        vkDestroySampler(m_device, sampler, nullptr);
+    }
+
+    void VulkanDevice::destroy_semaphore(VkSemaphore semaphore) const {
+        vkDestroySemaphore(m_device, semaphore, nullptr);
+    }
+
+    void VulkanDevice::destroy() {
+        flush_deletion_queue();
+        vkDestroyPipelineCache(m_device, m_pipeline_cache, nullptr);
+        vmaDestroyAllocator(m_allocator);
+        vkDestroyDevice(m_device, nullptr);
+    }
+
+    void VulkanDevice::begin_frame(uint64_t frame_number, uint32_t frames_in_flight) {
+        m_frame_number = frame_number;
+        vmaSetCurrentFrameIndex(m_allocator, static_cast<uint32_t>(frame_number));
+        if (frame_number >= frames_in_flight) {
+            m_deletion_queue.collect(frame_number - frames_in_flight);
+        }
+    }
+
+    void VulkanDevice::retire(std::function<void()>&& deletor) const {
+        m_deletion_queue.push(m_frame_number, std::move(deletor));
+    }
+
+    void VulkanDevice::retire_buffer(VulkanBuffer buffer) const {
+        track_retiring(buffer.allocation, 1);
+        retire([this, buffer] {
+            track_retiring(buffer.allocation, -1);
+            destroy_buffer(buffer);
+        });
+    }
+
+    void VulkanDevice::retire_image(VulkanImage image) const {
+        track_retiring(image.allocation, 1);
+        retire([this, image] {
+            track_retiring(image.allocation, -1);
+            destroy_image(image);
+        });
+    }
+
+    void VulkanDevice::retire_pipeline(VkPipeline pipeline) const {
+        retire([device = m_device, pipeline] {
+            vkDestroyPipeline(device, pipeline, nullptr);
+        });
+    }
+
+    void VulkanDevice::retire_pipeline_layout(VkPipelineLayout layout) const {
+        retire([device = m_device, layout] {
+            vkDestroyPipelineLayout(device, layout, nullptr);
+        });
+    }
+
+    void VulkanDevice::flush_deletion_queue() const {
+        m_deletion_queue.flush();
+    }
+
+    MemoryBudgetReport VulkanDevice::query_memory_budget() const {
+        VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+        vmaGetHeapBudgets(m_allocator, budgets);
+
+        MemoryBudgetReport report;
+        report.heaps.reserve(m_physicalDevice.device_memory_properties.memoryHeapCount);
+        for (uint32_t i = 0; i < m_physicalDevice.device_memory_properties.memoryHeapCount; i++) {
+            report.heaps.emplace_back(HeapBudget {
+                .usage = budgets[i].usage,
+                .budget = budgets[i].budget,
+                .device_local = (m_physicalDevice.device_memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+                .retiring = std::min<uint64_t>(m_retiring_bytes[i], budgets[i].usage),
+            });
+        }
+        report.category_usage = m_category_usage;
+        return report;
+    }
+
+    void VulkanDevice::set_memory_budget_policy(MemoryBudgetPolicy policy) {
+        m_budget_policy = std::move(policy);
+    }
+
+    void VulkanDevice::register_evictor(MemoryCategory category, EvictionCallback&& evictor) {
+        m_budget_policy.evictors[static_cast<size_t>(category)].emplace_back(std::move(evictor));
+    }
+
+    uint64_t VulkanDevice::enforce_memory_budget(const MemoryBudgetReport& report) const {
+        // Retired allocations are only released a few frames later. Counting them as used would evict the
+        // same overshoot again every frame until they are gone.
+        uint64_t bytes_to_free = 0;
+        for (const HeapBudget& heap : report.heaps) {
+            const uint64_t usage = heap.usage - heap.retiring;
+            const auto threshold = static_cast<uint64_t>(static_cast<double>(heap.budget) * m_budget_policy.eviction_threshold);
+            const auto target = static_cast<uint64_t>(static_cast<double>(heap.budget) * m_budget_policy.eviction_target);
+            if (heap.device_local && usage > threshold) {
+                bytes_to_free += usage - std::min(usage, target);
+            }
+        }
+        if (bytes_to_free == 0) {
+            return 0;
+        }
+
+        uint64_t freed = evict(MemoryCategory::Texture, bytes_to_free);
+        if (freed < bytes_to_free) {
+            freed += evict(MemoryCategory::Mesh, bytes_to_free - freed);
+        }
+        return freed;
     }
 
     void DescriptorAllocator::init_pool(const VulkanDevice& device, uint32_t max_sets, const std::vector<PoolSizeRatio>& pool_ratios) {
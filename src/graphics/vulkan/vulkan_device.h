@@ -1,10 +1,15 @@
 #pragma once
 
 #include "defines.h"
+#include <atomic>
 #include <vulkan/vulkan.hpp>
 #include <optional>
+#include <span>
 #include <vk_mem_alloc.h>
 
+#include "vulkan_deletion_queue.h"
+#include "vulkan_memory.h"
+
 namespace Posideon {
     class VulkanDevice;
     
@@ -12,6 +17,8 @@ namespace Posideon {
         VkBuffer buffer;
         VmaAllocation allocation;
         VmaAllocationInfo allocation_info;
+        VkDeviceSize size;
+        VkBufferUsageFlags usage;
     };
 
     struct VulkanImage {
@@ -46,12 +53,14 @@ namespace Posideon {
         VkImageLayout initial_layout;
         VkImageViewType image_view_type;
         VkImageAspectFlags aspect_mask;
+        uint32_t mip_levels = 1;
     };
 
     struct ImageViewDescriptor {
         VkImageViewType image_view_type;
         VkFormat format;
         VkImageAspectFlags aspect_mask;
+        uint32_t mip_levels = 1;
     };
 
     struct DescriptorAllocator {
@@ -83,13 +92,29 @@ namespace Posideon {
         VulkanPhysicalDevice m_physicalDevice;
         VkDevice m_device;
         VmaAllocator m_allocator;
+        // Shared by every pipeline the device creates. Vulkan synchronises the cache internally, so pipelines
+        // may be created from job threads.
+        VkPipelineCache m_pipeline_cache = VK_NULL_HANDLE;
+        mutable DeletionQueue m_deletion_queue;
+        std::atomic<uint64_t> m_frame_number = 0;
+        mutable std::array<uint64_t, MEMORY_CATEGORY_COUNT> m_category_usage {};
+        mutable std::array<std::atomic<uint64_t>, VK_MAX_MEMORY_HEAPS> m_retiring_bytes {};
+        MemoryBudgetPolicy m_budget_policy;
 
     private:
         [[nodiscard]] std::optional<uint32_t> get_memory_type_index(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+        void set_object_name(VkObjectType object_type, uint64_t handle, const char* name) const;
+        void track_allocation(VmaAllocation allocation, int64_t sign) const;
+        void track_retiring(VmaAllocation allocation, int64_t sign) const;
+        uint64_t evict(MemoryCategory category, uint64_t bytes_to_free) const;
 
     public:
         VulkanDevice(VulkanPhysicalDevice const& physical_device, VkDevice device, VmaAllocator allocator):
             m_physicalDevice(physical_device), m_device(device), m_allocator(allocator) {}
+        VulkanDevice(const VulkanDevice&) = delete;
+        VulkanDevice& operator=(const VulkanDevice&) = delete;
+        VulkanDevice(VulkanDevice&&) = delete;
+        VulkanDevice& operator=(VulkanDevice&&) = delete;
 
         [[nodiscard]] VkQueue get_queue() const;
         [[nodiscard]] VkSurfaceCapabilitiesKHR get_physical_device_surface_capabilities(VkSurfaceKHR surface) const;
@@ -98,33 +123,65 @@ namespace Posideon {
         [[nodiscard]] std::vector<VkImage> get_swapchain_images(VkSwapchainKHR swapchain) const;
         [[nodiscard]] VkDeviceAddress get_buffer_address(const VulkanBuffer& buffer) const; 
 
-        [[nodiscard]] std::vector<VkCommandBuffer> allocate_command_buffers(VkCommandPool command_pool, uint32_t buffer_count) const;
-        [[nodiscard]] VkSwapchainKHR create_swapchain(const VkSwapchainCreateInfoKHR& create_info) const;
-        [[nodiscard]] VkCommandPool create_command_pool() const;
-        [[nodiscard]] VkSemaphore create_semaphore() const;
-        [[nodiscard]] VkFence create_fence(bool signaled) const;
-        [[nodiscard]] VkPipelineLayout create_pipeline_layout(const std::vector<VkDescriptorSetLayout>& set_layouts,  const std::vector<VkPushConstantRange>& push_constants) const;
-        [[nodiscard]] VkPipeline create_graphics_pipeline(const VkGraphicsPipelineCreateInfo& descriptor) const;
-        [[nodiscard]] VkPipeline create_compute_pipeline(const ComputePipelineDescriptor& descriptor) const;
-        [[nodiscard]] VkShaderModule create_shader_module(const std::vector<char>& code) const;
-        [[nodiscard]] VkDescriptorPool create_descriptor_pool(const std::vector<VkDescriptorPoolSize>& pool_sizes) const;
-        [[nodiscard]] VkDescriptorSetLayout create_descriptor_set_layout(const std::vector<VkDescriptorSetLayoutBinding>& bindings) const;
-        [[nodiscard]] VulkanImage create_image(const ImageDescriptor& descriptor) const;
-        [[nodiscard]] VkImageView create_image_view(VkImage image, const ImageViewDescriptor& descriptor) const;
-        [[nodiscard]] VulkanBuffer create_buffer(size_t alloc_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) const;
+        [[nodiscard]] std::vector<VkCommandBuffer> allocate_command_buffers(VkCommandPool command_pool, uint32_t buffer_count, const char* name = nullptr, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY) const;
+        [[nodiscard]] VkSwapchainKHR create_swapchain(const VkSwapchainCreateInfoKHR& create_info, const char* name = nullptr) const;
+        [[nodiscard]] VkCommandPool create_command_pool(const char* name = nullptr) const;
+        [[nodiscard]] VkSemaphore create_semaphore(const char* name = nullptr) const;
+        [[nodiscard]] VkFence create_fence(bool signaled, const char* name = nullptr) const;
+        // Data saved by an incompatible driver or device is ignored by Vulkan and the cache starts out empty.
+        void create_pipeline_cache(std::span<const char> initial_data);
+        [[nodiscard]] std::vector<char> get_pipeline_cache_data() const;
+        [[nodiscard]] VkPipelineLayout create_pipeline_layout(const std::vector<VkDescriptorSetLayout>& set_layouts,  const std::vector<VkPushConstantRange>& push_constants, const char* name = nullptr) const;
+        [[nodiscard]] VkPipeline create_graphics_pipeline(const VkGraphicsPipelineCreateInfo& descriptor, const char* name = nullptr) const;
+        [[nodiscard]] VkPipeline create_compute_pipeline(const ComputePipelineDescriptor& descriptor, const char* name = nullptr) const;
+        [[nodiscard]] VkShaderModule create_shader_module(const std::vector<char>& code, const char* name = nullptr) const;
+        [[nodiscard]] VkDescriptorPool create_descriptor_pool(const std::vector<VkDescriptorPoolSize>& pool_sizes, const char* name = nullptr) const;
+        [[nodiscard]] VkDescriptorSetLayout create_descriptor_set_layout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, const char* name = nullptr) const;
+        [[nodiscard]] VulkanImage create_image(const ImageDescriptor& descriptor, MemoryCategory category, const char* name = nullptr) const;
+        [[nodiscard]] VkImageView create_image_view(VkImage image, const ImageViewDescriptor& descriptor, const char* name = nullptr) const;
+        [[nodiscard]] VulkanBuffer create_buffer(size_t alloc_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage, MemoryCategory category, const char* name = nullptr) const;
+        [[nodiscard]] VkSampler create_sampler(const VkSamplerCreateInfo& create_info, const char* name = nullptr) const;
 
         uint32_t acquire_next_image(VkSwapchainKHR swapchain, VkSemaphore semaphore) const;
         VkResult wait_for_fence(VkFence fence);
         VkResult reset_fence(VkFence fence);
+        void wait_idle() const;
         void reset_descriptor_pool(VkDescriptorPool pool) const;
         std::vector<VkDescriptorSet> allocate_descriptor_sets(VkDescriptorPool descriptor_pool, const std::vector<VkDescriptorSetLayout>& descriptor_layouts) const;
         void update_descriptor_sets(VkDescriptorSet set, VkDescriptorType descriptor_type, uint32_t binding, VkDescriptorBufferInfo* buffer_info, VkDescriptorImageInfo* image_info) const;
         void map_memory(VulkanBuffer buffer, VkDeviceSize size, void** data) const;
         void unmap_memory(VulkanBuffer buffer) const;
+        // Make host writes visible to the device and device writes visible to the host. Both are no-ops on
+        // host coherent memory, GPU_TO_CPU allocations are often cached but not coherent.
+        void flush_buffer(const VulkanBuffer& buffer) const;
+        void invalidate_buffer(const VulkanBuffer& buffer) const;
 
+        void destroy_image(VulkanImage image) const;
         void destroy_image_view(VkImageView image_view) const;
         void destroy_swapchain(VkSwapchainKHR swapchain) const;
         void destroy_buffer(VulkanBuffer buffer) const;
         void destroy_descriptor_pool(VkDescriptorPool pool) const;
+        void destroy_descriptor_set_layout(VkDescriptorSetLayout layout) const;
+        void destroy_pipeline(VkPipeline pipeline) const;
+        void destroy_pipeline_layout(VkPipelineLayout layout) const;
+        void destroy_shader_module(VkShaderModule shader_module) const;
+        void destroy_command_pool(VkCommandPool pool) const;
+        void destroy_fence(VkFence fence) const;
+        void destroy_sampler(VkSampler sampler) const;
+        void destroy_semaphore(VkSemaphore semaphore) const;
+        void destroy();
+
+        void begin_frame(uint64_t frame_number, uint32_t frames_in_flight);
+        void retire(std::function<void()>&& deletor) const;
+        void retire_buffer(VulkanBuffer buffer) const;
+        void retire_image(VulkanImage image) const;
+        void retire_pipeline(VkPipeline pipeline) const;
+        void retire_pipeline_layout(VkPipelineLayout layout) const;
+        void flush_deletion_queue() const;
+
+        [[nodiscard]] MemoryBudgetReport query_memory_budget() const;
+        void set_memory_budget_policy(MemoryBudgetPolicy policy);
+        void register_evictor(MemoryCategory category, EvictionCallback&& evictor);
+        uint64_t enforce_memory_budget(const MemoryBudgetReport& report) const;
     };
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "vulkan_geometry_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Posideon {
+    PackedIndices pack_indices(const std::vector<uint32_t>& indices, const std::vector<MeshSurface>& surfaces) {
+        PackedIndices packed;
+        packed.surfaces.reserve(surfaces.size());
+        for (const MeshSurface& surface : surfaces) {
+            const auto first = indices.begin() + surface.start_index;
+            const auto last = first + surface.count;
+            const uint32_t max_index = surface.count > 0 ? *std::max_element(first, last) : 0;
+            const VkIndexType index_type = max_index <= UINT16_MAX ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+            // Every surface starts on the pool's index alignment so its first index is exact for either type.
+            const size_t offset = (packed.data.size() + GeometryPool::INDEX_ALIGNMENT - 1) & ~(GeometryPool::INDEX_ALIGNMENT - 1);
+            packed.data.resize(offset + surface.count * index_size(index_type));
+            if (index_type == VK_INDEX_TYPE_UINT16) {
+                uint16_t* out = reinterpret_cast<uint16_t*>(packed.data.data() + offset);
+                std::transform(first, last, out, [](uint32_t index) { return static_cast<uint16_t>(index); });
+            } else {
+                memcpy(packed.data.data() + offset, indices.data() + surface.start_index, surface.count * sizeof(uint32_t));
+            }
+
+            packed.surfaces.push_back(GPUSurface {
+                .index_type = index_type,
+                .index_offset = offset,
+                .index_count = surface.count,
+                .vertex_offset = static_cast<int32_t>(surface.first_vertex)
+            });
+        }
+        packed.data.resize((packed.data.size() + GeometryPool::INDEX_ALIGNMENT - 1) & ~(GeometryPool::INDEX_ALIGNMENT - 1));
+        return packed;
+    }
+
+    uint32_t index_size(VkIndexType index_type) {
+        return index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
+    GPUMeshBuffers::~GPUMeshBuffers() {
+        if (pool != nullptr) {
+            pool->retire_vertices(vertices);
+            pool->retire_indices(indices);
+        }
+    }
+
+    uint32_t GPUMeshBuffers::first_index(const GPUSurface& surface) const {
+        return static_cast<uint32_t>((indices.offset + surface.index_offset) / index_size(surface.index_type));
+    }
+
+    int32_t GPUMeshBuffers::base_vertex(const GPUSurface& surface) const {
+        return vertex_offset + surface.vertex_offset;
+    }
+
+    void GeometryPool::init(const VulkanDevice& device, VkDeviceSize vertex_capacity, VkDeviceSize index_capacity) {
+        m_device = &device;
+        m_vertex_buffer = create_vertex_buffer(vertex_capacity);
+        m_index_buffer = create_index_buffer(index_capacity);
+        m_vertex_address = device.get_buffer_address(m_vertex_buffer.get());
+        m_vertex_ranges = RangeAllocator(vertex_capacity);
+        m_index_ranges = RangeAllocator(index_capacity);
+    }
+
+    void GeometryPool::destroy() {
+        m_vertex_buffer.reset();
+        m_index_buffer.reset();
+        m_vertex_address = 0;
+    }
+
+    UniqueBuffer GeometryPool::create_vertex_buffer(VkDeviceSize size) const {
+        return { *m_device, m_device->create_buffer(
+            size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY,
+            MemoryCategory::Mesh,
+            "geometry_pool_vertices"
+        ) };
+    }
+
+    UniqueBuffer GeometryPool::create_index_buffer(VkDeviceSize size) const {
+        return { *m_device, m_device->create_buffer(
+            size,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY,
+            MemoryCategory::Mesh,
+            "geometry_pool_indices"
+        ) };
+    }
+
+    std::optional<GeometryRange> GeometryPool::allocate_vertices(VkDeviceSize size, VkDeviceSize stride) {
+        const std::optional<uint64_t> offset = m_vertex_ranges.allocate(size, stride);
+        if (!offset) {
+            return {};
+        }
+        return GeometryRange { *offset, size };
+    }
+
+    std::optional<GeometryRange> GeometryPool::allocate_indices(VkDeviceSize size) {
+        const std::optional<uint64_t> offset = m_index_ranges.allocate(size, INDEX_ALIGNMENT);
+        if (!offset) {
+            return {};
+        }
+        return GeometryRange { *offset, size };
+    }
+
+    void GeometryPool::free_vertices(GeometryRange range) {
+        m_vertex_ranges.free(range.offset, range.size);
+    }
+
+    void GeometryPool::free_indices(GeometryRange range) {
+        m_index_ranges.free(range.offset, range.size);
+    }
+
+    void GeometryPool::retire_vertices(GeometryRange range) {
+        m_device->retire([this, range] { free_vertices(range); });
+    }
+
+    void GeometryPool::retire_indices(GeometryRange range) {
+        m_device->retire([this, range] { free_indices(range); });
+    }
+
+    void GeometryPool::grow(const VulkanCommandEncoder& encoder, VkDeviceSize min_vertex_capacity, VkDeviceSize min_index_capacity) {
+        const VkDeviceSize vertex_capacity = m_vertex_ranges.capacity();
+        if (min_vertex_capacity > vertex_capacity) {
+            const VkDeviceSize new_capacity = std::max(vertex_capacity * 2, min_vertex_capacity);
+            UniqueBuffer grown = create_vertex_buffer(new_capacity);
+            encoder.copy_buffer_to_buffer(m_vertex_buffer->buffer, grown->buffer, vertex_capacity, 0, 0);
+            m_vertex_buffer = std::move(grown);
+            m_vertex_address = m_device->get_buffer_address(m_vertex_buffer.get());
+            m_vertex_ranges.grow(new_capacity);
+        }
+
+        const VkDeviceSize index_capacity = m_index_ranges.capacity();
+        if (min_index_capacity > index_capacity) {
+            const VkDeviceSize new_capacity = std::max(index_capacity * 2, min_index_capacity);
+            UniqueBuffer grown = create_index_buffer(new_capacity);
+            encoder.copy_buffer_to_buffer(m_index_buffer->buffer, grown->buffer, index_capacity, 0, 0);
+            m_index_buffer = std::move(grown);
+            m_index_ranges.grow(new_capacity);
+        }
+    }
+
+    void GeometryPool::bind_index_buffer(const VulkanCommandEncoder& encoder, VkIndexType index_type) const {
+        encoder.bind_index_buffer(m_index_buffer->buffer, index_type);
+    }
+
+    float GeometryPool::fragmentation() const {
+        return std::max(m_vertex_ranges.fragmentation(), m_index_ranges.fragmentation());
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "defines.h"
+#include <optional>
+#include <vector>
+
+#include "core/range_allocator.h"
+#include "vulkan_command_encoder.h"
+#include "vulkan_resources.h"
+
+namespace Posideon {
+    class GeometryPool;
+
+    struct GeometryRange {
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+    };
+
+    // CPU side section of a mesh. Its indices are relative to first_vertex so that small surfaces can be
+    // stored with 16 bit indices even when the mesh as a whole has more vertices.
+    struct MeshSurface {
+        uint32_t start_index = 0;
+        uint32_t count = 0;
+        uint32_t first_vertex = 0;
+        uint32_t meshlet_offset = 0;
+        uint32_t meshlet_count = 0;
+    };
+
+    struct GPUSurface {
+        VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+        VkDeviceSize index_offset = 0;
+        uint32_t index_count = 0;
+        int32_t vertex_offset = 0;
+    };
+
+    struct PackedIndices {
+        std::vector<uint8_t> data;
+        std::vector<GPUSurface> surfaces;
+    };
+
+    [[nodiscard]] PackedIndices pack_indices(const std::vector<uint32_t>& indices, const std::vector<MeshSurface>& surfaces);
+    [[nodiscard]] uint32_t index_size(VkIndexType index_type);
+
+    // A mesh is a pair of ranges inside the global geometry pool rather than a pair of buffers, so the
+    // whole scene can be drawn with a single index buffer bind.
+    struct GPUMeshBuffers {
+        GeometryPool* pool = nullptr;
+        GeometryRange vertices;
+        GeometryRange indices;
+        uint32_t vertex_stride = 0;
+        int32_t vertex_offset = 0;
+        std::vector<GPUSurface> surfaces;
+
+        GPUMeshBuffers() = default;
+        GPUMeshBuffers(const GPUMeshBuffers&) = delete;
+        GPUMeshBuffers& operator=(const GPUMeshBuffers&) = delete;
+        ~GPUMeshBuffers();
+
+        [[nodiscard]] uint32_t first_index(const GPUSurface& surface) const;
+        [[nodiscard]] int32_t base_vertex(const GPUSurface& surface) const;
+    };
+
+    // Meshlets of one mesh plus a cull output buffer per frame in flight. Each output starts with the
+    // indirect draw commands, followed by the visible meshlet list and, for the index buffer fallback,
+    // the expanded indices written by the cull shader at index_offset.
+    struct GPUMeshlets {
+        UniqueBuffer data;
+        std::vector<UniqueBuffer> cull_outputs;
+        VkDeviceAddress meshlets = 0;
+        VkDeviceAddress vertices = 0;
+        VkDeviceAddress triangles = 0;
+        VkDeviceSize index_offset = 0;
+        uint32_t meshlet_count = 0;
+        bool expand_indices = false;
+    };
+
+    // One vertex storage buffer, read through its device address, and one index buffer shared by every
+    // mesh, so a frame binds the index buffer once per index type. Batches are still drawn with one
+    // vkCmdDrawIndexed each. Multi-draw indirect would also need per-draw instance and material data
+    // fetched by draw index, which the mesh pipeline does not do.
+    class GeometryPool {
+        const VulkanDevice* m_device = nullptr;
+        UniqueBuffer m_vertex_buffer;
+        UniqueBuffer m_index_buffer;
+        VkDeviceAddress m_vertex_address = 0;
+        RangeAllocator m_vertex_ranges;
+        RangeAllocator m_index_ranges;
+
+        [[nodiscard]] UniqueBuffer create_vertex_buffer(VkDeviceSize size) const;
+        [[nodiscard]] UniqueBuffer create_index_buffer(VkDeviceSize size) const;
+
+    public:
+        static constexpr VkDeviceSize INDEX_ALIGNMENT = sizeof(uint32_t);
+
+        void init(const VulkanDevice& device, VkDeviceSize vertex_capacity, VkDeviceSize index_capacity);
+        void destroy();
+
+        [[nodiscard]] std::optional<GeometryRange> allocate_vertices(VkDeviceSize size, VkDeviceSize stride);
+        [[nodiscard]] std::optional<GeometryRange> allocate_indices(VkDeviceSize size);
+        void free_vertices(GeometryRange range);
+        void free_indices(GeometryRange range);
+        void retire_vertices(GeometryRange range);
+        void retire_indices(GeometryRange range);
+        void grow(const VulkanCommandEncoder& encoder, VkDeviceSize min_vertex_capacity, VkDeviceSize min_index_capacity);
+
+        void bind_index_buffer(const VulkanCommandEncoder& encoder, VkIndexType index_type) const;
+
+        [[nodiscard]] const VulkanBuffer& vertex_buffer() const { return m_vertex_buffer.get(); }
+        [[nodiscard]] const VulkanBuffer& index_buffer() const { return m_index_buffer.get(); }
+        [[nodiscard]] VkDeviceAddress vertex_address() const { return m_vertex_address; }
+        [[nodiscard]] float fragmentation() const;
+    };
+}
@@ -52,6 +52,10 @@ namespace Posideon {
         return debug_messenger;
     }
 
+    void destroy_debug_messenger(VkInstance instance, VkDebugUtilsMessengerEXT debug_messenger) {
+        destroy_debug_utils_messenger_ext(instance, debug_messenger, nullptr);
+    }
+
     VKAPI_ATTR VkBool32 VKAPI_CALL debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData) {
         std::cout << "Vulkan Validation: " << pCallbackData->pMessage << std::endl;
         return VK_FALSE;
@@ -6,4 +6,5 @@
 namespace Posideon {
     VkInstance init_vulkan_instance();
     VkDebugUtilsMessengerEXT init_debug_messenger(VkInstance instance);
+    void destroy_debug_messenger(VkInstance instance, VkDebugUtilsMessengerEXT debug_messenger);
 }
\ No newline at end of file
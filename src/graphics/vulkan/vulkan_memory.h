@@ -0,0 +1,54 @@
+#pragma once
+
+#include "defines.h"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Posideon {
+    enum class MemoryCategory : uint8_t {
+        Mesh,
+        Texture,
+        RenderTarget,
+        Staging,
+        Other,
+        Count
+    };
+
+    static constexpr size_t MEMORY_CATEGORY_COUNT = static_cast<size_t>(MemoryCategory::Count);
+
+    struct HeapBudget {
+        uint64_t usage;
+        uint64_t budget;
+        bool device_local;
+        // Part of usage already retired, released once the frames that may still use it have finished.
+        uint64_t retiring = 0;
+    };
+
+    struct MemoryBudgetReport {
+        std::vector<HeapBudget> heaps;
+        std::array<uint64_t, MEMORY_CATEGORY_COUNT> category_usage {};
+    };
+
+    // Returns the number of bytes the callback released (or scheduled for release).
+    using EvictionCallback = std::function<uint64_t(uint64_t bytes_to_free)>;
+
+    // Eviction starts when a device local heap goes past eviction_threshold of its budget and frees down to
+    // eviction_target, so the next frame does not start over at the threshold.
+    struct MemoryBudgetPolicy {
+        float eviction_threshold = 0.9f;
+        float eviction_target = 0.8f;
+        std::array<std::vector<EvictionCallback>, MEMORY_CATEGORY_COUNT> evictors;
+    };
+
+    inline const char* memory_category_name(MemoryCategory category) {
+        switch (category) {
+            case MemoryCategory::Mesh: return "mesh";
+            case MemoryCategory::Texture: return "texture";
+            case MemoryCategory::RenderTarget: return "render_target";
+            case MemoryCategory::Staging: return "staging";
+            default: return "other";
+        }
+    }
+}
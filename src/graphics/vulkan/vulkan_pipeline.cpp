@@ -68,6 +68,28 @@ namespace Posideon {
         });
     }
 
+    void GraphicsPipelineBuilder::set_mesh_shaders(VkShaderModule mesh_shader, VkShaderModule fragment_shader) {
+        shader_stages.clear();
+        shader_stages.emplace_back(VkPipelineShaderStageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_MESH_BIT_EXT,
+            .module = mesh_shader,
+            .pName = "main",
+        });
+        shader_stages.emplace_back(VkPipelineShaderStageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = fragment_shader,
+            .pName = "main",
+        });
+    }
+
+    void GraphicsPipelineBuilder::set_specialization(const VkSpecializationInfo* specialization) {
+        for (VkPipelineShaderStageCreateInfo& stage : shader_stages) {
+            stage.pSpecializationInfo = specialization;
+        }
+    }
+
     void GraphicsPipelineBuilder::set_input_topology(VkPrimitiveTopology topology) {
         input_assembly.topology = topology;
         input_assembly.primitiveRestartEnable = VK_FALSE;
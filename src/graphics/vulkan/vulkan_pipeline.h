@@ -28,6 +28,9 @@ namespace Posideon {
         VkGraphicsPipelineCreateInfo build();
 
         void set_shaders(VkShaderModule vertex_shader, VkShaderModule fragment_shader);
+        void set_mesh_shaders(VkShaderModule mesh_shader, VkShaderModule fragment_shader);
+        // Applies to every stage set so far, the info has to outlive build() and pipeline creation.
+        void set_specialization(const VkSpecializationInfo* specialization);
         void set_input_topology(VkPrimitiveTopology topology);
         void set_polygon_mode(VkPolygonMode mode);
         void set_cull_mode(VkCullModeFlags cull_mode, VkFrontFace front_face);
@@ -0,0 +1,56 @@
+#include "vulkan_resources.h"
+#include <utility>
+
+namespace Posideon {
+    UniqueBuffer::UniqueBuffer(UniqueBuffer&& other) noexcept: m_device(other.m_device), m_buffer(other.release()) {}
+
+    UniqueBuffer& UniqueBuffer::operator=(UniqueBuffer&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_device = other.m_device;
+            m_buffer = other.release();
+        }
+        return *this;
+    }
+
+    UniqueBuffer::~UniqueBuffer() {
+        reset();
+    }
+
+    void UniqueBuffer::reset() {
+        if (m_device != nullptr && m_buffer.buffer != VK_NULL_HANDLE) {
+            m_device->retire_buffer(m_buffer);
+        }
+        m_buffer = {};
+    }
+
+    VulkanBuffer UniqueBuffer::release() {
+        return std::exchange(m_buffer, {});
+    }
+
+    UniqueImage::UniqueImage(UniqueImage&& other) noexcept: m_device(other.m_device), m_image(other.release()) {}
+
+    UniqueImage& UniqueImage::operator=(UniqueImage&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_device = other.m_device;
+            m_image = other.release();
+        }
+        return *this;
+    }
+
+    UniqueImage::~UniqueImage() {
+        reset();
+    }
+
+    void UniqueImage::reset() {
+        if (m_device != nullptr && m_image.image != VK_NULL_HANDLE) {
+            m_device->retire_image(m_image);
+        }
+        m_image = {};
+    }
+
+    VulkanImage UniqueImage::release() {
+        return std::exchange(m_image, {});
+    }
+}
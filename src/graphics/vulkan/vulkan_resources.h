@@ -0,0 +1,48 @@
+#pragma once
+
+#include "defines.h"
+#include "vulkan_device.h"
+
+namespace Posideon {
+    class UniqueBuffer {
+        const VulkanDevice* m_device = nullptr;
+        VulkanBuffer m_buffer {};
+
+    public:
+        UniqueBuffer() = default;
+        UniqueBuffer(const VulkanDevice& device, VulkanBuffer buffer): m_device(&device), m_buffer(buffer) {}
+        UniqueBuffer(const UniqueBuffer&) = delete;
+        UniqueBuffer& operator=(const UniqueBuffer&) = delete;
+        UniqueBuffer(UniqueBuffer&& other) noexcept;
+        UniqueBuffer& operator=(UniqueBuffer&& other) noexcept;
+        ~UniqueBuffer();
+
+        void reset();
+        [[nodiscard]] VulkanBuffer release();
+
+        [[nodiscard]] const VulkanBuffer& get() const { return m_buffer; }
+        const VulkanBuffer* operator->() const { return &m_buffer; }
+        explicit operator bool() const { return m_buffer.buffer != VK_NULL_HANDLE; }
+    };
+
+    class UniqueImage {
+        const VulkanDevice* m_device = nullptr;
+        VulkanImage m_image {};
+
+    public:
+        UniqueImage() = default;
+        UniqueImage(const VulkanDevice& device, VulkanImage image): m_device(&device), m_image(image) {}
+        UniqueImage(const UniqueImage&) = delete;
+        UniqueImage& operator=(const UniqueImage&) = delete;
+        UniqueImage(UniqueImage&& other) noexcept;
+        UniqueImage& operator=(UniqueImage&& other) noexcept;
+        ~UniqueImage();
+
+        void reset();
+        [[nodiscard]] VulkanImage release();
+
+        [[nodiscard]] const VulkanImage& get() const { return m_image; }
+        const VulkanImage* operator->() const { return &m_image; }
+        explicit operator bool() const { return m_image.image != VK_NULL_HANDLE; }
+    };
+}
@@ -0,0 +1,199 @@
+#include "vulkan_shader_compiler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <shaderc/shaderc.hpp>
+
+#include "assets/asset_cache.h"
+
+namespace Posideon {
+    namespace {
+        // Bumped whenever the compile options change, so modules built with the old ones are not reused.
+        constexpr uint64_t SHADER_CACHE_VERSION = 1;
+
+        std::optional<shaderc_shader_kind> shader_kind(const std::filesystem::path& path) {
+            const std::filesystem::path extension = path.extension();
+            if (extension == ".vert") {
+                return shaderc_vertex_shader;
+            }
+            if (extension == ".frag") {
+                return shaderc_fragment_shader;
+            }
+            if (extension == ".comp") {
+                return shaderc_compute_shader;
+            }
+            if (extension == ".task") {
+                return shaderc_task_shader;
+            }
+            if (extension == ".mesh") {
+                return shaderc_mesh_shader;
+            }
+            return {};
+        }
+
+        std::optional<std::string> read_text(const std::filesystem::path& path) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open()) {
+                return {};
+            }
+            std::stringstream text;
+            text << file.rdbuf();
+            return text.str();
+        }
+
+        std::optional<std::vector<char>> read_binary(const std::filesystem::path& path) {
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file.is_open()) {
+                return {};
+            }
+            std::vector<char> bytes(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            if (!file.read(bytes.data(), static_cast<std::streamsize>(bytes.size()))) {
+                return {};
+            }
+            return bytes;
+        }
+
+        std::optional<CompiledShader> reflect_shader(const std::string& name, std::vector<char> code) {
+            if (code.size() % sizeof(uint32_t) != 0) {
+                return {};
+            }
+            std::vector<uint32_t> words(code.size() / sizeof(uint32_t));
+            std::memcpy(words.data(), code.data(), code.size());
+            std::optional<ShaderReflection> reflection = reflect_spirv(words);
+            if (!reflection) {
+                return {};
+            }
+            return CompiledShader { .name = name, .code = std::move(code), .reflection = std::move(*reflection) };
+        }
+
+        class ShaderIncluder final : public shaderc::CompileOptions::IncluderInterface {
+            struct Include {
+                std::string name;
+                std::string content;
+            };
+
+            std::filesystem::path m_source_directory;
+
+        public:
+            explicit ShaderIncluder(std::filesystem::path source_directory): m_source_directory(std::move(source_directory)) {}
+
+            shaderc_include_result* GetInclude(const char* requested_source, shaderc_include_type type, const char* requesting_source, size_t) override {
+                std::filesystem::path path = m_source_directory / requested_source;
+                if (type == shaderc_include_type_relative) {
+                    std::filesystem::path relative = std::filesystem::path(requesting_source).parent_path() / requested_source;
+                    std::error_code error;
+                    if (std::filesystem::exists(relative, error)) {
+                        path = std::move(relative);
+                    }
+                }
+
+                // An empty source name tells shaderc the include failed, the content is the error message then.
+                auto* include = new Include;
+                if (std::optional<std::string> text = read_text(path)) {
+                    include->name = path.string();
+                    include->content = std::move(*text);
+                } else {
+                    include->content = "Cannot open " + path.string();
+                }
+                return new shaderc_include_result {
+                    .source_name = include->name.c_str(),
+                    .source_name_length = include->name.size(),
+                    .content = include->content.c_str(),
+                    .content_length = include->content.size(),
+                    .user_data = include,
+                };
+            }
+
+            void ReleaseInclude(shaderc_include_result* result) override {
+                delete static_cast<Include*>(result->user_data);
+                delete result;
+            }
+        };
+    }
+
+    bool is_shader_source(const std::filesystem::path& path) {
+        return shader_kind(path).has_value();
+    }
+
+    ShaderCompiler::ShaderCompiler(std::filesystem::path source_directory, std::filesystem::path cache_directory):
+        m_source_directory(std::move(source_directory)), m_cache_directory(std::move(cache_directory)) {}
+
+    std::optional<CompiledShader> ShaderCompiler::compile(const std::string& name, std::span<const ShaderDefine> defines) const {
+        const std::filesystem::path path = m_source_directory / name;
+        const std::optional<shaderc_shader_kind> kind = shader_kind(path);
+        const std::optional<std::string> source = read_text(path);
+        if (!kind || !source) {
+            std::cout << "Cannot compile shader " << path << std::endl;
+            return {};
+        }
+
+        shaderc::CompileOptions options;
+        options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
+        options.SetOptimizationLevel(optimize ? shaderc_optimization_level_performance : shaderc_optimization_level_zero);
+        options.SetIncluder(std::make_unique<ShaderIncluder>(m_source_directory));
+        for (const ShaderDefine& define : defines) {
+            options.AddMacroDefinition(define.name, define.value);
+        }
+
+        const shaderc::Compiler compiler;
+        const std::string file_name = path.string();
+        const shaderc::PreprocessedSourceCompilationResult preprocessed = compiler.PreprocessGlsl(*source, *kind, file_name.c_str(), options);
+        if (preprocessed.GetCompilationStatus() != shaderc_compilation_status_success) {
+            std::cout << preprocessed.GetErrorMessage() << std::endl;
+            return {};
+        }
+        const std::string expanded(preprocessed.cbegin(), preprocessed.cend());
+
+        const uint64_t key[2] = { SHADER_CACHE_VERSION, optimize ? 1ull : 0ull };
+        uint64_t hash = fnv1a(std::span(reinterpret_cast<const uint8_t*>(name.data()), name.size()));
+        hash = fnv1a(std::span(reinterpret_cast<const uint8_t*>(expanded.data()), expanded.size()), hash);
+        hash = fnv1a(std::span(reinterpret_cast<const uint8_t*>(key), sizeof(key)), hash);
+        char cache_name[24];
+        snprintf(cache_name, sizeof(cache_name), "%016llx.spv", static_cast<unsigned long long>(hash));
+        const std::filesystem::path cache_path = m_cache_directory / cache_name;
+        if (std::optional<std::vector<char>> cached = read_binary(cache_path)) {
+            if (std::optional<CompiledShader> shader = reflect_shader(name, std::move(*cached))) {
+                return shader;
+            }
+        }
+
+        const shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(expanded, *kind, file_name.c_str(), options);
+        if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+            std::cout << result.GetErrorMessage() << std::endl;
+            return {};
+        }
+        const std::vector<uint32_t> words(result.cbegin(), result.cend());
+        std::vector<char> code(words.size() * sizeof(uint32_t));
+        std::memcpy(code.data(), words.data(), code.size());
+
+        // Written to a per-thread temporary name first so a concurrent or interrupted compile never leaves a torn
+        // module behind. Pipeline pre-warm compiles the same permutation from several jobs at once.
+        std::error_code error;
+        std::filesystem::create_directories(m_cache_directory, error);
+        std::filesystem::path temporary = cache_path;
+        temporary += "." + std::to_string(std::hash<std::thread::id> {}(std::this_thread::get_id())) + ".tmp";
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(code.data(), static_cast<std::streamsize>(code.size()));
+        file.close();
+        if (file) {
+            std::filesystem::rename(temporary, cache_path, error);
+        } else {
+            std::cout << "Failed to write shader cache " << cache_path << std::endl;
+            std::filesystem::remove(temporary, error);
+        }
+
+        std::optional<CompiledShader> shader = reflect_shader(name, std::move(code));
+        if (!shader) {
+            std::cout << "Failed to reflect shader " << name << std::endl;
+        }
+        return shader;
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "defines.h"
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "graphics/vulkan/vulkan_shader_reflection.h"
+
+namespace Posideon {
+    struct ShaderDefine {
+        std::string name;
+        std::string value;
+    };
+
+    struct CompiledShader {
+        std::string name;
+        std::vector<char> code;
+        ShaderReflection reflection;
+    };
+
+    // Compiles GLSL from the source directory with shaderc, the stage is taken from the file extension.
+    // #include "file" resolves next to the including file first and then in the source directory.
+    // Sources are preprocessed on every call and the expanded text, which already has the includes and
+    // defines applied, is hashed into the name of the cached module. An edit to any included file or a
+    // different permutation therefore misses the cache while unchanged shaders skip compilation entirely.
+    // Each call uses its own shaderc compiler, so compiles may run on several threads at once.
+    class ShaderCompiler {
+        std::filesystem::path m_source_directory;
+        std::filesystem::path m_cache_directory;
+
+    public:
+        bool optimize = true;
+
+        ShaderCompiler(std::filesystem::path source_directory, std::filesystem::path cache_directory);
+
+        // name is relative to the source directory, such as "mesh.vert". Errors are logged.
+        [[nodiscard]] std::optional<CompiledShader> compile(const std::string& name, std::span<const ShaderDefine> defines = {}) const;
+
+        [[nodiscard]] const std::filesystem::path& source_directory() const { return m_source_directory; }
+        [[nodiscard]] const std::filesystem::path& cache_directory() const { return m_cache_directory; }
+    };
+
+    [[nodiscard]] bool is_shader_source(const std::filesystem::path& path);
+}
@@ -0,0 +1,323 @@
+#include "vulkan_shader_reflection.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+
+namespace Posideon {
+    namespace {
+        constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+        constexpr uint32_t SPIRV_HEADER_WORDS = 5;
+        constexpr uint32_t UNDECORATED = std::numeric_limits<uint32_t>::max();
+
+        // The subset of the SPIR-V grammar needed to recover descriptor bindings and push constant blocks.
+        enum SpirvOp : uint32_t {
+            OP_ENTRY_POINT = 15,
+            OP_TYPE_VOID = 19,
+            OP_TYPE_BOOL = 20,
+            OP_TYPE_INT = 21,
+            OP_TYPE_FLOAT = 22,
+            OP_TYPE_VECTOR = 23,
+            OP_TYPE_MATRIX = 24,
+            OP_TYPE_IMAGE = 25,
+            OP_TYPE_SAMPLER = 26,
+            OP_TYPE_SAMPLED_IMAGE = 27,
+            OP_TYPE_ARRAY = 28,
+            OP_TYPE_RUNTIME_ARRAY = 29,
+            OP_TYPE_STRUCT = 30,
+            OP_TYPE_POINTER = 32,
+            OP_TYPE_FORWARD_POINTER = 39,
+            OP_CONSTANT = 43,
+            OP_VARIABLE = 59,
+            OP_DECORATE = 71,
+            OP_MEMBER_DECORATE = 72,
+            OP_TYPE_ACCELERATION_STRUCTURE = 5341,
+        };
+
+        enum SpirvDecoration : uint32_t {
+            DECORATION_BUFFER_BLOCK = 3,
+            DECORATION_ARRAY_STRIDE = 6,
+            DECORATION_MATRIX_STRIDE = 7,
+            DECORATION_BINDING = 33,
+            DECORATION_DESCRIPTOR_SET = 34,
+            DECORATION_OFFSET = 35,
+        };
+
+        enum SpirvStorageClass : uint32_t {
+            STORAGE_UNIFORM_CONSTANT = 0,
+            STORAGE_UNIFORM = 2,
+            STORAGE_PUSH_CONSTANT = 9,
+            STORAGE_STORAGE_BUFFER = 12,
+        };
+
+        constexpr uint32_t DIM_BUFFER = 5;
+        constexpr uint32_t DIM_SUBPASS_DATA = 6;
+        constexpr uint32_t IMAGE_STORAGE = 2;
+
+        struct SpirvMember {
+            uint32_t offset = 0;
+            uint32_t matrix_stride = 0;
+        };
+
+        // Decorations arrive before the declarations they apply to, so both are gathered per id.
+        struct SpirvId {
+            uint32_t opcode = 0;
+            std::span<const uint32_t> instruction;
+            uint32_t set = UNDECORATED;
+            uint32_t binding = UNDECORATED;
+            uint32_t array_stride = 0;
+            bool buffer_block = false;
+            std::vector<SpirvMember> members;
+        };
+
+        class SpirvModule {
+            std::vector<SpirvId> m_ids;
+
+        public:
+            explicit SpirvModule(uint32_t bound): m_ids(bound) {}
+
+            [[nodiscard]] bool valid(uint32_t id) const { return id < m_ids.size(); }
+            [[nodiscard]] SpirvId& operator[](uint32_t id) { return m_ids[id]; }
+            [[nodiscard]] const SpirvId& operator[](uint32_t id) const { return m_ids[id]; }
+
+            [[nodiscard]] uint32_t constant(uint32_t id) const {
+                const SpirvId& value = m_ids[id];
+                return value.opcode == OP_CONSTANT && value.instruction.size() > 3 ? value.instruction[3] : 1;
+            }
+
+            // Sizes follow the explicit layout decorations, which is what push constant blocks are laid out with.
+            [[nodiscard]] uint32_t type_size(uint32_t id, uint32_t matrix_stride = 0) const {
+                const SpirvId& type = m_ids[id];
+                const std::span<const uint32_t> words = type.instruction;
+                switch (type.opcode) {
+                    case OP_TYPE_BOOL:
+                        return 4;
+                    case OP_TYPE_INT:
+                    case OP_TYPE_FLOAT:
+                        return words[2] / 8;
+                    case OP_TYPE_VECTOR:
+                        return type_size(words[2]) * words[3];
+                    case OP_TYPE_MATRIX:
+                        return words[3] * (matrix_stride != 0 ? matrix_stride : type_size(words[2]));
+                    case OP_TYPE_ARRAY:
+                        return (type.array_stride != 0 ? type.array_stride : type_size(words[2])) * constant(words[3]);
+                    case OP_TYPE_STRUCT: {
+                        uint32_t size = 0;
+                        for (uint32_t member = 0; member + 2 < words.size(); member++) {
+                            const SpirvMember layout = member < type.members.size() ? type.members[member] : SpirvMember {};
+                            size = std::max(size, layout.offset + type_size(words[member + 2], layout.matrix_stride));
+                        }
+                        return size;
+                    }
+                    // Only physical storage buffer pointers can be members of a block.
+                    case OP_TYPE_POINTER:
+                    case OP_TYPE_FORWARD_POINTER:
+                        return 8;
+                    default:
+                        return 0;
+                }
+            }
+        };
+
+        std::optional<VkShaderStageFlagBits> execution_stage(uint32_t model) {
+            switch (model) {
+                case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+                case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+                case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+                case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+                case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+                case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+                case 5364: return VK_SHADER_STAGE_TASK_BIT_EXT;
+                case 5365: return VK_SHADER_STAGE_MESH_BIT_EXT;
+                default: return {};
+            }
+        }
+
+        std::optional<VkDescriptorType> descriptor_type(uint32_t storage, const SpirvId& type) {
+            if (storage == STORAGE_STORAGE_BUFFER || (storage == STORAGE_UNIFORM && type.buffer_block)) {
+                return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            }
+            if (storage == STORAGE_UNIFORM) {
+                return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            }
+            if (storage != STORAGE_UNIFORM_CONSTANT) {
+                return {};
+            }
+            switch (type.opcode) {
+                case OP_TYPE_SAMPLER:
+                    return VK_DESCRIPTOR_TYPE_SAMPLER;
+                case OP_TYPE_SAMPLED_IMAGE:
+                    return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                case OP_TYPE_ACCELERATION_STRUCTURE:
+                    return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+                case OP_TYPE_IMAGE: {
+                    const uint32_t dim = type.instruction[3];
+                    const bool storage_image = type.instruction[7] == IMAGE_STORAGE;
+                    if (dim == DIM_SUBPASS_DATA) {
+                        return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                    }
+                    if (dim == DIM_BUFFER) {
+                        return storage_image ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                    }
+                    return storage_image ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                }
+                default:
+                    return {};
+            }
+        }
+    }
+
+    std::optional<ShaderReflection> reflect_spirv(std::span<const uint32_t> words) {
+        if (words.size() < SPIRV_HEADER_WORDS || words[0] != SPIRV_MAGIC) {
+            return {};
+        }
+
+        SpirvModule module(words[3]);
+        std::optional<VkShaderStageFlagBits> stage;
+        uint32_t entry_points = 0;
+        std::vector<uint32_t> variables;
+        for (size_t offset = SPIRV_HEADER_WORDS; offset < words.size();) {
+            const uint32_t word_count = words[offset] >> 16;
+            const uint32_t opcode = words[offset] & 0xffff;
+            if (word_count == 0 || offset + word_count > words.size()) {
+                return {};
+            }
+            const std::span<const uint32_t> instruction = words.subspan(offset, word_count);
+            offset += word_count;
+
+            if (opcode == OP_ENTRY_POINT && word_count > 2) {
+                stage = execution_stage(instruction[1]);
+                entry_points++;
+            } else if (opcode == OP_DECORATE && word_count > 2 && module.valid(instruction[1])) {
+                SpirvId& target = module[instruction[1]];
+                const uint32_t value = word_count > 3 ? instruction[3] : 0;
+                switch (instruction[2]) {
+                    case DECORATION_DESCRIPTOR_SET: target.set = value; break;
+                    case DECORATION_BINDING: target.binding = value; break;
+                    case DECORATION_ARRAY_STRIDE: target.array_stride = value; break;
+                    case DECORATION_BUFFER_BLOCK: target.buffer_block = true; break;
+                    default: break;
+                }
+            } else if (opcode == OP_MEMBER_DECORATE && word_count > 4 && module.valid(instruction[1])) {
+                std::vector<SpirvMember>& members = module[instruction[1]].members;
+                const uint32_t member = instruction[2];
+                if (members.size() <= member) {
+                    members.resize(member + 1);
+                }
+                if (instruction[3] == DECORATION_OFFSET) {
+                    members[member].offset = instruction[4];
+                } else if (instruction[3] == DECORATION_MATRIX_STRIDE) {
+                    members[member].matrix_stride = instruction[4];
+                }
+            } else if ((opcode == OP_CONSTANT || opcode == OP_VARIABLE) && word_count > 3 && module.valid(instruction[2])) {
+                module[instruction[2]].opcode = opcode;
+                module[instruction[2]].instruction = instruction;
+                if (opcode == OP_VARIABLE) {
+                    variables.push_back(instruction[2]);
+                }
+            } else if (((opcode >= OP_TYPE_VOID && opcode <= OP_TYPE_FORWARD_POINTER) || opcode == OP_TYPE_ACCELERATION_STRUCTURE) &&
+                word_count > 1 && module.valid(instruction[1])) {
+                module[instruction[1]].opcode = opcode;
+                module[instruction[1]].instruction = instruction;
+            }
+        }
+        if (!stage || entry_points != 1) {
+            return {};
+        }
+
+        ShaderReflection reflection { .stage = *stage };
+        std::map<uint32_t, std::vector<VkDescriptorSetLayoutBinding>> sets;
+        for (const uint32_t id : variables) {
+            const SpirvId& variable = module[id];
+            const uint32_t storage = variable.instruction[3];
+            const SpirvId& pointer = module[variable.instruction[1]];
+            if (pointer.opcode != OP_TYPE_POINTER || !module.valid(pointer.instruction[3])) {
+                continue;
+            }
+            uint32_t type_id = pointer.instruction[3];
+
+            if (storage == STORAGE_PUSH_CONSTANT) {
+                const SpirvId& block = module[type_id];
+                if (block.opcode != OP_TYPE_STRUCT || block.members.empty()) {
+                    continue;
+                }
+                const auto first = std::ranges::min_element(block.members, {}, &SpirvMember::offset);
+                reflection.push_constants = VkPushConstantRange {
+                    .stageFlags = static_cast<VkShaderStageFlags>(*stage),
+                    .offset = first->offset,
+                    .size = module.type_size(type_id) - first->offset,
+                };
+                continue;
+            }
+            if (variable.set == UNDECORATED || variable.binding == UNDECORATED) {
+                continue;
+            }
+
+            // Runtime arrays reflect as a single descriptor, the engine has no variable count sets.
+            uint32_t count = 1;
+            while (module[type_id].opcode == OP_TYPE_ARRAY || module[type_id].opcode == OP_TYPE_RUNTIME_ARRAY) {
+                const SpirvId& array = module[type_id];
+                if (array.opcode == OP_TYPE_ARRAY) {
+                    count *= module.constant(array.instruction[3]);
+                }
+                type_id = array.instruction[2];
+            }
+            const std::optional<VkDescriptorType> type = descriptor_type(storage, module[type_id]);
+            if (!type) {
+                continue;
+            }
+            sets[variable.set].push_back(VkDescriptorSetLayoutBinding {
+                .binding = variable.binding,
+                .descriptorType = *type,
+                .descriptorCount = count,
+                .stageFlags = static_cast<VkShaderStageFlags>(*stage),
+            });
+        }
+
+        for (auto& [set, bindings] : sets) {
+            std::ranges::sort(bindings, {}, &VkDescriptorSetLayoutBinding::binding);
+            reflection.sets.push_back(ShaderDescriptorSet { .set = set, .bindings = std::move(bindings) });
+        }
+        return reflection;
+    }
+
+    ShaderLayout merge_shader_layouts(std::span<const ShaderReflection> stages) {
+        std::map<uint32_t, std::map<uint32_t, VkDescriptorSetLayoutBinding>> sets;
+        std::optional<VkPushConstantRange> push_constants;
+        for (const ShaderReflection& stage : stages) {
+            for (const ShaderDescriptorSet& set : stage.sets) {
+                for (const VkDescriptorSetLayoutBinding& binding : set.bindings) {
+                    auto [existing, inserted] = sets[set.set].try_emplace(binding.binding, binding);
+                    if (!inserted) {
+                        existing->second.stageFlags |= binding.stageFlags;
+                        existing->second.descriptorCount = std::max(existing->second.descriptorCount, binding.descriptorCount);
+                    }
+                }
+            }
+            if (!stage.push_constants) {
+                continue;
+            }
+            if (!push_constants) {
+                push_constants = stage.push_constants;
+                continue;
+            }
+            const uint32_t begin = std::min(push_constants->offset, stage.push_constants->offset);
+            const uint32_t end = std::max(push_constants->offset + push_constants->size, stage.push_constants->offset + stage.push_constants->size);
+            push_constants->stageFlags |= stage.push_constants->stageFlags;
+            push_constants->offset = begin;
+            push_constants->size = end - begin;
+        }
+
+        ShaderLayout layout;
+        for (const auto& [set, bindings] : sets) {
+            ShaderDescriptorSet& merged = layout.sets.emplace_back(ShaderDescriptorSet { .set = set });
+            for (const auto& [index, binding] : bindings) {
+                merged.bindings.push_back(binding);
+            }
+        }
+        if (push_constants) {
+            layout.push_constants.push_back(*push_constants);
+        }
+        return layout;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+namespace Posideon {
+    struct ShaderDescriptorSet {
+        uint32_t set;
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+    };
+
+    // Interface of one SPIR-V module. The push constant range covers the members the module declares, so a
+    // block that starts with layout(offset = N) reflects from N.
+    struct ShaderReflection {
+        VkShaderStageFlagBits stage;
+        std::vector<ShaderDescriptorSet> sets;
+        std::optional<VkPushConstantRange> push_constants;
+    };
+
+    // What a pipeline layout needs for a set of stages, sets sorted by index.
+    struct ShaderLayout {
+        std::vector<ShaderDescriptorSet> sets;
+        std::vector<VkPushConstantRange> push_constants;
+    };
+
+    // Walks the module's declarations, no instruction bodies are interpreted. Returns nothing for data that
+    // is not a SPIR-V module with a single entry point.
+    [[nodiscard]] std::optional<ShaderReflection> reflect_spirv(std::span<const uint32_t> words);
+
+    // Bindings shared between stages are merged into one with the union of their stage flags. Push constants
+    // become a single range over every stage's declared block, which keeps vkCmdPushConstants to one call
+    // with the combined stage flags.
+    [[nodiscard]] ShaderLayout merge_shader_layouts(std::span<const ShaderReflection> stages);
+}
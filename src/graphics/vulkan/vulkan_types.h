@@ -5,6 +5,7 @@
 #include <glm/glm.hpp>
 
 #include "vulkan_device.h"
+#include "vulkan_geometry_pool.h"
 
 namespace Posideon {
     struct Vertex {
@@ -15,9 +16,19 @@ namespace Posideon {
         glm::vec4 color;
     };
 
-    struct GPUMeshBuffers {
-        VulkanBuffer index_buffer;
-        VulkanBuffer vertex_buffer;
-        VkDeviceAddress vertex_buffer_address;
+    // 16 byte layout decoded by mesh.vert with QUANTIZED_VERTICES. Positions are unorm16 relative to the mesh bounds,
+    // normals are octahedral snorm16 and UVs are half floats. The color is RGB565 in the high half of position_z_color,
+    // shaders never read vertex alpha.
+    struct CompactVertex {
+        uint32_t position_xy;
+        uint32_t position_z_color;
+        uint32_t normal;
+        uint32_t uv;
+    };
+    static_assert(sizeof(CompactVertex) == 16);
+
+    enum class VertexFormat : uint8_t {
+        Full,
+        Compact
     };
 }
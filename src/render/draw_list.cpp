@@ -0,0 +1,45 @@
+#include "draw_list.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+namespace Posideon {
+    uint64_t make_sort_key(uint32_t pipeline, uint32_t material, uint32_t mesh, float depth) {
+        // Non-negative IEEE floats order the same as their bit patterns, the top bits keep that order.
+        const uint32_t depth_bits = std::bit_cast<uint32_t>(std::max(depth, 0.0f)) >> 7;
+        return (static_cast<uint64_t>(pipeline & 0xff) << 56) |
+            (static_cast<uint64_t>(material & 0xffff) << 40) |
+            (static_cast<uint64_t>(mesh & 0xffff) << 24) |
+            static_cast<uint64_t>(depth_bits & 0xffffff);
+    }
+
+    void DrawList::sort() {
+        const size_t count = m_entries.size();
+        if (count < 2) {
+            return;
+        }
+        m_scratch.resize(count);
+
+        for (uint32_t shift = 0; shift < 64; shift += 8) {
+            std::array<size_t, 256> offsets {};
+            for (const DrawListEntry& entry : m_entries) {
+                offsets[(entry.key >> shift) & 0xff]++;
+            }
+            if (offsets[(m_entries[0].key >> shift) & 0xff] == count) {
+                continue;
+            }
+
+            size_t sum = 0;
+            for (size_t& offset : offsets) {
+                const size_t bucket = offset;
+                offset = sum;
+                sum += bucket;
+            }
+            for (const DrawListEntry& entry : m_entries) {
+                m_scratch[offsets[(entry.key >> shift) & 0xff]++] = entry;
+            }
+            m_entries.swap(m_scratch);
+        }
+    }
+}
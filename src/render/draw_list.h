@@ -0,0 +1,31 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <vector>
+
+namespace Posideon {
+    // Key layout from the most significant bit: 8 bits pipeline, 16 bits material, 16 bits mesh, 24 bits depth.
+    // Sorting by key groups draws by the state that is most expensive to change and goes front to back
+    // within a group.
+    [[nodiscard]] uint64_t make_sort_key(uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+    struct DrawListEntry {
+        uint64_t key;
+        uint32_t draw;
+    };
+
+    class DrawList {
+        std::vector<DrawListEntry> m_entries;
+        std::vector<DrawListEntry> m_scratch;
+
+    public:
+        void clear() { m_entries.clear(); }
+        void push(uint64_t key, uint32_t draw) { m_entries.push_back(DrawListEntry { key, draw }); }
+
+        // Stable LSD radix sort over the key bytes. Passes where every key shares the same byte are skipped.
+        void sort();
+
+        [[nodiscard]] const std::vector<DrawListEntry>& entries() const { return m_entries; }
+    };
+}
@@ -0,0 +1,146 @@
+#include "frustum_culling.h"
+
+#include <bit>
+
+#if defined(__AVX2__)
+#define POSIDEON_CULLING_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define POSIDEON_CULLING_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Posideon {
+    Frustum extract_frustum(const ExtractedView& view) {
+        // Gribb-Hartmann on the transposed view projection, clip space depth is [0, w] in either direction
+        // so the reversed depth range needs no special case.
+        const glm::mat4 m = glm::transpose(view.projection * view.view);
+        Frustum frustum {
+            .planes = {
+                m[3] + m[0],
+                m[3] - m[0],
+                m[3] + m[1],
+                m[3] - m[1],
+                m[2],
+                m[3] - m[2],
+            }
+        };
+        for (glm::vec4& plane : frustum.planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return frustum;
+    }
+
+    void CullingBounds::clear() {
+        m_center_x.clear();
+        m_center_y.clear();
+        m_center_z.clear();
+        m_radius.clear();
+        m_ids.clear();
+    }
+
+    void CullingBounds::reserve(size_t count) {
+        m_center_x.reserve(count);
+        m_center_y.reserve(count);
+        m_center_z.reserve(count);
+        m_radius.reserve(count);
+        m_ids.reserve(count);
+    }
+
+    void CullingBounds::push(const glm::vec3& center, float radius, uint64_t id) {
+        m_center_x.push_back(center.x);
+        m_center_y.push_back(center.y);
+        m_center_z.push_back(center.z);
+        m_radius.push_back(radius);
+        m_ids.push_back(id);
+    }
+
+    namespace {
+        // Scalar path, also used for the tail that does not fill a full group of eight.
+        bool sphere_visible(const Frustum& frustum, float x, float y, float z, float radius) {
+            for (const glm::vec4& plane : frustum.planes) {
+                if (plane.x * x + plane.y * y + plane.z * z + plane.w < -radius) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void push_mask(uint32_t mask, uint32_t base, std::vector<uint32_t>& visible) {
+            while (mask != 0) {
+                visible.push_back(base + static_cast<uint32_t>(std::countr_zero(mask)));
+                mask &= mask - 1;
+            }
+        }
+
+#if defined(POSIDEON_CULLING_AVX2)
+        constexpr uint32_t GROUP_SIZE = 8;
+
+        uint32_t sphere_mask(const Frustum& frustum, const float* x, const float* y, const float* z, const float* r) {
+            const __m256 cx = _mm256_loadu_ps(x);
+            const __m256 cy = _mm256_loadu_ps(y);
+            const __m256 cz = _mm256_loadu_ps(z);
+            const __m256 neg_radius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(r));
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (const glm::vec4& plane : frustum.planes) {
+                __m256 distance = _mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(plane.x)), _mm256_set1_ps(plane.w));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(cy, _mm256_set1_ps(plane.y)));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(cz, _mm256_set1_ps(plane.z)));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, neg_radius, _CMP_GE_OQ));
+            }
+            return static_cast<uint32_t>(_mm256_movemask_ps(inside));
+        }
+#elif defined(POSIDEON_CULLING_SSE2)
+        constexpr uint32_t GROUP_SIZE = 8;
+
+        uint32_t sphere_mask4(const Frustum& frustum, const float* x, const float* y, const float* z, const float* r) {
+            const __m128 cx = _mm_loadu_ps(x);
+            const __m128 cy = _mm_loadu_ps(y);
+            const __m128 cz = _mm_loadu_ps(z);
+            const __m128 neg_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(r));
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const glm::vec4& plane : frustum.planes) {
+                __m128 distance = _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_set1_ps(plane.w));
+                distance = _mm_add_ps(distance, _mm_mul_ps(cy, _mm_set1_ps(plane.y)));
+                distance = _mm_add_ps(distance, _mm_mul_ps(cz, _mm_set1_ps(plane.z)));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, neg_radius));
+            }
+            return static_cast<uint32_t>(_mm_movemask_ps(inside));
+        }
+
+        uint32_t sphere_mask(const Frustum& frustum, const float* x, const float* y, const float* z, const float* r) {
+            return sphere_mask4(frustum, x, y, z, r) | (sphere_mask4(frustum, x + 4, y + 4, z + 4, r + 4) << 4);
+        }
+#else
+        constexpr uint32_t GROUP_SIZE = 1;
+
+        uint32_t sphere_mask(const Frustum& frustum, const float* x, const float* y, const float* z, const float* r) {
+            return sphere_visible(frustum, *x, *y, *z, *r) ? 1 : 0;
+        }
+#endif
+    }
+
+    void cull_spheres(const CullingBounds& bounds, const Frustum& frustum, std::vector<uint32_t>& visible) {
+        const uint32_t count = static_cast<uint32_t>(bounds.size());
+        uint32_t i = 0;
+        for (; i + GROUP_SIZE <= count; i += GROUP_SIZE) {
+            const uint32_t mask = sphere_mask(frustum, &bounds.m_center_x[i], &bounds.m_center_y[i], &bounds.m_center_z[i], &bounds.m_radius[i]);
+            push_mask(mask, i, visible);
+        }
+        for (; i < count; i++) {
+            if (sphere_visible(frustum, bounds.m_center_x[i], bounds.m_center_y[i], bounds.m_center_z[i], bounds.m_radius[i])) {
+                visible.push_back(i);
+            }
+        }
+    }
+
+    const char* culling_kernel_name() {
+#if defined(POSIDEON_CULLING_AVX2)
+        return "avx2";
+#elif defined(POSIDEON_CULLING_SSE2)
+        return "sse2";
+#else
+        return "scalar";
+#endif
+    }
+}
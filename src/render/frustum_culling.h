@@ -0,0 +1,44 @@
+#pragma once
+
+#include "defines.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "scene/camera.h"
+
+namespace Posideon {
+    // World space planes as (normal, distance) with normals pointing into the frustum.
+    struct Frustum {
+        std::array<glm::vec4, 6> planes;
+    };
+
+    [[nodiscard]] Frustum extract_frustum(const ExtractedView& view);
+
+    // World space bounding spheres kept as one array per component so the culling kernel can load eight
+    // objects with a single instruction per component.
+    class CullingBounds {
+        std::vector<float> m_center_x;
+        std::vector<float> m_center_y;
+        std::vector<float> m_center_z;
+        std::vector<float> m_radius;
+        std::vector<uint64_t> m_ids;
+
+    public:
+        void clear();
+        void reserve(size_t count);
+        void push(const glm::vec3& center, float radius, uint64_t id);
+
+        [[nodiscard]] size_t size() const { return m_ids.size(); }
+        [[nodiscard]] uint64_t id(size_t index) const { return m_ids[index]; }
+
+        friend void cull_spheres(const CullingBounds& bounds, const Frustum& frustum, std::vector<uint32_t>& visible);
+    };
+
+    // Appends the indices of the objects that intersect the frustum. The kernel is picked at compile time,
+    // AVX2 tests eight objects per iteration, SSE2 two groups of four, anything else falls back to scalar.
+    void cull_spheres(const CullingBounds& bounds, const Frustum& frustum, std::vector<uint32_t>& visible);
+
+    [[nodiscard]] const char* culling_kernel_name();
+}
@@ -0,0 +1,127 @@
+#include "hot_reloader.h"
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+
+#include "assets/gltf_loader.h"
+#include "render/renderer.h"
+#include "scene/mesh_renderer.h"
+
+namespace Posideon {
+    HotReloader::HotReloader(Renderer& renderer, JobSystem& jobs, const std::filesystem::path& root): m_renderer(renderer), m_jobs(jobs) {
+        m_watcher = std::make_unique<FileWatcher>(root, [this](const std::vector<std::filesystem::path>& changed) {
+            on_changes(changed);
+        });
+    }
+
+    HotReloader::~HotReloader() {
+        m_watcher.reset();
+        std::vector<JobHandle> pending;
+        {
+            std::lock_guard lock(m_mutex);
+            pending = std::move(m_pending);
+        }
+        for (const JobHandle& job : pending) {
+            m_jobs.wait(job);
+        }
+    }
+
+    void HotReloader::submit(std::function<void()> job) {
+        std::lock_guard lock(m_mutex);
+        std::erase_if(m_pending, [this](const JobHandle& pending) { return m_jobs.is_done(pending); });
+        m_pending.push_back(m_jobs.submit(std::move(job)));
+    }
+
+    void HotReloader::on_changes(const std::vector<std::filesystem::path>& changed) {
+        for (const std::filesystem::path& path : changed) {
+            const std::filesystem::path extension = path.extension();
+            if (is_shader_source(path)) {
+                submit([this, name = path.filename().string()] {
+                    compile_shader(name);
+                });
+            } else if (extension == ".glsl") {
+                // Any source may include the file, the cache skips those whose expanded text is unchanged.
+                std::error_code error;
+                for (const auto& entry : std::filesystem::directory_iterator(m_renderer.shader_compiler.source_directory(), error)) {
+                    if (is_shader_source(entry.path())) {
+                        submit([this, name = entry.path().filename().string()] {
+                            compile_shader(name);
+                        });
+                    }
+                }
+            } else if (extension == ".glb" || extension == ".gltf") {
+                submit([this, path] {
+                    std::optional<BakedScene> scene = bake_gltf_scene(path, m_jobs);
+                    if (!scene) {
+                        return;
+                    }
+                    std::lock_guard lock(m_mutex);
+                    std::erase_if(m_scenes, [&](const auto& pending) { return pending.first == path; });
+                    m_scenes.emplace_back(path, std::move(*scene));
+                });
+            }
+        }
+    }
+
+    // Compiling every built variant here leaves their modules in the shader cache, so rebuilding the pipelines
+    // in apply() only preprocesses the sources. Failed compiles are logged and keep the current pipelines.
+    void HotReloader::compile_shader(const std::string& name) {
+        if (!m_renderer.compile_shader_variants(name)) {
+            return;
+        }
+        std::lock_guard lock(m_mutex);
+        if (std::ranges::find(m_shaders, name) == m_shaders.end()) {
+            m_shaders.push_back(name);
+        }
+    }
+
+    void HotReloader::apply() {
+        std::vector<std::string> shaders;
+        std::vector<std::pair<std::filesystem::path, BakedScene>> scenes;
+        {
+            std::lock_guard lock(m_mutex);
+            shaders = std::move(m_shaders);
+            scenes = std::move(m_scenes);
+            m_shaders.clear();
+            m_scenes.clear();
+        }
+
+        for (const std::string& shader : shaders) {
+            m_renderer.reload_shader(shader);
+        }
+        for (const auto& [path, scene] : scenes) {
+            for (std::shared_ptr<GltfAsset>& asset : reload_gltf_scene(&m_renderer, path, scene)) {
+                const MeshBounds bounds = asset_bounds(*asset);
+                std::lock_guard lock(m_mutex);
+                m_bounds.emplace_back(std::move(asset), bounds);
+            }
+        }
+    }
+
+    void HotReloader::apply_bounds(flecs::world& world) {
+        std::unordered_map<const GltfAsset*, MeshBounds> reloaded;
+        {
+            std::lock_guard lock(m_mutex);
+            for (const auto& [asset, bounds] : m_bounds) {
+                reloaded.insert_or_assign(asset.get(), bounds);
+            }
+            m_bounds.clear();
+        }
+        if (reloaded.empty()) {
+            return;
+        }
+
+        std::vector<std::pair<flecs::entity, MeshBounds>> updates;
+        world.each([&](flecs::entity entity, const MeshRenderer& mesh) {
+            if (const auto bounds = reloaded.find(mesh.asset.get()); bounds != reloaded.end()) {
+                updates.emplace_back(entity, bounds->second);
+            }
+        });
+        for (const auto& [entity, bounds] : updates) {
+            entity.set<MeshBounds>(bounds);
+        }
+    }
+}
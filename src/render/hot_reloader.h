@@ -0,0 +1,53 @@
+#pragma once
+
+#include "defines.h"
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <flecs.h>
+
+#include "assets/mesh_cache.h"
+#include "core/file_watcher.h"
+#include "core/job_system.h"
+#include "scene/bounds.h"
+
+namespace Posideon {
+    struct Renderer;
+
+    // Reloads shaders and glTF meshes when their files change under the asset root. Shader sources are compiled
+    // and .glb/.gltf files are rebaked on the job system, so the render thread only creates pipelines and uploads
+    // the result in apply(). A changed .glsl include recompiles every shader source.
+    class HotReloader {
+        Renderer& m_renderer;
+        JobSystem& m_jobs;
+
+        std::mutex m_mutex;
+        std::vector<std::string> m_shaders;
+        std::vector<std::pair<std::filesystem::path, BakedScene>> m_scenes;
+        // Bounds of reloaded assets, computed by apply() and handed to the world by apply_bounds().
+        std::vector<std::pair<std::shared_ptr<GltfAsset>, MeshBounds>> m_bounds;
+        std::vector<JobHandle> m_pending;
+        // Created last and reset first, its callback submits the jobs the destructor waits for.
+        std::unique_ptr<FileWatcher> m_watcher;
+
+        void on_changes(const std::vector<std::filesystem::path>& changed);
+        void submit(std::function<void()> job);
+        void compile_shader(const std::string& name);
+
+    public:
+        HotReloader(Renderer& renderer, JobSystem& jobs, const std::filesystem::path& root);
+        HotReloader(const HotReloader&) = delete;
+        HotReloader& operator=(const HotReloader&) = delete;
+        ~HotReloader();
+
+        // Swaps in everything that finished since the last call. Runs on the render thread before a frame is
+        // recorded, replaced pipelines and buffers are retired through the device's deletion queue.
+        void apply();
+        // Resets the MeshBounds of every entity drawing a reloaded asset, so the scene BVH refits them. Runs on
+        // the thread that owns the world, before the BVH is updated.
+        void apply_bounds(flecs::world& world);
+    };
+}
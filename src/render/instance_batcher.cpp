@@ -0,0 +1,104 @@
+#include "instance_batcher.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+#include "scene/bounds.h"
+
+namespace Posideon {
+    void InstanceBatcher::build(const std::vector<MeshInstance>& instances, const ExtractedView& view, float viewport_height,
+        const LodSelectionSettings& lod_settings, bool use_meshlets) {
+        m_instance_data.clear();
+        m_batches.clear();
+        m_meshlet_draws.clear();
+
+        std::unordered_map<const GltfAsset*, uint32_t> asset_instances;
+        for (const MeshInstance& instance : instances) {
+            asset_instances[instance.asset.get()]++;
+        }
+
+        struct Entry {
+            const GltfAsset* asset;
+            uint32_t surface;
+            uint32_t lod;
+            uint32_t instance;
+            float depth;
+        };
+
+        // Instances are culled as a whole against the sphere enclosing all of their surfaces.
+        m_bounds.clear();
+        for (uint32_t i = 0; i < instances.size(); i++) {
+            const MeshBounds bounds = transform_bounds(asset_bounds(*instances[i].asset), instances[i].transform);
+            m_bounds.push(bounds.center, bounds.radius, i);
+        }
+        m_visible.clear();
+        cull_spheres(m_bounds, extract_frustum(view), m_visible);
+
+        std::vector<Entry> entries;
+        std::vector<uint32_t> lods;
+        const glm::vec3 camera = glm::inverse(view.view)[3];
+        for (const uint32_t i : m_visible) {
+            const GltfAsset* asset = instances[i].asset.get();
+            lods.resize(asset->surfaces.size());
+            for (size_t s = 0; s < asset->surfaces.size(); s++) {
+                lods[s] = select_lod(asset->surface_lods[s], asset->lods, instances[i].transform, view, viewport_height, lod_settings);
+            }
+
+            const auto surface_depth = [&](size_t s) {
+                return glm::length(glm::vec3(instances[i].transform * glm::vec4(asset->surface_lods[s].center, 1.0f)) - camera);
+            };
+
+            // Meshlets only cover the full detail surfaces, and the cull output is per asset.
+            const bool full_detail = std::all_of(lods.begin(), lods.end(), [](uint32_t lod) { return lod == 0; });
+            if (use_meshlets && asset->meshlet_buffers && full_detail && asset_instances[asset] == 1) {
+                float depth = std::numeric_limits<float>::max();
+                for (size_t s = 0; s < lods.size(); s++) {
+                    depth = std::min(depth, surface_depth(s));
+                }
+                m_meshlet_draws.push_back(MeshletDraw { asset, instances[i].transform, i, depth });
+                continue;
+            }
+            for (uint32_t s = 0; s < lods.size(); s++) {
+                entries.push_back(Entry { asset, s, lods[s], i, surface_depth(s) });
+            }
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            if (a.asset != b.asset) {
+                return a.asset < b.asset;
+            }
+            if (a.surface != b.surface) {
+                return a.surface < b.surface;
+            }
+            return a.lod < b.lod;
+        });
+
+        const auto push_instance = [&](uint32_t index) {
+            const MeshInstance& instance = instances[index];
+            m_instance_data.push_back(GPUInstanceData {
+                .model = instance.transform * instance.asset->dequantization,
+                .color = instance.color,
+                .material_id = instance.material_id,
+                .texture = instance.texture.index,
+            });
+            return static_cast<uint32_t>(m_instance_data.size() - 1);
+        };
+
+        for (MeshletDraw& draw : m_meshlet_draws) {
+            draw.instance = push_instance(draw.instance);
+        }
+        for (const Entry& entry : entries) {
+            const uint32_t instance = push_instance(entry.instance);
+            if (!m_batches.empty()) {
+                InstanceBatch& batch = m_batches.back();
+                if (batch.asset == entry.asset && batch.surface == entry.surface && batch.lod == entry.lod) {
+                    batch.instance_count++;
+                    batch.depth = std::min(batch.depth, entry.depth);
+                    continue;
+                }
+            }
+            m_batches.push_back(InstanceBatch { entry.asset, entry.surface, entry.lod, instance, 1, entry.depth });
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "defines.h"
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "assets/gltf_loader.h"
+#include "render/frustum_culling.h"
+#include "render/lod_selection.h"
+#include "scene/camera.h"
+
+namespace Posideon {
+    struct MeshInstance {
+        std::shared_ptr<GltfAsset> asset;
+        glm::mat4 transform { 1.0f };
+        glm::vec4 color { 1.0f };
+        uint32_t material_id = 0;
+        TextureHandle texture;
+    };
+
+    // Read through gl_InstanceIndex in mesh.vert. The model matrix already includes the asset's
+    // dequantization for compact vertices.
+    struct GPUInstanceData {
+        glm::mat4 model;
+        glm::vec4 color;
+        uint32_t material_id;
+        uint32_t texture;
+        uint32_t pad[2];
+    };
+    static_assert(sizeof(GPUInstanceData) == 96);
+
+    // Every instance of the same asset surface at the same LOD, drawn with a single instanced call.
+    struct InstanceBatch {
+        const GltfAsset* asset;
+        uint32_t surface;
+        uint32_t lod;
+        uint32_t first_instance;
+        uint32_t instance_count;
+        // Distance from the camera to the nearest instance's surface bounds.
+        float depth;
+    };
+
+    // An instance drawn through meshlet culling, which works on one instance of an asset per frame.
+    struct MeshletDraw {
+        const GltfAsset* asset;
+        glm::mat4 model;
+        uint32_t instance;
+        float depth;
+    };
+
+    class InstanceBatcher {
+        std::vector<GPUInstanceData> m_instance_data;
+        std::vector<InstanceBatch> m_batches;
+        std::vector<MeshletDraw> m_meshlet_draws;
+        CullingBounds m_bounds;
+        std::vector<uint32_t> m_visible;
+
+    public:
+        void build(const std::vector<MeshInstance>& instances, const ExtractedView& view, float viewport_height,
+            const LodSelectionSettings& lod_settings, bool use_meshlets);
+
+        [[nodiscard]] const std::vector<GPUInstanceData>& instance_data() const { return m_instance_data; }
+        [[nodiscard]] const std::vector<InstanceBatch>& batches() const { return m_batches; }
+        [[nodiscard]] const std::vector<MeshletDraw>& meshlet_draws() const { return m_meshlet_draws; }
+    };
+}
@@ -0,0 +1,29 @@
+#include "lod_selection.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Posideon {
+    float projected_error(float error, float distance, const ExtractedView& view, float viewport_height) {
+        // projection[1][1] is cot(fov_y / 2), which maps a view space height at unit distance to NDC.
+        const float pixels_per_unit = std::abs(view.projection[1][1]) * 0.5f * viewport_height;
+        return error * pixels_per_unit / std::max(distance, 1e-4f);
+    }
+
+    uint32_t select_lod(const SurfaceLods& chain, const std::vector<MeshLod>& lods, const glm::mat4& model,
+        const ExtractedView& view, float viewport_height, const LodSelectionSettings& settings) {
+        const glm::vec3 camera_position = glm::inverse(view.view)[3];
+        const glm::vec3 center = model * glm::vec4(chain.center, 1.0f);
+        const float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+        const float distance = glm::length(center - camera_position) - chain.radius * scale;
+
+        uint32_t level = 0;
+        for (uint32_t i = 1; i <= chain.lod_count; i++) {
+            if (projected_error(lods[chain.lod_offset + i - 1].error * scale, distance, view, viewport_height) > settings.max_screen_error) {
+                break;
+            }
+            level = i;
+        }
+        return level;
+    }
+}
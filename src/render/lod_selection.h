@@ -0,0 +1,22 @@
+#pragma once
+
+#include "defines.h"
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "assets/mesh_simplifier.h"
+#include "scene/camera.h"
+
+namespace Posideon {
+    struct LodSelectionSettings {
+        // Largest geometric error, in pixels, a selected level may show on screen.
+        float max_screen_error = 1.0f;
+    };
+
+    [[nodiscard]] float projected_error(float error, float distance, const ExtractedView& view, float viewport_height);
+
+    // Returns the coarsest level of the chain whose error, projected from the surface bounds nearest the
+    // camera, stays under the threshold. Level 0 is the full detail surface.
+    [[nodiscard]] uint32_t select_lod(const SurfaceLods& chain, const std::vector<MeshLod>& lods, const glm::mat4& model,
+        const ExtractedView& view, float viewport_height, const LodSelectionSettings& settings = {});
+}
@@ -0,0 +1,78 @@
+#include "mesh_defragmenter.h"
+
+#include <algorithm>
+
+namespace Posideon {
+    void MeshDefragmenter::register_mesh(const std::shared_ptr<GPUMeshBuffers>& mesh) {
+        m_meshes.emplace_back(mesh);
+    }
+
+    void MeshDefragmenter::update(GeometryPool& pool, const VulkanCommandEncoder& encoder, bool mesh_shaders) {
+        if (pool.fragmentation() < fragmentation_threshold) {
+            return;
+        }
+
+        std::erase_if(m_meshes, [](const std::weak_ptr<GPUMeshBuffers>& mesh) { return mesh.expired(); });
+        std::vector<std::shared_ptr<GPUMeshBuffers>> meshes;
+        meshes.reserve(m_meshes.size());
+        for (const std::weak_ptr<GPUMeshBuffers>& mesh : m_meshes) {
+            meshes.emplace_back(mesh.lock());
+        }
+
+        const auto label = encoder.scoped_label("mesh_defragmentation");
+        VkDeviceSize moved_bytes = 0;
+
+        // Meshes are visited from the end of the pool, so once one of them finds no lower range the pass stops
+        // sweeping; the first move of a frame may exceed the budget so a single large mesh never stalls compaction.
+
+        std::sort(meshes.begin(), meshes.end(), [](const auto& a, const auto& b) { return a->vertices.offset > b->vertices.offset; });
+        for (const std::shared_ptr<GPUMeshBuffers>& mesh : meshes) {
+            if (moved_bytes > 0 && moved_bytes + mesh->vertices.size > max_bytes_per_frame) {
+                continue;
+            }
+            const std::optional<GeometryRange> vertices = pool.allocate_vertices(mesh->vertices.size, mesh->vertex_stride);
+            if (vertices && vertices->offset < mesh->vertices.offset) {
+                encoder.copy_buffer_to_buffer(pool.vertex_buffer().buffer, pool.vertex_buffer().buffer, vertices->size, mesh->vertices.offset, vertices->offset);
+                pool.retire_vertices(mesh->vertices);
+                mesh->vertices = *vertices;
+                mesh->vertex_offset = static_cast<int32_t>(vertices->offset / mesh->vertex_stride);
+                moved_bytes += vertices->size;
+            } else {
+                if (vertices) {
+                    pool.free_vertices(*vertices);
+                }
+                break;
+            }
+        }
+
+        std::sort(meshes.begin(), meshes.end(), [](const auto& a, const auto& b) { return a->indices.offset > b->indices.offset; });
+        for (const std::shared_ptr<GPUMeshBuffers>& mesh : meshes) {
+            if (moved_bytes > 0 && moved_bytes + mesh->indices.size > max_bytes_per_frame) {
+                continue;
+            }
+            const std::optional<GeometryRange> indices = pool.allocate_indices(mesh->indices.size);
+            if (indices && indices->offset < mesh->indices.offset) {
+                encoder.copy_buffer_to_buffer(pool.index_buffer().buffer, pool.index_buffer().buffer, indices->size, mesh->indices.offset, indices->offset);
+                pool.retire_indices(mesh->indices);
+                mesh->indices = *indices;
+                moved_bytes += indices->size;
+            } else {
+                if (indices) {
+                    pool.free_indices(*indices);
+                }
+                break;
+            }
+        }
+
+        if (moved_bytes > 0) {
+            VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            if (mesh_shaders) {
+                stages |= VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT;
+            }
+            encoder.memory_barrier(
+                VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                stages, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT
+            );
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "defines.h"
+#include <memory>
+#include <vector>
+
+#include "graphics/vulkan/vulkan_command_encoder.h"
+#include "graphics/vulkan/vulkan_types.h"
+
+namespace Posideon {
+    // Incrementally compacts the geometry pool. Meshes are sub-allocated from the pool's two buffers rather
+    // than owning VMA allocations, so VMA defragmentation has nothing to move. Each frame moves at most
+    // max_bytes_per_frame of mesh data into lower free ranges on the frame's command buffer and patches the
+    // owning GPUMeshBuffers. Vertex and index ranges live in separate buffers and are compacted
+    // independently, highest offset first. Vacated ranges go back to the pool through the deletion queue,
+    // so frames in flight keep reading valid data. mesh_shaders extends the barrier after the copies to the
+    // mesh shader stage when meshlets are drawn from the same buffers.
+    class MeshDefragmenter {
+        std::vector<std::weak_ptr<GPUMeshBuffers>> m_meshes;
+
+    public:
+        VkDeviceSize max_bytes_per_frame = 4 * 1024 * 1024;
+        float fragmentation_threshold = 0.25f;
+
+        void register_mesh(const std::shared_ptr<GPUMeshBuffers>& mesh);
+        void update(GeometryPool& pool, const VulkanCommandEncoder& encoder, bool mesh_shaders);
+    };
+}
@@ -0,0 +1,120 @@
+#include "pipeline_variants.h"
+
+#include <algorithm>
+
+namespace Posideon {
+    void PipelineVariants::init(PipelinePermutations permutations, Builder builder) {
+        std::lock_guard lock(m_mutex);
+        m_permutations = std::move(permutations);
+        m_builder = std::move(builder);
+    }
+
+    VkPipeline PipelineVariants::get(JobSystem& jobs, PermutationKey key) {
+        JobHandle pending;
+        {
+            std::lock_guard lock(m_mutex);
+            m_used.insert(key);
+            if (const auto pipeline = m_pipelines.find(key); pipeline != m_pipelines.end()) {
+                return pipeline->second;
+            }
+            if (const auto building = m_building.find(key); building != m_building.end()) {
+                pending = building->second;
+            }
+        }
+        if (pending) {
+            jobs.wait(pending);
+            std::lock_guard lock(m_mutex);
+            const auto pipeline = m_pipelines.find(key);
+            return pipeline != m_pipelines.end() ? pipeline->second : VK_NULL_HANDLE;
+        }
+
+        const VkPipeline pipeline = m_builder(key);
+        std::lock_guard lock(m_mutex);
+        m_pipelines.emplace(key, pipeline);
+        return pipeline;
+    }
+
+    void PipelineVariants::prewarm(JobSystem& jobs, std::span<const PermutationKey> keys) {
+        std::lock_guard lock(m_mutex);
+        for (const PermutationKey key : keys) {
+            if (m_pipelines.contains(key) || m_building.contains(key)) {
+                continue;
+            }
+            // The job is registered under the lock it needs to finish, so it cannot publish before it is known.
+            m_building.emplace(key, jobs.submit([this, key] {
+                const VkPipeline pipeline = m_builder(key);
+                std::lock_guard lock(m_mutex);
+                m_pipelines.emplace(key, pipeline);
+            }));
+        }
+    }
+
+    std::vector<PermutationKey> PipelineVariants::keys() const {
+        std::lock_guard lock(m_mutex);
+        std::vector<PermutationKey> result;
+        for (const auto& [key, pipeline] : m_pipelines) {
+            result.push_back(key);
+        }
+        for (const auto& [key, job] : m_building) {
+            if (!m_pipelines.contains(key)) {
+                result.push_back(key);
+            }
+        }
+        std::ranges::sort(result);
+        return result;
+    }
+
+    std::vector<PermutationKey> PipelineVariants::used_keys() const {
+        std::lock_guard lock(m_mutex);
+        return { m_used.begin(), m_used.end() };
+    }
+
+    std::vector<std::vector<ShaderDefine>> PipelineVariants::module_defines() const {
+        std::lock_guard lock(m_mutex);
+        std::set<PermutationKey> module_keys;
+        for (const auto& [key, pipeline] : m_pipelines) {
+            module_keys.insert(m_permutations.module_key(key));
+        }
+        for (const auto& [key, job] : m_building) {
+            module_keys.insert(m_permutations.module_key(key));
+        }
+        std::vector<std::vector<ShaderDefine>> result;
+        for (const PermutationKey key : module_keys) {
+            result.push_back(m_permutations.defines(key));
+        }
+        return result;
+    }
+
+    void PipelineVariants::wait_for_builds(JobSystem& jobs) {
+        std::vector<JobHandle> pending;
+        {
+            std::lock_guard lock(m_mutex);
+            for (const auto& [key, job] : m_building) {
+                pending.push_back(job);
+            }
+        }
+        for (const JobHandle& job : pending) {
+            jobs.wait(job);
+        }
+    }
+
+    void PipelineVariants::retire(JobSystem& jobs, const VulkanDevice& device) {
+        wait_for_builds(jobs);
+        std::lock_guard lock(m_mutex);
+        for (const auto& [key, pipeline] : m_pipelines) {
+            device.retire_pipeline(pipeline);
+        }
+        m_pipelines.clear();
+        m_building.clear();
+    }
+
+    void PipelineVariants::destroy(JobSystem& jobs, const VulkanDevice& device) {
+        wait_for_builds(jobs);
+        std::lock_guard lock(m_mutex);
+        for (const auto& [key, pipeline] : m_pipelines) {
+            device.destroy_pipeline(pipeline);
+        }
+        m_pipelines.clear();
+        m_building.clear();
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "defines.h"
+#include <functional>
+#include <mutex>
+#include <set>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "core/job_system.h"
+#include "graphics/vulkan/vulkan_device.h"
+#include "render/shader_permutations.h"
+
+namespace Posideon {
+    // Every built variant of one pipeline, keyed by permutation. Variants are pre-warmed on the job system or
+    // built on first use. Building goes through the device's pipeline cache, which Vulkan synchronises, so
+    // pre-warm jobs run alongside rendering. The builder returns VK_NULL_HANDLE when a stage fails to compile,
+    // get() then returns VK_NULL_HANDLE for that key until the variants are retired.
+    class PipelineVariants {
+    public:
+        using Builder = std::function<VkPipeline(PermutationKey key)>;
+
+    private:
+        PipelinePermutations m_permutations;
+        Builder m_builder;
+        mutable std::mutex m_mutex;
+        std::unordered_map<PermutationKey, VkPipeline> m_pipelines;
+        std::unordered_map<PermutationKey, JobHandle> m_building;
+        // Kept across retire() so a reload does not forget what the frame has been binding.
+        std::set<PermutationKey> m_used;
+
+        void wait_for_builds(JobSystem& jobs);
+
+    public:
+        void init(PipelinePermutations permutations, Builder builder);
+
+        // Waits for a pending pre-warm of the key, or builds it on the calling thread if it was never requested.
+        [[nodiscard]] VkPipeline get(JobSystem& jobs, PermutationKey key);
+        void prewarm(JobSystem& jobs, std::span<const PermutationKey> keys);
+        // Every key that has been built or requested for pre-warm, sorted.
+        [[nodiscard]] std::vector<PermutationKey> keys() const;
+        // The keys passed to get(), sorted. These are what the manifest records.
+        [[nodiscard]] std::vector<PermutationKey> used_keys() const;
+        // The defines of every distinct module among keys(), safe to call while variants are being built.
+        [[nodiscard]] std::vector<std::vector<ShaderDefine>> module_defines() const;
+
+        // Retires every variant through the deletion queue once pending builds finish. Call on the render thread.
+        void retire(JobSystem& jobs, const VulkanDevice& device);
+        void destroy(JobSystem& jobs, const VulkanDevice& device);
+
+        [[nodiscard]] const PipelinePermutations& permutations() const { return m_permutations; }
+    };
+}
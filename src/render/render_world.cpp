@@ -0,0 +1,98 @@
+#include "render_world.h"
+
+#include "render/frustum_culling.h"
+#include "scene/bounds.h"
+#include "scene/mesh_renderer.h"
+#include "scene/transform.h"
+
+namespace Posideon {
+    void extract_render_world(flecs::world& world, const SceneBvh& scene_bvh, RenderWorld& render_world) {
+        bool found_camera = false;
+        world.each([&](const Camera& camera, const Transform& transform) {
+            if (!found_camera) {
+                render_world.view = ExtractedView { .projection = camera.projection, .view = glm::inverse(transform.model) };
+                found_camera = true;
+            }
+        });
+
+        render_world.instances.clear();
+        const auto extract = [&](const Transform& transform, const MeshRenderer& mesh) {
+            render_world.instances.push_back(MeshInstance {
+                .asset = mesh.asset,
+                .transform = transform.model,
+                .color = mesh.color,
+                .material_id = mesh.material_id,
+                .texture = mesh.texture,
+            });
+        };
+
+        std::vector<uint32_t> visible;
+        scene_bvh.bvh().query_frustum(extract_frustum(render_world.view), visible);
+        for (const uint32_t object : visible) {
+            const flecs::entity entity = scene_bvh.entity(world, object);
+            const Transform* transform = entity.get<Transform>();
+            const MeshRenderer* mesh = entity.get<MeshRenderer>();
+            if (transform && mesh) {
+                extract(*transform, *mesh);
+            }
+        }
+        world.each([&](flecs::entity entity, const Transform& transform, const MeshRenderer& mesh) {
+            if (!entity.has<MeshBounds>()) {
+                extract(transform, mesh);
+            }
+        });
+    }
+
+    RenderWorld& RenderWorldBuffer::begin_extract() {
+        std::unique_lock lock(m_mutex);
+        // A free slot is one that is neither waiting for the render thread nor being recorded.
+        m_condition.wait(lock, [&] { return !(m_pending && m_rendering); });
+        m_extracting = m_pending == 0u || m_rendering == 0u ? 1 : 0;
+        m_worlds[m_extracting].frame = m_frame++;
+        return m_worlds[m_extracting];
+    }
+
+    void RenderWorldBuffer::publish() {
+        {
+            const std::lock_guard lock(m_mutex);
+            m_pending = m_extracting;
+        }
+        m_condition.notify_all();
+    }
+
+    const RenderWorld* RenderWorldBuffer::acquire() {
+        std::unique_lock lock(m_mutex);
+        m_condition.wait(lock, [&] { return m_pending.has_value() || m_closed; });
+        if (!m_pending) {
+            return nullptr;
+        }
+        m_rendering = m_pending;
+        m_pending.reset();
+        lock.unlock();
+        m_condition.notify_all();
+        return &m_worlds[*m_rendering];
+    }
+
+    void RenderWorldBuffer::release() {
+        {
+            const std::lock_guard lock(m_mutex);
+            m_rendering.reset();
+        }
+        m_condition.notify_all();
+    }
+
+    void RenderWorldBuffer::close() {
+        {
+            const std::lock_guard lock(m_mutex);
+            m_closed = true;
+        }
+        m_condition.notify_all();
+    }
+
+    void RenderWorldBuffer::clear() {
+        const std::lock_guard lock(m_mutex);
+        for (RenderWorld& world : m_worlds) {
+            world.instances.clear();
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "defines.h"
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <flecs.h>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "render/instance_batcher.h"
+#include "scene/camera.h"
+#include "scene/scene_bvh.h"
+
+namespace Posideon {
+    // Everything the renderer reads for one frame, copied out of the flecs world so simulation can move on
+    // while the frame is recorded.
+    struct RenderWorld {
+        uint64_t frame = 0;
+        ExtractedView view {};
+        std::vector<MeshInstance> instances;
+    };
+
+    // Snapshots the first Camera, viewing from its Transform, and every entity with a Transform and MeshRenderer.
+    // Entities with MeshBounds are taken from a frustum query on the scene BVH, so off-screen ones are never
+    // copied. Entities without bounds are always extracted and left to the renderer's culling.
+    void extract_render_world(flecs::world& world, const SceneBvh& scene_bvh, RenderWorld& render_world);
+
+    // Two RenderWorlds handed between the simulation thread, which extracts into one while the render thread
+    // records from the other. The simulation blocks only when it is a full frame ahead.
+    class RenderWorldBuffer {
+        std::array<RenderWorld, 2> m_worlds;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::optional<uint32_t> m_pending;
+        std::optional<uint32_t> m_rendering;
+        uint32_t m_extracting = 0;
+        uint64_t m_frame = 0;
+        bool m_closed = false;
+
+    public:
+        // Simulation thread.
+        [[nodiscard]] RenderWorld& begin_extract();
+        void publish();
+
+        // Render thread, acquire returns nullptr once the buffer is closed and drained.
+        [[nodiscard]] const RenderWorld* acquire();
+        void release();
+
+        void close();
+        void clear();
+    };
+}
@@ -2,20 +2,48 @@
 
 #define VMA_IMPLEMENTATION
 #include <vk_mem_alloc.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <fstream>
+#include <iostream>
+#include <iterator>
+#include <unordered_map>
 #include <glm/gtx/transform.hpp>
 
+#include "core/job_system.h"
 #include "graphics/vulkan/vulkan_command_encoder.h"
+#include "graphics/vulkan/vulkan_debug.h"
 #include "graphics/vulkan/vulkan_instance.h"
 #include "graphics/vulkan/vulkan_pipeline.h"
 
 namespace Posideon {
+    // Marks draw-list entries that index the meshlet draws rather than the instance batches.
+    static constexpr uint32_t MESHLET_DRAW_BIT = 0x80000000;
+
+    // The tracked manifest seeds a fresh checkout, each run then writes what it bound into the shader cache.
+    static constexpr const char* SEED_PERMUTATION_MANIFEST = "../assets/shaders/permutations.txt";
+    static constexpr const char* PERMUTATION_MANIFEST_FILE = "permutations.txt";
+    static constexpr const char* PIPELINE_CACHE_FILE = "pipelines.bin";
+    // Option indices into the permutations built by create_mesh_pipeline and create_meshlet_pipelines.
+    static constexpr size_t MESH_QUANTIZED_VERTICES = 0;
+    static constexpr size_t MESH_DEBUG_VIEW = 1;
+    static constexpr size_t MESHLET_DEBUG_VIEW = 0;
+    // Texture data in a shared staging buffer starts on a multiple of the block size, 16 covers every BC format.
+    static constexpr VkDeviceSize TEXTURE_STAGING_ALIGNMENT = 16;
+
+    static VkDeviceSize align_texture_staging(VkDeviceSize offset) {
+        return (offset + TEXTURE_STAGING_ALIGNMENT - 1) & ~(TEXTURE_STAGING_ALIGNMENT - 1);
+    }
+
     bool check_physical_device(VulkanPhysicalDevice& device, VkSurfaceKHR surface);
-    std::vector<char> readFile(const std::string& filename);
+    bool check_device_extension(const VulkanPhysicalDevice& device, const char* extension);
+    bool check_sampled_format(const VulkanPhysicalDevice& device, VkFormat format);
 
-    Renderer init_renderer(uint32_t width, uint32_t height, Win32Window* window) {
+    std::unique_ptr<Renderer> init_renderer(uint32_t width, uint32_t height, Win32Window* window, JobSystem& jobs) {
         VkInstance instance = init_vulkan_instance();
         VkDebugUtilsMessengerEXT debug_messenger = init_debug_messenger(instance);
+        load_debug_utils(instance);
 
         const VkWin32SurfaceCreateInfoKHR surface_create_info {
             .sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR,
@@ -53,8 +81,39 @@ namespace Posideon {
             .pQueuePriorities = queue_priorities,
         };
         std::vector device_extensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+        const bool memory_budget_supported = check_device_extension(physical_device, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (memory_budget_supported) {
+            device_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+
+        VkPhysicalDeviceMeshShaderFeaturesEXT mesh_shader_features {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT,
+        };
+        bool mesh_shader_supported = check_device_extension(physical_device, VK_EXT_MESH_SHADER_EXTENSION_NAME);
+        if (mesh_shader_supported) {
+            VkPhysicalDeviceFeatures2 features2 {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = &mesh_shader_features,
+            };
+            vkGetPhysicalDeviceFeatures2(physical_device.raw, &features2);
+            mesh_shader_supported = mesh_shader_features.meshShader;
+            mesh_shader_features = VkPhysicalDeviceMeshShaderFeaturesEXT {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT,
+                .meshShader = mesh_shader_supported,
+            };
+        }
+        if (mesh_shader_supported) {
+            device_extensions.push_back(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+            load_mesh_shader_functions(instance);
+        }
+
+        // mesh.frag writes texture streaming feedback.
+        const VkPhysicalDeviceFeatures enabled_features {
+            .fragmentStoresAndAtomics = physical_device.device_features.fragmentStoresAndAtomics,
+        };
         VkPhysicalDeviceVulkan13Features features13 {
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+            .pNext = mesh_shader_supported ? &mesh_shader_features : nullptr,
             .synchronization2 = true,
             .dynamicRendering = true,
         };
@@ -70,7 +129,8 @@ namespace Posideon {
             .queueCreateInfoCount = 1,
             .pQueueCreateInfos = &queue_info,
             .enabledExtensionCount = static_cast<uint32_t>(device_extensions.size()),
-            .ppEnabledExtensionNames = device_extensions.data()
+            .ppEnabledExtensionNames = device_extensions.data(),
+            .pEnabledFeatures = &enabled_features,
         };
 
         VkDevice device;
@@ -78,7 +138,7 @@ namespace Posideon {
         POSIDEON_ASSERT(res == VK_SUCCESS)
 
         VmaAllocatorCreateInfo allocator_create_info {
-            .flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT,
+            .flags = static_cast<VmaAllocatorCreateFlags>(VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT | (memory_budget_supported ? VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : 0)),
             .physicalDevice = physical_device.raw,
             .device = device,
             .instance = instance,
@@ -87,26 +147,31 @@ namespace Posideon {
         res = vmaCreateAllocator(&allocator_create_info, &allocator);
         POSIDEON_ASSERT(res == VK_SUCCESS)
 
-        const VulkanDevice vulkan_device(physical_device, device, allocator);
-        VkQueue graphics_queue = vulkan_device.get_queue();
-
-        Renderer renderer {
+        // Resources created below keep a pointer back to the device, so the renderer must not move after this point.
+        std::unique_ptr<Renderer> renderer(new Renderer {
             .width = width,
             .height = height,
             .instance = instance,
             .debug_messenger = debug_messenger,
             .surface = surface,
             .physical_device = physical_device,
-            .device = vulkan_device,
-            .queue = graphics_queue
-        };
-
-        renderer.create_swapchain();
-        renderer.create_sync_structures();
-        renderer.create_command_structures();
-        renderer.create_descriptors();
-        renderer.create_pipelines();
-        renderer.init_default_data();
+            .device = VulkanDevice(physical_device, device, allocator),
+        });
+        renderer->queue = renderer->device.get_queue();
+        renderer->jobs = &jobs;
+        renderer->mesh_shader_supported = mesh_shader_supported;
+        renderer->bc7_supported = check_sampled_format(physical_device, VK_FORMAT_BC7_UNORM_BLOCK);
+
+        renderer->create_swapchain();
+        renderer->create_sync_structures();
+        renderer->create_command_structures();
+        renderer->create_geometry_pool();
+        renderer->texture_cache.init(renderer->device);
+        renderer->create_texture_streaming();
+        renderer->create_descriptors();
+        renderer->create_pipeline_cache();
+        renderer->create_pipelines();
+        renderer->init_default_data();
 
         return renderer;
     }
@@ -137,7 +202,7 @@ namespace Posideon {
             .clipped = true,
             .oldSwapchain = nullptr,
         };
-        swapchain = device.create_swapchain(swapchain_create_info);
+        swapchain = device.create_swapchain(swapchain_create_info, "swapchain");
         swapchain_images = device.get_swapchain_images(swapchain);
 
         swapchain_image_views.resize(swapchain_images.size());
@@ -146,12 +211,12 @@ namespace Posideon {
                 .image_view_type = VK_IMAGE_VIEW_TYPE_2D,
                 .format = swapchain_format,
                 .aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT
-            });
+            }, "swapchain_image_view");
         }
 
         constexpr auto draw_image_usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
             VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-        draw_image = device.create_image({
+        draw_image = UniqueImage(device, device.create_image({
             .image_type = VK_IMAGE_TYPE_2D,
             .format = VK_FORMAT_R16G16B16A16_SFLOAT,
             .width = width,
@@ -160,9 +225,9 @@ namespace Posideon {
             .initial_layout = VK_IMAGE_LAYOUT_UNDEFINED,
             .image_view_type = VK_IMAGE_VIEW_TYPE_2D,
             .aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT
-        });
+        }, MemoryCategory::RenderTarget, "draw_image"));
 
-        depth_image = device.create_image({
+        depth_image = UniqueImage(device, device.create_image({
             .image_type = VK_IMAGE_TYPE_2D,
             .format = VK_FORMAT_D32_SFLOAT,
             .width = width,
@@ -171,27 +236,52 @@ namespace Posideon {
             .initial_layout = VK_IMAGE_LAYOUT_UNDEFINED,
             .image_view_type = VK_IMAGE_VIEW_TYPE_2D,
             .aspect_mask = VK_IMAGE_ASPECT_DEPTH_BIT
-        });
+        }, MemoryCategory::RenderTarget, "depth_image"));
     }
 
     void Renderer::create_command_structures() {
         for (auto& frame : frames) {
-            frame.command_pool = device.create_command_pool();
-            frame.command_buffer = device.allocate_command_buffers(frame.command_pool, 1)[0];
+            frame.command_pool = device.create_command_pool("frame_command_pool");
+            frame.command_buffer = device.allocate_command_buffers(frame.command_pool, 1, "frame_command_buffer")[0];
+            for (uint32_t chunk = 0; chunk < MAX_RECORD_CHUNKS; chunk++) {
+                frame.record_pools[chunk] = device.create_command_pool("record_command_pool");
+                frame.record_buffers[chunk] = device.allocate_command_buffers(frame.record_pools[chunk], 1, "record_command_buffer", VK_COMMAND_BUFFER_LEVEL_SECONDARY)[0];
+            }
         }
 
-        immediate_command_pool = device.create_command_pool();
-        immediate_command_buffer = device.allocate_command_buffers(immediate_command_pool, 1)[0];
+        immediate_command_pool = device.create_command_pool("immediate_command_pool");
+        immediate_command_buffer = device.allocate_command_buffers(immediate_command_pool, 1, "immediate_command_buffer")[0];
     }
 
     void Renderer::create_sync_structures() {
         for (auto& frame : frames) {
-            frame.render_fence = device.create_fence(true);
-            frame.render_semaphore = device.create_semaphore();
-            frame.swapchain_semaphore = device.create_semaphore();
+            frame.render_fence = device.create_fence(true, "render_fence");
+            frame.render_semaphore = device.create_semaphore("render_semaphore");
+            frame.swapchain_semaphore = device.create_semaphore("swapchain_semaphore");
         }
 
-        immediate_fence = device.create_fence(false);
+        immediate_fence = device.create_fence(false, "immediate_fence");
+    }
+
+    void Renderer::create_geometry_pool() {
+        constexpr VkDeviceSize vertex_capacity = 64 * 1024 * 1024;
+        constexpr VkDeviceSize index_capacity = 16 * 1024 * 1024;
+        geometry_pool.init(device, vertex_capacity, index_capacity);
+    }
+
+    void Renderer::create_texture_streaming() {
+        texture_streamer.init(device);
+        for (FrameData& frame : frames) {
+            frame.texture_feedback = UniqueBuffer(device, device.create_buffer(
+                MAX_STREAMED_TEXTURES * sizeof(uint32_t),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                VMA_MEMORY_USAGE_GPU_TO_CPU,
+                MemoryCategory::Other,
+                "texture_feedback"
+            ));
+            memset(frame.texture_feedback->allocation_info.pMappedData, 0xff, MAX_STREAMED_TEXTURES * sizeof(uint32_t));
+            device.flush_buffer(frame.texture_feedback.get());
+        }
     }
 
     void Renderer::create_descriptors() {
@@ -199,7 +289,8 @@ namespace Posideon {
             { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 }
         };
         global_descriptor_allocator.init_pool(device, 10, sizes);
-        draw_image_set_layout = device.create_descriptor_set_layout({
+        // Matches the set gradient.comp declares, so the reflected gradient layout shares this set layout.
+        draw_image_set_layout = descriptor_set_layout({
             VkDescriptorSetLayoutBinding {
                 .binding = 0,
                 .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
@@ -210,23 +301,68 @@ namespace Posideon {
         draw_image_set = global_descriptor_allocator.allocate(device, draw_image_set_layout);
 
         VkDescriptorImageInfo image_info {
-            .imageView = draw_image.image_view,
+            .imageView = draw_image->image_view,
             .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
         };
         device.update_descriptor_sets(draw_image_set, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 0, nullptr, &image_info);
     }
 
+    VkDescriptorSetLayout Renderer::descriptor_set_layout(const std::vector<VkDescriptorSetLayoutBinding>& bindings) {
+        const auto same_bindings = [&](const std::vector<VkDescriptorSetLayoutBinding>& other) {
+            return std::ranges::equal(bindings, other, [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+                return a.binding == b.binding && a.descriptorType == b.descriptorType && a.descriptorCount == b.descriptorCount && a.stageFlags == b.stageFlags;
+            });
+        };
+        for (const auto& [cached_bindings, layout] : descriptor_set_layouts) {
+            if (same_bindings(cached_bindings)) {
+                return layout;
+            }
+        }
+        const VkDescriptorSetLayout layout = device.create_descriptor_set_layout(bindings, "shared_set_layout");
+        descriptor_set_layouts.emplace_back(bindings, layout);
+        return layout;
+    }
+
+    CompiledShader Renderer::compile_shader(const std::string& name, std::span<const ShaderDefine> defines) const {
+        std::optional<CompiledShader> shader = shader_compiler.compile(name, defines);
+        POSIDEON_ASSERT(shader)
+        return std::move(*shader);
+    }
+
+    // The reflected push constant range is checked against the host struct pushed for it and widened over the
+    // tail padding the host struct may add after the last member.
+    VkPipelineLayout Renderer::create_pipeline_layout(std::initializer_list<const CompiledShader*> stages, uint32_t push_constant_size, const char* name) {
+        std::vector<ShaderReflection> reflections;
+        for (const CompiledShader* stage : stages) {
+            reflections.push_back(stage->reflection);
+        }
+        ShaderLayout layout = merge_shader_layouts(reflections);
+
+        std::vector<VkDescriptorSetLayout> set_layouts;
+        for (const ShaderDescriptorSet& set : layout.sets) {
+            while (set_layouts.size() < set.set) {
+                set_layouts.push_back(descriptor_set_layout({}));
+            }
+            set_layouts.push_back(descriptor_set_layout(set.bindings));
+        }
+        for (VkPushConstantRange& range : layout.push_constants) {
+            POSIDEON_ASSERT(range.offset + range.size <= push_constant_size)
+            range.size = push_constant_size - range.offset;
+        }
+        return device.create_pipeline_layout(set_layouts, layout.push_constants, name);
+    }
+
     void Renderer::create_pipelines() {
         create_background_pipelines();
         create_triangle_pipeline();
         create_mesh_pipeline();
+        create_meshlet_pipelines();
     }
 
     void Renderer::create_background_pipelines() {
-        gradient_layout = device.create_pipeline_layout({ draw_image_set_layout }, {});
-
-        const std::vector<char> gradient_shader_code = readFile("../assets/shaders/gradient.comp.spv");
-        const VkShaderModule gradient_shader = device.create_shader_module(gradient_shader_code);
+        const CompiledShader gradient = compile_shader("gradient.comp");
+        gradient_layout = create_pipeline_layout({ &gradient }, 0, "gradient_layout");
+        const VkShaderModule gradient_shader = device.create_shader_module(gradient.code, "gradient.comp");
 
         const VkPipelineShaderStageCreateInfo shader_stage {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -237,17 +373,19 @@ namespace Posideon {
         gradient_pipeline = device.create_compute_pipeline({
             .shader_stage = shader_stage,
             .layout = gradient_layout,
-        });
+        }, "gradient_pipeline");
+
+        device.destroy_shader_module(gradient_shader);
     }
 
     void Renderer::create_triangle_pipeline() {
-        const std::vector<char> vertex_shader_code = readFile("../assets/shaders/shader.vert.spv");
-        const VkShaderModule vertex_shader = device.create_shader_module(vertex_shader_code);
+        const CompiledShader vertex = compile_shader("shader.vert");
+        const VkShaderModule vertex_shader = device.create_shader_module(vertex.code, "shader.vert");
 
-        const std::vector<char> fragment_shader_code = readFile("../assets/shaders/shader.frag.spv");
-        const VkShaderModule fragment_shader = device.create_shader_module(fragment_shader_code);
+        const CompiledShader fragment = compile_shader("shader.frag");
+        const VkShaderModule fragment_shader = device.create_shader_module(fragment.code, "shader.frag");
 
-        triangle_pipeline_layout = device.create_pipeline_layout({}, {});
+        triangle_pipeline_layout = create_pipeline_layout({ &vertex, &fragment }, 0, "triangle_pipeline_layout");
         GraphicsPipelineBuilder pipeline_builder;
         pipeline_builder.pipeline_layout = triangle_pipeline_layout;
         pipeline_builder.set_shaders(vertex_shader, fragment_shader);
@@ -257,73 +395,538 @@ namespace Posideon {
         pipeline_builder.set_multisampling_none();
         pipeline_builder.disable_blending();
         pipeline_builder.disable_depth_test();
-        pipeline_builder.set_color_attachment_format(draw_image.format);
-        pipeline_builder.set_depth_format(depth_image.format);
-        triangle_pipeline = device.create_graphics_pipeline(pipeline_builder.build());
+        pipeline_builder.set_color_attachment_format(draw_image->format);
+        pipeline_builder.set_depth_format(depth_image->format);
+        triangle_pipeline = device.create_graphics_pipeline(pipeline_builder.build(), "triangle_pipeline");
+
+        device.destroy_shader_module(vertex_shader);
+        device.destroy_shader_module(fragment_shader);
     }
 
     void Renderer::create_mesh_pipeline() {
-        const std::vector<char> vertex_shader_code = readFile("../assets/shaders/mesh.vert.spv");
-        const VkShaderModule vertex_shader = device.create_shader_module(vertex_shader_code);
+        PipelinePermutations permutations {
+            .name = "mesh",
+            .options = {
+                ShaderOption { .name = "QUANTIZED_VERTICES", .kind = ShaderOptionKind::Define },
+                ShaderOption { .name = "DEBUG_VIEW", .kind = ShaderOptionKind::Specialization, .value_count = static_cast<uint32_t>(DebugView::Count), .constant_id = 0 },
+            },
+        };
+        const PermutationKey compact_key = permutations.with(0, MESH_QUANTIZED_VERTICES, 1);
+
+        // Both vertex layouts declare the same block, so every variant is compatible with the shared layout.
+        const CompiledShader vertex = compile_shader("mesh.vert", permutations.defines(0));
+        const CompiledShader compact_vertex = compile_shader("mesh.vert", permutations.defines(compact_key));
+        const CompiledShader fragment = compile_shader("mesh.frag");
+        mesh_pipeline_layout = create_pipeline_layout({ &vertex, &compact_vertex, &fragment }, sizeof(GPUDrawPushConstants), "mesh_pipeline_layout");
+
+        mesh_variants.init(permutations, [this, permutations, layout = mesh_pipeline_layout](PermutationKey key) {
+            const std::vector<ShaderDefine> defines = permutations.defines(key);
+            const std::optional<CompiledShader> vertex = shader_compiler.compile("mesh.vert", defines);
+            const std::optional<CompiledShader> fragment = shader_compiler.compile("mesh.frag", defines);
+            if (!vertex || !fragment) {
+                return VkPipeline(VK_NULL_HANDLE);
+            }
+            const VkShaderModule vertex_shader = device.create_shader_module(vertex->code, "mesh.vert");
+            const VkShaderModule fragment_shader = device.create_shader_module(fragment->code, "mesh.frag");
+
+            const ShaderSpecialization specialization = permutations.specialization(key);
+            const VkSpecializationInfo specialization_info = specialization.info();
+            GraphicsPipelineBuilder pipeline_builder;
+            pipeline_builder.pipeline_layout = layout;
+            pipeline_builder.set_shaders(vertex_shader, fragment_shader);
+            pipeline_builder.set_specialization(&specialization_info);
+            pipeline_builder.set_input_topology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+            pipeline_builder.set_polygon_mode(VK_POLYGON_MODE_FILL);
+            pipeline_builder.set_cull_mode(VK_CULL_MODE_NONE, VK_FRONT_FACE_CLOCKWISE);
+            pipeline_builder.set_multisampling_none();
+            pipeline_builder.disable_blending();
+            pipeline_builder.enable_depth_test(true, VK_COMPARE_OP_GREATER_OR_EQUAL);
+            pipeline_builder.set_color_attachment_format(draw_image->format);
+            pipeline_builder.set_depth_format(depth_image->format);
+            const std::string name = "mesh_pipeline " + permutations.format(key);
+            const VkPipeline pipeline = device.create_graphics_pipeline(pipeline_builder.build(), name.c_str());
+
+            device.destroy_shader_module(vertex_shader);
+            device.destroy_shader_module(fragment_shader);
+            return pipeline;
+        });
+        const PermutationKey defaults[] = { 0, compact_key };
+        prewarm_variants(mesh_variants, defaults);
+    }
 
-        const std::vector<char> fragment_shader_code = readFile("../assets/shaders/shader.frag.spv");
-        const VkShaderModule fragment_shader = device.create_shader_module(fragment_shader_code);
+    void Renderer::create_meshlet_pipelines() {
+        const CompiledShader cull = compile_shader("meshlet_cull.comp");
+        const VkShaderModule cull_shader = device.create_shader_module(cull.code, "meshlet_cull.comp");
+
+        meshlet_cull_layout = create_pipeline_layout({ &cull }, sizeof(GPUMeshletCullPushConstants), "meshlet_cull_layout");
+        meshlet_cull_pipeline = device.create_compute_pipeline({
+            .shader_stage = VkPipelineShaderStageCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = cull_shader,
+                .pName = "main"
+            },
+            .layout = meshlet_cull_layout,
+        }, "meshlet_cull_pipeline");
+        device.destroy_shader_module(cull_shader);
+
+        if (!mesh_shader_supported) {
+            return;
+        }
 
-        VkPushConstantRange buffer_range {
-            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
-            .offset = 0,
-            .size = sizeof(GPUDrawPushConstants),
+        PipelinePermutations permutations {
+            .name = "meshlet",
+            .options = {
+                ShaderOption { .name = "DEBUG_VIEW", .kind = ShaderOptionKind::Specialization, .value_count = static_cast<uint32_t>(DebugView::Count), .constant_id = 0 },
+            },
         };
 
-        mesh_pipeline_layout = device.create_pipeline_layout({}, { buffer_range });
-        GraphicsPipelineBuilder pipeline_builder;
-        pipeline_builder.pipeline_layout = mesh_pipeline_layout;
-        pipeline_builder.set_shaders(vertex_shader, fragment_shader);
-        pipeline_builder.set_input_topology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
-        pipeline_builder.set_polygon_mode(VK_POLYGON_MODE_FILL);
-        pipeline_builder.set_cull_mode(VK_CULL_MODE_NONE, VK_FRONT_FACE_CLOCKWISE);
-        pipeline_builder.set_multisampling_none();
-        pipeline_builder.disable_blending();
-        pipeline_builder.enable_depth_test(true, VK_COMPARE_OP_GREATER_OR_EQUAL);
-        pipeline_builder.set_color_attachment_format(draw_image.format);
-        pipeline_builder.set_depth_format(depth_image.format);
-        mesh_pipeline = device.create_graphics_pipeline(pipeline_builder.build());
+        const CompiledShader mesh = compile_shader("meshlet.mesh");
+        const CompiledShader fragment = compile_shader("mesh.frag");
+        meshlet_mesh_layout = create_pipeline_layout({ &mesh, &fragment }, sizeof(GPUMeshletDrawPushConstants), "meshlet_mesh_layout");
+
+        meshlet_variants.init(permutations, [this, permutations, layout = meshlet_mesh_layout](PermutationKey key) {
+            const std::vector<ShaderDefine> defines = permutations.defines(key);
+            const std::optional<CompiledShader> mesh = shader_compiler.compile("meshlet.mesh", defines);
+            const std::optional<CompiledShader> fragment = shader_compiler.compile("mesh.frag", defines);
+            if (!mesh || !fragment) {
+                return VkPipeline(VK_NULL_HANDLE);
+            }
+            const VkShaderModule mesh_shader = device.create_shader_module(mesh->code, "meshlet.mesh");
+            const VkShaderModule fragment_shader = device.create_shader_module(fragment->code, "mesh.frag");
+
+            const ShaderSpecialization specialization = permutations.specialization(key);
+            const VkSpecializationInfo specialization_info = specialization.info();
+            GraphicsPipelineBuilder pipeline_builder;
+            pipeline_builder.pipeline_layout = layout;
+            pipeline_builder.set_mesh_shaders(mesh_shader, fragment_shader);
+            pipeline_builder.set_specialization(&specialization_info);
+            pipeline_builder.set_input_topology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+            pipeline_builder.set_polygon_mode(VK_POLYGON_MODE_FILL);
+            pipeline_builder.set_cull_mode(VK_CULL_MODE_NONE, VK_FRONT_FACE_CLOCKWISE);
+            pipeline_builder.set_multisampling_none();
+            pipeline_builder.disable_blending();
+            pipeline_builder.enable_depth_test(true, VK_COMPARE_OP_GREATER_OR_EQUAL);
+            pipeline_builder.set_color_attachment_format(draw_image->format);
+            pipeline_builder.set_depth_format(depth_image->format);
+            const std::string name = "meshlet_mesh_pipeline " + permutations.format(key);
+            const VkPipeline pipeline = device.create_graphics_pipeline(pipeline_builder.build(), name.c_str());
+
+            device.destroy_shader_module(mesh_shader);
+            device.destroy_shader_module(fragment_shader);
+            return pipeline;
+        });
+        const PermutationKey defaults[] = { 0 };
+        prewarm_variants(meshlet_variants, defaults);
     }
 
-    GPUMeshBuffers Renderer::create_mesh(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices) {
-        const size_t vertex_buffer_size = vertices.size() * sizeof(Vertex);
-        const size_t index_buffer_size = indices.size() * sizeof(uint32_t);
+    void Renderer::prewarm_variants(PipelineVariants& variants, std::span<const PermutationKey> defaults) {
+        const PipelinePermutations& permutations = variants.permutations();
+        std::vector<PermutationKey> keys(defaults.begin(), defaults.end());
+        if (const auto entries = permutation_manifest.find(permutations.name); entries != permutation_manifest.end()) {
+            for (const std::string& entry : entries->second) {
+                if (const std::optional<PermutationKey> key = permutations.parse(entry)) {
+                    keys.push_back(*key);
+                } else {
+                    std::cout << "Skipping unknown permutation " << permutations.name << " " << entry << std::endl;
+                }
+            }
+        }
+        variants.prewarm(*jobs, keys);
+    }
 
-        GPUMeshBuffers upload_mesh;
-        upload_mesh.vertex_buffer = device.create_buffer(
-            vertex_buffer_size,
-            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-            VMA_MEMORY_USAGE_GPU_ONLY
-        );
-        upload_mesh.vertex_buffer_address = device.get_buffer_address(upload_mesh.vertex_buffer);
-        upload_mesh.index_buffer = device.create_buffer(
-            index_buffer_size,
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VMA_MEMORY_USAGE_GPU_ONLY
-        );
+    // Waits only when the frame asks for a variant that was neither in the manifest nor used before, such as the
+    // first time a debug view is switched on.
+    void Renderer::select_pipelines() {
+        const PipelinePermutations& mesh_permutations = mesh_variants.permutations();
+        // A variant that failed to build keeps the frame on the pipelines it had.
+        const PermutationKey mesh_key = mesh_permutations.with(0, MESH_DEBUG_VIEW, static_cast<uint32_t>(debug_view));
+        if (const VkPipeline pipeline = mesh_variants.get(*jobs, mesh_key)) {
+            mesh_pipeline = pipeline;
+        }
+        if (const VkPipeline pipeline = mesh_variants.get(*jobs, mesh_permutations.with(mesh_key, MESH_QUANTIZED_VERTICES, 1))) {
+            mesh_compact_pipeline = pipeline;
+        }
+        if (mesh_shader_supported) {
+            const PermutationKey meshlet_key = meshlet_variants.permutations().with(0, MESHLET_DEBUG_VIEW, static_cast<uint32_t>(debug_view));
+            if (const VkPipeline pipeline = meshlet_variants.get(*jobs, meshlet_key)) {
+                meshlet_mesh_pipeline = pipeline;
+            }
+        }
+    }
+
+    // The pipeline cache sits next to the SPIR-V cache. The driver checks the header and ignores data written by
+    // another device or driver version, so a stale file only costs a cold start.
+    void Renderer::create_pipeline_cache() {
+        std::ifstream file(shader_compiler.cache_directory() / PIPELINE_CACHE_FILE, std::ios::binary);
+        const std::vector<char> data = file.is_open() ? std::vector<char>(std::istreambuf_iterator<char>(file), {}) : std::vector<char> {};
+        device.create_pipeline_cache(data);
+        const std::filesystem::path manifest_path = shader_compiler.cache_directory() / PERMUTATION_MANIFEST_FILE;
+        permutation_manifest = read_permutation_manifest(std::filesystem::exists(manifest_path) ? manifest_path : SEED_PERMUTATION_MANIFEST);
+    }
 
-        VulkanBuffer staging = device.create_buffer(
+    void Renderer::save_pipeline_cache() {
+        const std::vector<char> data = device.get_pipeline_cache_data();
+        std::error_code error;
+        std::filesystem::create_directories(shader_compiler.cache_directory(), error);
+        const std::filesystem::path cache_path = shader_compiler.cache_directory() / PIPELINE_CACHE_FILE;
+        std::filesystem::path temporary = cache_path;
+        temporary += ".tmp";
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        file.close();
+        if (file) {
+            std::filesystem::rename(temporary, cache_path, error);
+        } else {
+            std::cout << "Failed to write pipeline cache " << cache_path << std::endl;
+            std::filesystem::remove(temporary, error);
+        }
+
+        // The manifest is replaced by what this run bound, so permutations that fall out of use stop being built.
+        std::map<std::string, std::vector<std::string>> manifest;
+        for (const PipelineVariants* variants : { &mesh_variants, &meshlet_variants }) {
+            const PipelinePermutations& permutations = variants->permutations();
+            for (const PermutationKey key : variants->used_keys()) {
+                manifest[permutations.name].push_back(permutations.format(key));
+            }
+        }
+        const std::filesystem::path manifest_path = shader_compiler.cache_directory() / PERMUTATION_MANIFEST_FILE;
+        if (!manifest.empty() && !write_permutation_manifest(manifest_path, manifest)) {
+            std::cout << "Failed to write permutation manifest " << manifest_path << std::endl;
+        }
+    }
+
+    bool Renderer::compile_shader_variants(const std::string& name) const {
+        const auto compiles_for = [&](const PipelineVariants& variants) {
+            return std::ranges::all_of(variants.module_defines(), [&](const std::vector<ShaderDefine>& defines) {
+                return shader_compiler.compile(name, defines).has_value();
+            });
+        };
+        const bool mesh_stage = name == "mesh.vert" || name == "mesh.frag";
+        const bool meshlet_variant_stage = mesh_shader_supported && (name == "meshlet.mesh" || name == "mesh.frag");
+        if (mesh_stage && !compiles_for(mesh_variants)) {
+            return false;
+        }
+        if (meshlet_variant_stage && !compiles_for(meshlet_variants)) {
+            return false;
+        }
+        if (!mesh_stage && !meshlet_variant_stage) {
+            return shader_compiler.compile(name).has_value();
+        }
+        return true;
+    }
+
+    // The replaced pipelines may still be bound by frames in flight, so they go through the deletion queue.
+    // A source that fails to compile for any built variant leaves every current pipeline in place. The hot
+    // reloader compiles the variants in the background first, so the check here only hits the SPIR-V cache.
+    void Renderer::reload_shader(const std::string& name) {
+        const bool mesh_stage = name == "mesh.vert" || name == "mesh.frag";
+        const bool meshlet_stage = name == "meshlet_cull.comp" || name == "meshlet.mesh" || name == "mesh.frag";
+        const bool known = mesh_stage || meshlet_stage || name == "gradient.comp" || name == "shader.vert" || name == "shader.frag";
+        if (!known || !compile_shader_variants(name)) {
+            return;
+        }
+
+        if (name == "gradient.comp") {
+            device.retire_pipeline(gradient_pipeline);
+            device.retire_pipeline_layout(gradient_layout);
+            create_background_pipelines();
+        } else if (name == "shader.vert" || name == "shader.frag") {
+            device.retire_pipeline(triangle_pipeline);
+            device.retire_pipeline_layout(triangle_pipeline_layout);
+            create_triangle_pipeline();
+        }
+        // Every variant that was built is rebuilt in the background, select_pipelines() picks them up next frame.
+        if (mesh_stage) {
+            const std::vector<PermutationKey> keys = mesh_variants.keys();
+            mesh_variants.retire(*jobs, device);
+            device.retire_pipeline_layout(mesh_pipeline_layout);
+            create_mesh_pipeline();
+            mesh_variants.prewarm(*jobs, keys);
+        }
+        if (meshlet_stage) {
+            device.retire_pipeline(meshlet_cull_pipeline);
+            device.retire_pipeline_layout(meshlet_cull_layout);
+            const std::vector<PermutationKey> keys = meshlet_variants.keys();
+            if (mesh_shader_supported) {
+                meshlet_variants.retire(*jobs, device);
+                device.retire_pipeline_layout(meshlet_mesh_layout);
+            }
+            create_meshlet_pipelines();
+            if (mesh_shader_supported) {
+                meshlet_variants.prewarm(*jobs, keys);
+            }
+        }
+    }
+
+    std::shared_ptr<GPUMeshBuffers> Renderer::create_mesh(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const std::vector<MeshSurface>& surfaces, const std::vector<MeshSurface>& lod_ranges) {
+        return upload_geometry(indices, surfaces, lod_ranges, vertices.data(), vertices.size(), sizeof(Vertex));
+    }
+
+    std::shared_ptr<GPUMeshBuffers> Renderer::create_mesh(const std::vector<uint32_t>& indices, const std::vector<CompactVertex>& vertices, const std::vector<MeshSurface>& surfaces, const std::vector<MeshSurface>& lod_ranges) {
+        return upload_geometry(indices, surfaces, lod_ranges, vertices.data(), vertices.size(), sizeof(CompactVertex));
+    }
+
+    // Surfaces are packed first followed by the LOD ranges, so GPUMeshBuffers::surfaces keeps the same order.
+    std::shared_ptr<GPUMeshBuffers> Renderer::upload_geometry(const std::vector<uint32_t>& indices, const std::vector<MeshSurface>& surfaces, const std::vector<MeshSurface>& lod_ranges, const void* vertex_data, size_t vertex_count, uint32_t vertex_stride) {
+        std::vector<MeshSurface> ranges = surfaces.empty() ? std::vector { MeshSurface { .count = static_cast<uint32_t>(indices.size()) } } : surfaces;
+        ranges.insert(ranges.end(), lod_ranges.begin(), lod_ranges.end());
+        PackedIndices packed = pack_indices(indices, ranges);
+
+        const size_t vertex_buffer_size = vertex_count * vertex_stride;
+        const size_t index_buffer_size = packed.data.size();
+
+        std::optional<GeometryRange> vertex_range = geometry_pool.allocate_vertices(vertex_buffer_size, vertex_stride);
+        std::optional<GeometryRange> index_range = geometry_pool.allocate_indices(index_buffer_size);
+        if (!vertex_range || !index_range) {
+            const VkDeviceSize vertex_capacity = geometry_pool.vertex_buffer().size + (vertex_range ? 0 : vertex_buffer_size + vertex_stride);
+            const VkDeviceSize index_capacity = geometry_pool.index_buffer().size + (index_range ? 0 : index_buffer_size);
+            immediate_submit([&](VulkanCommandEncoder encoder) {
+                geometry_pool.grow(encoder, vertex_capacity, index_capacity);
+            });
+            if (!vertex_range) {
+                vertex_range = geometry_pool.allocate_vertices(vertex_buffer_size, vertex_stride);
+            }
+            if (!index_range) {
+                index_range = geometry_pool.allocate_indices(index_buffer_size);
+            }
+        }
+        POSIDEON_ASSERT(vertex_range && index_range)
+
+        auto upload_mesh = std::make_shared<GPUMeshBuffers>();
+        upload_mesh->pool = &geometry_pool;
+        upload_mesh->vertices = *vertex_range;
+        upload_mesh->indices = *index_range;
+        upload_mesh->vertex_stride = vertex_stride;
+        upload_mesh->vertex_offset = static_cast<int32_t>(vertex_range->offset / vertex_stride);
+        upload_mesh->surfaces = std::move(packed.surfaces);
+
+        const UniqueBuffer staging(device, device.create_buffer(
             vertex_buffer_size + index_buffer_size,
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VMA_MEMORY_USAGE_CPU_ONLY
-        );
-        void* data = staging.allocation->GetMappedData();
-        memcpy(data, vertices.data(), vertex_buffer_size);
-        memcpy(static_cast<char*>(data) + vertex_buffer_size, indices.data(), index_buffer_size);
+            VMA_MEMORY_USAGE_CPU_ONLY,
+            MemoryCategory::Staging,
+            "mesh_staging_buffer"
+        ));
+        void* data = staging->allocation_info.pMappedData;
+        memcpy(data, vertex_data, vertex_buffer_size);
+        memcpy(static_cast<char*>(data) + vertex_buffer_size, packed.data.data(), index_buffer_size);
 
         immediate_submit([&](VulkanCommandEncoder encoder) {
-            encoder.copy_buffer_to_buffer(staging.buffer, upload_mesh.vertex_buffer.buffer, vertex_buffer_size, 0, 0);
-            encoder.copy_buffer_to_buffer(staging.buffer, upload_mesh.index_buffer.buffer, index_buffer_size, vertex_buffer_size, 0);
+            const auto label = encoder.scoped_label("upload_mesh");
+            encoder.copy_buffer_to_buffer(staging->buffer, geometry_pool.vertex_buffer().buffer, vertex_buffer_size, 0, vertex_range->offset);
+            encoder.copy_buffer_to_buffer(staging->buffer, geometry_pool.index_buffer().buffer, index_buffer_size, vertex_buffer_size, index_range->offset);
         });
 
+        mesh_defragmenter.register_mesh(upload_mesh);
         return upload_mesh;
     }
 
+    std::vector<TextureHandle> Renderer::upload_textures(std::span<const TextureImage> images) {
+        std::vector<TextureHandle> handles(images.size());
+        std::vector<size_t> pending;
+        size_t staging_size = 0;
+        for (size_t i = 0; i < images.size(); i++) {
+            if (const std::optional<TextureHandle> cached = texture_cache.find(images[i].name)) {
+                handles[i] = *cached;
+                continue;
+            }
+            pending.push_back(i);
+            staging_size += images[i].pixels.size();
+        }
+        if (pending.empty()) {
+            return handles;
+        }
+
+        const UniqueBuffer staging(device, device.create_buffer(
+            staging_size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_MEMORY_USAGE_CPU_ONLY,
+            MemoryCategory::Staging,
+            "texture_staging_buffer"
+        ));
+
+        std::vector<UniqueImage> textures;
+        std::vector<VkDeviceSize> offsets;
+        textures.reserve(pending.size());
+        offsets.reserve(pending.size());
+        VkDeviceSize offset = 0;
+        for (const size_t i : pending) {
+            const TextureImage& image = images[i];
+            textures.emplace_back(device, device.create_image({
+                .image_type = VK_IMAGE_TYPE_2D,
+                .format = image.srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM,
+                .width = image.width,
+                .height = image.height,
+                .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                .initial_layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .image_view_type = VK_IMAGE_VIEW_TYPE_2D,
+                .aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mip_levels = mip_level_count(image.width, image.height),
+            }, MemoryCategory::Texture, image.name.c_str()));
+            memcpy(static_cast<char*>(staging->allocation_info.pMappedData) + offset, image.pixels.data(), image.pixels.size());
+            offsets.push_back(offset);
+            offset += image.pixels.size();
+        }
+
+        // One submit for the whole batch, textures do not each wait on their own fence.
+        immediate_submit([&](VulkanCommandEncoder encoder) {
+            const auto label = encoder.scoped_label("upload_textures");
+            for (size_t t = 0; t < pending.size(); t++) {
+                const TextureImage& image = images[pending[t]];
+                const VkExtent2D extent { image.width, image.height };
+                encoder.transition_image(textures[t]->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+                encoder.copy_buffer_to_image(staging->buffer, textures[t]->image, extent, offsets[t]);
+                encoder.generate_mipmaps(textures[t]->image, extent, mip_level_count(image.width, image.height));
+            }
+        });
+
+        for (size_t t = 0; t < pending.size(); t++) {
+            const TextureImage& image = images[pending[t]];
+            handles[pending[t]] = texture_cache.add(image.name, std::move(textures[t]), mip_level_count(image.width, image.height));
+        }
+        return handles;
+    }
+
+    std::vector<TextureHandle> Renderer::upload_compressed_textures(std::span<const CompressedTexture> textures) {
+        std::vector<TextureHandle> handles(textures.size());
+        std::vector<size_t> pending;
+        size_t staging_size = 0;
+        for (size_t i = 0; i < textures.size(); i++) {
+            if (const std::optional<TextureHandle> cached = texture_cache.find(textures[i].name)) {
+                handles[i] = *cached;
+                continue;
+            }
+            pending.push_back(i);
+            staging_size = align_texture_staging(staging_size + textures[i].data.size());
+        }
+        if (pending.empty()) {
+            return handles;
+        }
+
+        const UniqueBuffer staging(device, device.create_buffer(
+            staging_size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_MEMORY_USAGE_CPU_ONLY,
+            MemoryCategory::Staging,
+            "texture_staging_buffer"
+        ));
+
+        // Handles are handed out in order below, so the index each texture will get is known up front.
+        std::vector<UniqueImage> images;
+        std::vector<VkDeviceSize> offsets;
+        std::vector<uint32_t> first_levels;
+        images.reserve(pending.size());
+        offsets.reserve(pending.size());
+        first_levels.reserve(pending.size());
+        VkDeviceSize offset = 0;
+        for (const size_t i : pending) {
+            const CompressedTexture& texture = textures[i];
+            const bool streamed = texture.streamed && texture_cache.size() + images.size() < MAX_STREAMED_TEXTURES;
+            const uint32_t first_level = streamed ? texture_streamer.initial_mip(texture) : 0;
+            images.emplace_back(device, device.create_image({
+                .image_type = VK_IMAGE_TYPE_2D,
+                .format = texture.format,
+                .width = std::max(texture.width >> first_level, 1u),
+                .height = std::max(texture.height >> first_level, 1u),
+                .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                .initial_layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .image_view_type = VK_IMAGE_VIEW_TYPE_2D,
+                .aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mip_levels = static_cast<uint32_t>(texture.level_offsets.size()) - first_level,
+            }, MemoryCategory::Texture, texture.name.c_str()));
+            memcpy(static_cast<char*>(staging->allocation_info.pMappedData) + offset, texture.data.data(), texture.data.size());
+            offsets.push_back(offset);
+            first_levels.push_back(first_level);
+            offset = align_texture_staging(offset + texture.data.size());
+        }
+
+        immediate_submit([&](VulkanCommandEncoder encoder) {
+            const auto label = encoder.scoped_label("upload_compressed_textures");
+            for (size_t t = 0; t < pending.size(); t++) {
+                const CompressedTexture& texture = textures[pending[t]];
+                encoder.transition_image(images[t]->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+                for (uint32_t level = first_levels[t]; level < texture.level_offsets.size(); level++) {
+                    const VkExtent2D extent { std::max(texture.width >> level, 1u), std::max(texture.height >> level, 1u) };
+                    encoder.copy_buffer_to_image(staging->buffer, images[t]->image, extent, offsets[t] + texture.level_offsets[level], level - first_levels[t]);
+                }
+                encoder.transition_image(images[t]->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            }
+        });
+
+        for (size_t t = 0; t < pending.size(); t++) {
+            const CompressedTexture& texture = textures[pending[t]];
+            handles[pending[t]] = texture_cache.add(texture.name, std::move(images[t]), static_cast<uint32_t>(texture.level_offsets.size()) - first_levels[t]);
+            if (first_levels[t] > 0) {
+                texture_streamer.add(handles[pending[t]], texture, first_levels[t]);
+            }
+        }
+        return handles;
+    }
+
+    bool Renderer::sampled_format_supported(VkFormat format) const {
+        return check_sampled_format(physical_device, format);
+    }
+
+    std::shared_ptr<GPUMeshlets> Renderer::create_meshlets(const MeshletData& data, bool expand_indices) {
+        if (data.meshlets.empty()) {
+            return nullptr;
+        }
+
+        const size_t meshlets_size = data.meshlets.size() * sizeof(Meshlet);
+        const size_t vertices_size = data.vertices.size() * sizeof(uint32_t);
+        const size_t triangles_size = data.triangles.size() * sizeof(uint32_t);
+        const size_t data_size = meshlets_size + vertices_size + triangles_size;
+
+        auto meshlets = std::make_shared<GPUMeshlets>();
+        meshlets->data = UniqueBuffer(device, device.create_buffer(
+            data_size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY,
+            MemoryCategory::Mesh,
+            "meshlet_data"
+        ));
+
+        const UniqueBuffer staging(device, device.create_buffer(
+            data_size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_MEMORY_USAGE_CPU_ONLY,
+            MemoryCategory::Staging,
+            "meshlet_staging_buffer"
+        ));
+        char* staging_data = static_cast<char*>(staging->allocation_info.pMappedData);
+        memcpy(staging_data, data.meshlets.data(), meshlets_size);
+        memcpy(staging_data + meshlets_size, data.vertices.data(), vertices_size);
+        memcpy(staging_data + meshlets_size + vertices_size, data.triangles.data(), triangles_size);
+
+        immediate_submit([&](VulkanCommandEncoder encoder) {
+            const auto label = encoder.scoped_label("upload_meshlets");
+            encoder.copy_buffer_to_buffer(staging->buffer, meshlets->data->buffer, data_size, 0, 0);
+        });
+
+        const VkDeviceAddress address = device.get_buffer_address(meshlets->data.get());
+        meshlets->meshlets = address;
+        meshlets->vertices = address + meshlets_size;
+        meshlets->triangles = address + meshlets_size + vertices_size;
+        meshlets->meshlet_count = static_cast<uint32_t>(data.meshlets.size());
+        meshlets->expand_indices = expand_indices;
+
+        const VkDeviceSize visible_size = (data.meshlets.size() * sizeof(uint32_t) + 15) & ~static_cast<VkDeviceSize>(15);
+        meshlets->index_offset = sizeof(MeshletCullHeader) + visible_size;
+        const VkDeviceSize output_size = meshlets->index_offset + (expand_indices ? data.triangles.size() * 3 * sizeof(uint32_t) : 0);
+        for (uint32_t i = 0; i < FRAME_OVERLAP; i++) {
+            meshlets->cull_outputs.emplace_back(device, device.create_buffer(
+                output_size,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                    VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                VMA_MEMORY_USAGE_GPU_ONLY,
+                MemoryCategory::Mesh,
+                "meshlet_cull_output"
+            ));
+        }
+        return meshlets;
+    }
+
     void Renderer::init_default_data() {
         std::vector<Vertex> rect_vertices(4);
 
@@ -347,12 +950,80 @@ namespace Posideon {
         rect_indices[5] = 3;
 
         rectangle = create_mesh(rect_indices, rect_vertices);
-        test_meshes = load_gltf_meshes(this, "../assets/meshes/basicmesh.glb").value();
+        test_scene = load_gltf_scene(this, "../assets/meshes/basicmesh.glb").value();
+    }
+
+    void Renderer::cleanup() {
+        device.wait_idle();
+
+        test_scene = {};
+        loaded_gltfs.clear();
+        rectangle.reset();
+        geometry_pool.destroy();
+        texture_streamer.destroy();
+        texture_cache.destroy();
+        draw_image.reset();
+        depth_image.reset();
+
+        mesh_variants.destroy(*jobs, device);
+        device.destroy_pipeline_layout(mesh_pipeline_layout);
+        device.destroy_pipeline(meshlet_cull_pipeline);
+        device.destroy_pipeline_layout(meshlet_cull_layout);
+        if (mesh_shader_supported) {
+            meshlet_variants.destroy(*jobs, device);
+            device.destroy_pipeline_layout(meshlet_mesh_layout);
+        }
+        // After the variants, so pre-warm jobs still running at shutdown have finished writing to the cache.
+        save_pipeline_cache();
+        device.destroy_pipeline(triangle_pipeline);
+        device.destroy_pipeline_layout(triangle_pipeline_layout);
+        device.destroy_pipeline(gradient_pipeline);
+        device.destroy_pipeline_layout(gradient_layout);
+
+        global_descriptor_allocator.destroy_pool(device);
+        for (const auto& [bindings, layout] : descriptor_set_layouts) {
+            device.destroy_descriptor_set_layout(layout);
+        }
+        descriptor_set_layouts.clear();
+
+        for (auto& frame : frames) {
+            frame.instance_buffer.reset();
+            frame.texture_feedback.reset();
+            device.destroy_command_pool(frame.command_pool);
+            for (VkCommandPool pool : frame.record_pools) {
+                device.destroy_command_pool(pool);
+            }
+            device.destroy_fence(frame.render_fence);
+            device.destroy_semaphore(frame.render_semaphore);
+            device.destroy_semaphore(frame.swapchain_semaphore);
+        }
+        device.destroy_command_pool(immediate_command_pool);
+        device.destroy_fence(immediate_fence);
+
+        for (VkImageView image_view : swapchain_image_views) {
+            device.destroy_image_view(image_view);
+        }
+        device.destroy_swapchain(swapchain);
+
+        device.destroy();
+        vkDestroySurfaceKHR(instance, surface, nullptr);
+        destroy_debug_messenger(instance, debug_messenger);
+        vkDestroyInstance(instance, nullptr);
     }
     
-    void Renderer::render() {
+    void Renderer::render(const RenderWorld& world) {
         device.wait_for_fence(get_current_frame().render_fence);
         device.reset_fence(get_current_frame().render_fence);
+        device.begin_frame(frame_number, FRAME_OVERLAP);
+
+        // This frame slot's feedback was written FRAME_OVERLAP frames ago and its fence has just signalled.
+        const VulkanBuffer& texture_feedback = get_current_frame().texture_feedback.get();
+        device.invalidate_buffer(texture_feedback);
+        texture_streamer.read_feedback(std::span(static_cast<uint32_t*>(texture_feedback.allocation_info.pMappedData), MAX_STREAMED_TEXTURES), frame_number);
+        device.flush_buffer(texture_feedback);
+
+        memory_report = device.query_memory_budget();
+        device.enforce_memory_budget(memory_report);
 
         uint32_t image_index = device.acquire_next_image(swapchain, get_current_frame().swapchain_semaphore);
 
@@ -360,24 +1031,42 @@ namespace Posideon {
         command_encoder.reset();
         command_encoder.begin();
 
-        VkExtent2D draw_extent { draw_image.extent.width, draw_image.extent.height };
+        mesh_defragmenter.update(geometry_pool, command_encoder, mesh_shader_supported && use_meshlets);
+        texture_streamer.update(texture_cache, command_encoder, frame_number);
+
+        extracted_view = world.view;
+        prepare_instances(world.instances);
+        build_draw_list();
+        select_pipelines();
+
+        VkExtent2D draw_extent { draw_image->extent.width, draw_image->extent.height };
 
-        command_encoder.transition_image(draw_image.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+        command_encoder.transition_image(draw_image->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
 
         draw_background(command_encoder);
+        cull_meshlets(command_encoder);
 
-        command_encoder.transition_image(draw_image.image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-        command_encoder.transition_image(depth_image.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+        command_encoder.transition_image(draw_image->image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        command_encoder.transition_image(depth_image->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
         
-        draw_geometry(command_encoder);
-        
-        command_encoder.transition_image(draw_image.image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-        command_encoder.transition_image(swapchain_images[image_index], VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        const EncoderStats secondary_stats = draw_geometry(command_encoder);
+        draw_stats = command_encoder.stats();
+        draw_stats += secondary_stats;
 
-        command_encoder.copy_image_to_image(draw_image.image, swapchain_images[image_index], draw_extent, swapchain_extent);
+        {
+            const auto label = command_encoder.scoped_label("present_blit");
+            command_encoder.transition_image(draw_image->image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+            command_encoder.transition_image(swapchain_images[image_index], VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+            command_encoder.copy_image_to_image(draw_image->image, swapchain_images[image_index], draw_extent, swapchain_extent);
+
+            command_encoder.transition_image(swapchain_images[image_index], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+        }
+        command_encoder.memory_barrier(
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_READ_BIT
+        );
 
-        command_encoder.transition_image(swapchain_images[image_index], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
-        
         VkCommandBuffer command_buffer = command_encoder.finish();
 
         VkCommandBufferSubmitInfo command_submit_info {
@@ -426,50 +1115,239 @@ namespace Posideon {
     }
 
     void Renderer::draw_background(const VulkanCommandEncoder& encoder) const {
+        const auto label = encoder.scoped_label("background");
         encoder.bind_pipeline(VK_PIPELINE_BIND_POINT_COMPUTE, gradient_pipeline);
         encoder.bind_descriptor_set(VK_PIPELINE_BIND_POINT_COMPUTE, gradient_layout, 0, { draw_image_set }, {});
-        encoder.dispatch(std::ceil(draw_image.extent.width / 16.0f), std::ceil(draw_image.extent.height / 16.0f));
+        encoder.dispatch(std::ceil(draw_image->extent.width / 16.0f), std::ceil(draw_image->extent.height / 16.0f));
+    }
+
+    void Renderer::prepare_instances(const std::vector<MeshInstance>& instances) {
+        instance_batcher.build(instances, extracted_view, static_cast<float>(draw_image->extent.height), lod_settings, use_meshlets);
+
+        const std::vector<GPUInstanceData>& instance_data = instance_batcher.instance_data();
+        const VkDeviceSize size = std::max<VkDeviceSize>(instance_data.size(), 1) * sizeof(GPUInstanceData);
+        UniqueBuffer& instance_buffer = get_current_frame().instance_buffer;
+        if (!instance_buffer || instance_buffer->size < size) {
+            instance_buffer = UniqueBuffer(device, device.create_buffer(
+                std::max<VkDeviceSize>(size, instance_buffer ? instance_buffer->size * 2 : 0),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                VMA_MEMORY_USAGE_CPU_TO_GPU,
+                MemoryCategory::Other,
+                "instance_buffer"
+            ));
+        }
+        memcpy(instance_buffer->allocation_info.pMappedData, instance_data.data(), instance_data.size() * sizeof(GPUInstanceData));
+    }
+
+    void Renderer::build_draw_list() {
+        draw_list.clear();
+
+        // Mesh ids are handed out per asset in first-seen order. The top bit groups surfaces by index type,
+        // since every mesh shares the pool's index buffer.
+        std::unordered_map<const GltfAsset*, uint32_t> mesh_ids;
+        const auto mesh_id = [&](const GltfAsset* asset, VkIndexType index_type) {
+            const uint32_t id = mesh_ids.try_emplace(asset, static_cast<uint32_t>(mesh_ids.size())).first->second;
+            return (index_type == VK_INDEX_TYPE_UINT32 ? 0x8000u : 0u) | (id & 0x7fff);
+        };
+
+        const std::vector<MeshletDraw>& meshlet_draws = instance_batcher.meshlet_draws();
+        for (uint32_t i = 0; i < meshlet_draws.size(); i++) {
+            const MeshletDraw& draw = meshlet_draws[i];
+            const DrawPipeline pipeline = !draw.asset->meshlet_buffers->expand_indices ? DrawPipeline::MeshletMesh :
+                draw.asset->vertex_format == VertexFormat::Compact ? DrawPipeline::MeshCompact : DrawPipeline::Mesh;
+            draw_list.push(make_sort_key(static_cast<uint32_t>(pipeline), 0, mesh_id(draw.asset, VK_INDEX_TYPE_UINT32), draw.depth), i | MESHLET_DRAW_BIT);
+        }
+
+        const std::vector<InstanceBatch>& batches = instance_batcher.batches();
+        for (uint32_t i = 0; i < batches.size(); i++) {
+            const InstanceBatch& batch = batches[i];
+            const DrawPipeline pipeline = batch.asset->vertex_format == VertexFormat::Compact ? DrawPipeline::MeshCompact : DrawPipeline::Mesh;
+            const VkIndexType index_type = batch.asset->gpu_surface(batch.surface, batch.lod).index_type;
+            draw_list.push(make_sort_key(static_cast<uint32_t>(pipeline), 0, mesh_id(batch.asset, index_type), batch.depth), i);
+        }
+
+        draw_list.sort();
+    }
+
+    glm::mat4 Renderer::view_projection() const {
+        return extracted_view.projection * extracted_view.view;
+    }
+
+    glm::vec3 Renderer::camera_position() const {
+        return glm::inverse(extracted_view.view)[3];
     }
 
-    void Renderer::draw_geometry(const VulkanCommandEncoder& encoder) const {
-        const VkRect2D draw_extent { 0, 0, draw_image.extent.width, draw_image.extent.height };
+    void Renderer::cull_meshlets(const VulkanCommandEncoder& encoder) const {
+        if (instance_batcher.meshlet_draws().empty()) {
+            return;
+        }
+
+        const auto label = encoder.scoped_label("meshlet_cull");
+        bool expanded_indices = false;
+        bool mesh_tasks = false;
+        for (const MeshletDraw& draw : instance_batcher.meshlet_draws()) {
+            const GPUMeshlets& meshlets = *draw.asset->meshlet_buffers;
+            const VulkanBuffer& output = meshlets.cull_outputs[frame_number % FRAME_OVERLAP].get();
+
+            const MeshletCullHeader header {
+                .tasks = { .groupCountX = 0, .groupCountY = 1, .groupCountZ = 1 },
+                .draw = { .indexCount = 0, .instanceCount = 1, .firstIndex = 0, .vertexOffset = draw.asset->mesh_buffers->vertex_offset, .firstInstance = draw.instance },
+            };
+            encoder.update_buffer(output.buffer, 0, sizeof(MeshletCullHeader), &header);
+            expanded_indices |= meshlets.expand_indices;
+            mesh_tasks |= !meshlets.expand_indices;
+        }
+        encoder.memory_barrier(
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+        );
+
+        encoder.bind_pipeline(VK_PIPELINE_BIND_POINT_COMPUTE, meshlet_cull_pipeline);
+        for (const MeshletDraw& draw : instance_batcher.meshlet_draws()) {
+            const GPUMeshlets& meshlets = *draw.asset->meshlet_buffers;
+            const VkDeviceAddress output_address = device.get_buffer_address(meshlets.cull_outputs[frame_number % FRAME_OVERLAP].get());
+            // Meshlet bounds are in model space, so the camera is moved into model space rather than every bound into the world.
+            const GPUMeshletCullPushConstants push_constants {
+                .view_projection = view_projection() * draw.model,
+                .camera_position = glm::inverse(draw.model) * glm::vec4(camera_position(), 1.0f),
+                .meshlet_count = meshlets.meshlet_count,
+                .meshlets = meshlets.meshlets,
+                .meshlet_vertices = meshlets.vertices,
+                .meshlet_triangles = meshlets.triangles,
+                .cull_output = output_address,
+                .expanded_indices = output_address + meshlets.index_offset,
+                .expand_indices = meshlets.expand_indices ? 1u : 0u,
+            };
+            encoder.push_constants(meshlet_cull_layout, VK_SHADER_STAGE_COMPUTE_BIT, sizeof(GPUMeshletCullPushConstants), &push_constants);
+            encoder.dispatch((meshlets.meshlet_count + 63) / 64, 1);
+        }
+
+        if (expanded_indices) {
+            encoder.memory_barrier(
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT
+            );
+        }
+        if (mesh_tasks) {
+            encoder.memory_barrier(
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT
+            );
+        }
+    }
+
+    EncoderStats Renderer::draw_geometry(const VulkanCommandEncoder& encoder) const {
+        const auto label = encoder.scoped_label("geometry");
+        const VkRect2D draw_extent { 0, 0, draw_image->extent.width, draw_image->extent.height };
         VkRenderingAttachmentInfo color_attachment {
             .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
-            .imageView = draw_image.image_view,
+            .imageView = draw_image->image_view,
             .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
             .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
             .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
         };
         const VkRenderingAttachmentInfo depth_attachment {
             .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
-            .imageView = depth_image.image_view,
+            .imageView = depth_image->image_view,
             .imageLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
             .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
             .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
             .clearValue = { .depthStencil = { .depth = 0.0f } }
         };
-        encoder.start_rendering(draw_extent, { color_attachment }, &depth_attachment, nullptr);
 
-        encoder.bind_pipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, triangle_pipeline);
-        encoder.set_viewport(draw_image.extent.width, draw_image.extent.height);
-        encoder.set_scissor(draw_image.extent.width, draw_image.extent.height);
+        const GPUDrawPushConstants push_constants {
+            .world_matrix = view_projection(),
+            .texture_feedback = device.get_buffer_address(frames[frame_number % FRAME_OVERLAP].texture_feedback.get()),
+            .vertex_buffer = geometry_pool.vertex_address(),
+            .instance_buffer = device.get_buffer_address(frames[frame_number % FRAME_OVERLAP].instance_buffer.get()),
+        };
 
-        //encoder.draw(3);
+        const std::vector<DrawListEntry>& entries = draw_list.entries();
+        if (jobs == nullptr || entries.size() < PARALLEL_RECORD_MIN_DRAWS) {
+            encoder.start_rendering(draw_extent, { color_attachment }, &depth_attachment, nullptr);
 
-        encoder.bind_pipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, mesh_pipeline);
+            encoder.bind_pipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, triangle_pipeline);
+            encoder.set_viewport(draw_image->extent.width, draw_image->extent.height);
+            encoder.set_scissor(draw_image->extent.width, draw_image->extent.height);
 
-        glm::mat4 view = glm::translate(glm::vec3{ 0,0,-5 });
-        glm::mat4 projection = glm::perspective(glm::radians(70.0f), static_cast<float>(draw_extent.extent.width) / static_cast<float>(draw_extent.extent.height), 10000.0f, 0.1f);
-        projection[1][1] *= -1;
-        GPUDrawPushConstants push_constants {
-            .world_matrix = projection * view,
-            .vertex_buffer = test_meshes[2]->mesh_buffers.vertex_buffer_address
-        };
-        encoder.push_constants(mesh_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, sizeof(GPUDrawPushConstants), &push_constants);
-        encoder.bind_index_buffer(test_meshes[2]->mesh_buffers.index_buffer.buffer, VK_INDEX_TYPE_UINT32);
-        encoder.draw_indexed(test_meshes[2]->surfaces[0].count, test_meshes[2]->surfaces[0].start_index);
-        
+            //encoder.draw(3);
+
+            record_draws(encoder, entries, push_constants);
+            encoder.end_rendering();
+            return {};
+        }
+
+        // Chunks are contiguous slices of the sorted list, so each secondary keeps most of the bind elision.
+        const FrameData& frame = frames[frame_number % FRAME_OVERLAP];
+        const uint32_t draw_count = static_cast<uint32_t>(entries.size());
+        const uint32_t chunk_count = std::min(MAX_RECORD_CHUNKS, (draw_count + PARALLEL_RECORD_MIN_DRAWS - 1) / PARALLEL_RECORD_MIN_DRAWS);
+        std::array<EncoderStats, MAX_RECORD_CHUNKS> chunk_stats {};
+        jobs->parallel_for(chunk_count, 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t chunk = begin; chunk < end; chunk++) {
+                const uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(draw_count) * chunk / chunk_count);
+                const uint32_t last = static_cast<uint32_t>(static_cast<uint64_t>(draw_count) * (chunk + 1) / chunk_count);
+
+                const VulkanCommandEncoder secondary(frame.record_buffers[chunk]);
+                secondary.begin_secondary(draw_image->format, depth_image->format);
+                secondary.set_viewport(draw_image->extent.width, draw_image->extent.height);
+                secondary.set_scissor(draw_image->extent.width, draw_image->extent.height);
+                record_draws(secondary, std::span(entries).subspan(first, last - first), push_constants);
+                (void)secondary.finish();
+                chunk_stats[chunk] = secondary.stats();
+            }
+        });
+
+        encoder.start_rendering(draw_extent, { color_attachment }, &depth_attachment, nullptr, VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT);
+        encoder.execute_commands(std::span(frame.record_buffers.data(), chunk_count));
         encoder.end_rendering();
+
+        EncoderStats stats;
+        for (uint32_t chunk = 0; chunk < chunk_count; chunk++) {
+            stats += chunk_stats[chunk];
+        }
+        return stats;
+    }
+
+    void Renderer::record_draws(const VulkanCommandEncoder& encoder, std::span<const DrawListEntry> entries, const GPUDrawPushConstants& push_constants) const {
+        for (const DrawListEntry& entry : entries) {
+            if (entry.draw & MESHLET_DRAW_BIT) {
+                const MeshletDraw& draw = instance_batcher.meshlet_draws()[entry.draw & ~MESHLET_DRAW_BIT];
+                const GPUMeshlets& meshlets = *draw.asset->meshlet_buffers;
+                const VulkanBuffer& output = meshlets.cull_outputs[frame_number % FRAME_OVERLAP].get();
+                if (meshlets.expand_indices) {
+                    encoder.bind_pipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, draw.asset->vertex_format == VertexFormat::Compact ? mesh_compact_pipeline : mesh_pipeline);
+                    encoder.push_constants(mesh_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(GPUDrawPushConstants), &push_constants);
+                    encoder.bind_index_buffer(output.buffer, VK_INDEX_TYPE_UINT32, meshlets.index_offset);
+                    encoder.draw_indexed_indirect(output.buffer, offsetof(MeshletCullHeader, draw));
+                } else {
+                    const GPUMeshletDrawPushConstants meshlet_push_constants {
+                        .world_matrix = view_projection() * draw.model,
+                        .texture_feedback = push_constants.texture_feedback,
+                        .vertex_buffer = geometry_pool.vertex_address(),
+                        .meshlets = meshlets.meshlets,
+                        .meshlet_vertices = meshlets.vertices,
+                        .meshlet_triangles = meshlets.triangles,
+                        .visible_meshlets = device.get_buffer_address(output) + sizeof(MeshletCullHeader),
+                        .vertex_offset = draw.asset->mesh_buffers->vertex_offset,
+                        .instance = draw.instance,
+                        .instance_buffer = push_constants.instance_buffer,
+                    };
+                    encoder.bind_pipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, meshlet_mesh_pipeline);
+                    encoder.push_constants(meshlet_mesh_layout, VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(GPUMeshletDrawPushConstants), &meshlet_push_constants);
+                    encoder.draw_mesh_tasks_indirect(output.buffer, offsetof(MeshletCullHeader, tasks));
+                }
+                continue;
+            }
+
+            // Redundant binds and pushes are skipped by the encoder, the sort keeps them adjacent.
+            const InstanceBatch& batch = instance_batcher.batches()[entry.draw];
+            const GPUMeshBuffers& mesh = *batch.asset->mesh_buffers;
+            const GPUSurface& surface = batch.asset->gpu_surface(batch.surface, batch.lod);
+            encoder.bind_pipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, batch.asset->vertex_format == VertexFormat::Compact ? mesh_compact_pipeline : mesh_pipeline);
+            encoder.push_constants(mesh_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(GPUDrawPushConstants), &push_constants);
+            geometry_pool.bind_index_buffer(encoder, surface.index_type);
+            encoder.draw_indexed(surface.index_count, mesh.first_index(surface), mesh.base_vertex(surface), batch.instance_count, batch.first_instance);
+        }
     }
 
     void Renderer::immediate_submit(std::function<void(VulkanCommandEncoder encoder)>&& function) {
@@ -517,15 +1395,23 @@ namespace Posideon {
         return false;
     }
 
-    std::vector<char> readFile(const std::string& filename) {
-        std::ifstream file(filename, std::ios::ate | std::ios::binary);
+    bool check_device_extension(const VulkanPhysicalDevice& device, const char* extension) {
+        uint32_t extension_count = 0;
+        vkEnumerateDeviceExtensionProperties(device.raw, nullptr, &extension_count, nullptr);
+        std::vector<VkExtensionProperties> extensions(extension_count);
+        vkEnumerateDeviceExtensionProperties(device.raw, nullptr, &extension_count, extensions.data());
 
-        size_t fileSize = (size_t) file.tellg();
-        std::vector<char> buffer(fileSize);
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
-        file.close();
+        for (const VkExtensionProperties& properties : extensions) {
+            if (strcmp(properties.extensionName, extension) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
 
-        return buffer;
+    bool check_sampled_format(const VulkanPhysicalDevice& device, VkFormat format) {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(device.raw, format, &properties);
+        return properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
     }
 }
@@ -2,24 +2,104 @@
 
 #include "defines.h"
 
+#include <array>
 #include <cstdint>
 #include <functional>
+#include <initializer_list>
+#include <map>
+#include <span>
+#include <string>
+#include <utility>
 #include <vulkan/vulkan.hpp>
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include "assets/asset_cache.h"
 #include "assets/gltf_loader.h"
+#include "assets/ktx2_loader.h"
+#include "assets/texture_loader.h"
 #include "graphics/vulkan/vulkan_device.h"
 #include "graphics/vulkan/vulkan_command_encoder.h"
+#include "graphics/vulkan/vulkan_shader_compiler.h"
 #include "window/win32/win32_window.h"
 #include "graphics/vulkan/vulkan_types.h"
+#include "render/draw_list.h"
+#include "render/instance_batcher.h"
+#include "render/lod_selection.h"
+#include "render/mesh_defragmenter.h"
+#include "render/pipeline_variants.h"
+#include "render/render_world.h"
+#include "render/texture_cache.h"
+#include "render/texture_streamer.h"
+#include "scene/camera.h"
 
 namespace Posideon {
+    class JobSystem;
+
     static constexpr uint32_t FRAME_OVERLAP = 2;
+    // Draw lists at least this long are split across secondary command buffers recorded in parallel.
+    static constexpr uint32_t PARALLEL_RECORD_MIN_DRAWS = 256;
+    static constexpr uint32_t MAX_RECORD_CHUNKS = 8;
 
+    // The feedback address sits at the same offset in every draw block, mesh.frag reads it from there.
     struct GPUDrawPushConstants {
         glm::mat4 world_matrix;
+        VkDeviceAddress texture_feedback;
+        VkDeviceAddress vertex_buffer;
+        VkDeviceAddress instance_buffer;
+    };
+
+    struct GPUMeshletCullPushConstants {
+        glm::mat4 view_projection;
+        glm::vec3 camera_position;
+        uint32_t meshlet_count;
+        VkDeviceAddress meshlets;
+        VkDeviceAddress meshlet_vertices;
+        VkDeviceAddress meshlet_triangles;
+        VkDeviceAddress cull_output;
+        VkDeviceAddress expanded_indices;
+        uint32_t expand_indices;
+    };
+
+    struct GPUMeshletDrawPushConstants {
+        glm::mat4 world_matrix;
+        VkDeviceAddress texture_feedback;
         VkDeviceAddress vertex_buffer;
+        VkDeviceAddress meshlets;
+        VkDeviceAddress meshlet_vertices;
+        VkDeviceAddress meshlet_triangles;
+        VkDeviceAddress visible_meshlets;
+        int32_t vertex_offset;
+        // Index into instance_buffer, the color and texture come from the instance as in mesh.vert.
+        uint32_t instance;
+        VkDeviceAddress instance_buffer;
+    };
+    // The guaranteed minimum of maxPushConstantsSize.
+    static_assert(sizeof(GPUMeshletDrawPushConstants) <= 128);
+
+    // Head of every meshlet cull output buffer, reset with vkCmdUpdateBuffer before culling.
+    struct MeshletCullHeader {
+        VkDrawMeshTasksIndirectCommandEXT tasks;
+        uint32_t pad0;
+        VkDrawIndexedIndirectCommand draw;
+        uint32_t pad1[3];
+    };
+    static_assert(sizeof(MeshletCullHeader) == 48);
+
+    // Pipeline field of the draw-list sort key.
+    enum class DrawPipeline : uint8_t {
+        Mesh,
+        MeshCompact,
+        MeshletMesh
+    };
+
+    // Specialization constant DEBUG_VIEW in mesh.frag.
+    enum class DebugView : uint32_t {
+        None,
+        Normals,
+        UV,
+        TextureLod,
+        Count
     };
 
     struct FrameData {
@@ -28,6 +108,12 @@ namespace Posideon {
         VkSemaphore swapchain_semaphore;
         VkSemaphore render_semaphore;
         VkFence render_fence;
+        UniqueBuffer instance_buffer;
+        // MAX_STREAMED_TEXTURES requests written by mesh.frag, read back once render_fence signals.
+        UniqueBuffer texture_feedback;
+        // One pool per chunk rather than per thread, a chunk is recorded by exactly one job.
+        std::array<VkCommandPool, MAX_RECORD_CHUNKS> record_pools;
+        std::array<VkCommandBuffer, MAX_RECORD_CHUNKS> record_buffers;
     };
 
     struct Renderer {
@@ -39,6 +125,7 @@ namespace Posideon {
         VulkanPhysicalDevice physical_device;
         VulkanDevice device;
         VkQueue queue;
+        JobSystem* jobs = nullptr;
         VkSwapchainKHR swapchain;
         std::vector<VkImage> swapchain_images;
         std::vector<VkImageView> swapchain_image_views;
@@ -48,9 +135,12 @@ namespace Posideon {
         VkCommandBuffer immediate_command_buffer;
 
         DescriptorAllocator global_descriptor_allocator;
+        // Set layouts are shared by every pipeline layout with the same bindings, and destroyed in cleanup.
+        std::vector<std::pair<std::vector<VkDescriptorSetLayoutBinding>, VkDescriptorSetLayout>> descriptor_set_layouts;
+        ShaderCompiler shader_compiler { "../assets/shaders", asset_cache_directory("shaders") };
 
-        VulkanImage draw_image;
-        VulkanImage depth_image;
+        UniqueImage draw_image;
+        UniqueImage depth_image;
         VkDescriptorSet draw_image_set;
         VkDescriptorSetLayout draw_image_set_layout;
         
@@ -60,33 +150,100 @@ namespace Posideon {
         VkPipelineLayout triangle_pipeline_layout;
         VkPipeline triangle_pipeline;
 
+        // Variants are built on demand from the permutation manifest, the pipelines below are the ones
+        // select_pipelines() picked for the current frame.
+        PipelineVariants mesh_variants;
+        PipelineVariants meshlet_variants;
+        std::map<std::string, std::vector<std::string>> permutation_manifest;
+
         VkPipelineLayout mesh_pipeline_layout;
         VkPipeline mesh_pipeline;
+        VkPipeline mesh_compact_pipeline;
+
+        VkPipelineLayout meshlet_cull_layout;
+        VkPipeline meshlet_cull_pipeline;
+        VkPipelineLayout meshlet_mesh_layout = VK_NULL_HANDLE;
+        VkPipeline meshlet_mesh_pipeline = VK_NULL_HANDLE;
+        bool mesh_shader_supported = false;
+        bool bc7_supported = false;
+        bool use_meshlets = true;
+        DebugView debug_view = DebugView::None;
 
         FrameData frames[FRAME_OVERLAP];
         size_t frame_number;
+        MemoryBudgetReport memory_report;
+
+        ExtractedView extracted_view;
+        LodSelectionSettings lod_settings;
+        InstanceBatcher instance_batcher;
+        DrawList draw_list;
+        EncoderStats draw_stats;
+
+        GeometryPool geometry_pool;
+        MeshDefragmenter mesh_defragmenter;
+        TextureCache texture_cache;
+        TextureStreamer texture_streamer;
 
-        GPUMeshBuffers rectangle;
-        std::vector<std::shared_ptr<GltfAsset>> test_meshes;
+        std::shared_ptr<GPUMeshBuffers> rectangle;
+        GltfScene test_scene;
+        // Every file loaded through load_gltf_scene, for reload_gltf_scene.
+        std::vector<LoadedGltf> loaded_gltfs;
 
         void create_swapchain();
         void create_command_structures();
         void create_sync_structures();
         void create_descriptors();
+        void create_geometry_pool();
+        void create_texture_streaming();
+        [[nodiscard]] VkDescriptorSetLayout descriptor_set_layout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+        [[nodiscard]] CompiledShader compile_shader(const std::string& name, std::span<const ShaderDefine> defines = {}) const;
+        // Descriptor sets and push constants come from the stages' reflection, push_constant_size is the host
+        // struct pushed for them.
+        [[nodiscard]] VkPipelineLayout create_pipeline_layout(std::initializer_list<const CompiledShader*> stages, uint32_t push_constant_size, const char* name);
         void create_pipelines();
         void create_background_pipelines();
         void create_triangle_pipeline();
         void create_mesh_pipeline();
-        GPUMeshBuffers create_mesh(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices);
+        void create_meshlet_pipelines();
+        // Builds the manifest's permutations of a pipeline on the job system, along with the defaults.
+        void prewarm_variants(PipelineVariants& variants, std::span<const PermutationKey> defaults);
+        void select_pipelines();
+        void create_pipeline_cache();
+        void save_pipeline_cache();
+        // Compiles the source for every module its built variants use, or just its defaults when no variants
+        // use it. Safe to call from any thread, returns false if any compile failed.
+        [[nodiscard]] bool compile_shader_variants(const std::string& name) const;
+        // Rebuilds the pipelines that use the changed source, call between frames on the render thread.
+        void reload_shader(const std::string& name);
+        std::shared_ptr<GPUMeshBuffers> create_mesh(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const std::vector<MeshSurface>& surfaces = {}, const std::vector<MeshSurface>& lod_ranges = {});
+        std::shared_ptr<GPUMeshBuffers> create_mesh(const std::vector<uint32_t>& indices, const std::vector<CompactVertex>& vertices, const std::vector<MeshSurface>& surfaces = {}, const std::vector<MeshSurface>& lod_ranges = {});
+        std::shared_ptr<GPUMeshBuffers> upload_geometry(const std::vector<uint32_t>& indices, const std::vector<MeshSurface>& surfaces, const std::vector<MeshSurface>& lod_ranges, const void* vertex_data, size_t vertex_count, uint32_t vertex_stride);
+        std::shared_ptr<GPUMeshlets> create_meshlets(const MeshletData& data, bool expand_indices);
+        // Uploads every image and builds its mip chain in a single submit. Names already cached are not uploaded again.
+        std::vector<TextureHandle> upload_textures(std::span<const TextureImage> images);
+        // Block compressed levels are copied as stored, one submit for the batch and no mip generation. Textures
+        // marked streamed and above the streamer's tail size only get their tail uploaded and are streamed in
+        // from feedback.
+        std::vector<TextureHandle> upload_compressed_textures(std::span<const CompressedTexture> textures);
+        // Whether images of the format can be sampled with optimal tiling, safe to call from any thread.
+        [[nodiscard]] bool sampled_format_supported(VkFormat format) const;
         void init_default_data();
+        void cleanup();
 
         void immediate_submit(std::function<void(VulkanCommandEncoder encoder)>&& function);
-        void render();
+        void render(const RenderWorld& world);
         void draw_background(const VulkanCommandEncoder& encoder) const;
-        void draw_geometry(const VulkanCommandEncoder& encoder) const;
+        void prepare_instances(const std::vector<MeshInstance>& instances);
+        void build_draw_list();
+        void cull_meshlets(const VulkanCommandEncoder& encoder) const;
+        // Returns the stats of any secondary buffers, the primary encoder keeps its own.
+        EncoderStats draw_geometry(const VulkanCommandEncoder& encoder) const;
+        void record_draws(const VulkanCommandEncoder& encoder, std::span<const DrawListEntry> entries, const GPUDrawPushConstants& push_constants) const;
+        [[nodiscard]] glm::mat4 view_projection() const;
+        [[nodiscard]] glm::vec3 camera_position() const;
         
         FrameData& get_current_frame() { return frames[frame_number % FRAME_OVERLAP]; }
     };
 
-    Renderer init_renderer(uint32_t width, uint32_t height, Win32Window* window);
+    std::unique_ptr<Renderer> init_renderer(uint32_t width, uint32_t height, Win32Window* window, JobSystem& jobs);
 }
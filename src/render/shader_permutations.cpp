@@ -0,0 +1,145 @@
+#include "shader_permutations.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+namespace Posideon {
+    namespace {
+        uint32_t option_bits(const ShaderOption& option) {
+            return static_cast<uint32_t>(std::bit_width(std::max(option.value_count, 2u) - 1));
+        }
+
+        uint32_t option_shift(const PipelinePermutations& permutations, size_t option) {
+            uint32_t shift = 0;
+            for (size_t i = 0; i < option; i++) {
+                shift += option_bits(permutations.options[i]);
+            }
+            return shift;
+        }
+    }
+
+    VkSpecializationInfo ShaderSpecialization::info() const {
+        return VkSpecializationInfo {
+            .mapEntryCount = static_cast<uint32_t>(entries.size()),
+            .pMapEntries = entries.data(),
+            .dataSize = data.size() * sizeof(uint32_t),
+            .pData = data.data(),
+        };
+    }
+
+    uint32_t PipelinePermutations::value(PermutationKey key, size_t option) const {
+        const uint32_t mask = (1u << option_bits(options[option])) - 1;
+        return (key >> option_shift(*this, option)) & mask;
+    }
+
+    PermutationKey PipelinePermutations::with(PermutationKey key, size_t option, uint32_t value) const {
+        const uint32_t shift = option_shift(*this, option);
+        const uint32_t mask = ((1u << option_bits(options[option])) - 1) << shift;
+        return (key & ~mask) | ((value << shift) & mask);
+    }
+
+    std::vector<ShaderDefine> PipelinePermutations::defines(PermutationKey key) const {
+        std::vector<ShaderDefine> result;
+        for (size_t option = 0; option < options.size(); option++) {
+            if (options[option].kind == ShaderOptionKind::Define) {
+                result.push_back(ShaderDefine { .name = options[option].name, .value = std::to_string(value(key, option)) });
+            }
+        }
+        return result;
+    }
+
+    PermutationKey PipelinePermutations::module_key(PermutationKey key) const {
+        for (size_t option = 0; option < options.size(); option++) {
+            if (options[option].kind == ShaderOptionKind::Specialization) {
+                key = with(key, option, 0);
+            }
+        }
+        return key;
+    }
+
+    ShaderSpecialization PipelinePermutations::specialization(PermutationKey key) const {
+        ShaderSpecialization result;
+        for (size_t option = 0; option < options.size(); option++) {
+            if (options[option].kind != ShaderOptionKind::Specialization) {
+                continue;
+            }
+            result.entries.push_back(VkSpecializationMapEntry {
+                .constantID = options[option].constant_id,
+                .offset = static_cast<uint32_t>(result.data.size() * sizeof(uint32_t)),
+                .size = sizeof(uint32_t),
+            });
+            result.data.push_back(value(key, option));
+        }
+        return result;
+    }
+
+    std::string PipelinePermutations::format(PermutationKey key) const {
+        std::string text;
+        for (size_t option = 0; option < options.size(); option++) {
+            if (!text.empty()) {
+                text += ' ';
+            }
+            text += options[option].name + "=" + std::to_string(value(key, option));
+        }
+        return text;
+    }
+
+    std::optional<PermutationKey> PipelinePermutations::parse(std::string_view text) const {
+        PermutationKey key = 0;
+        std::istringstream stream { std::string(text) };
+        std::string assignment;
+        while (stream >> assignment) {
+            const size_t equals = assignment.find('=');
+            if (equals == std::string::npos) {
+                return {};
+            }
+            const std::string_view name = std::string_view(assignment).substr(0, equals);
+            const std::string_view digits = std::string_view(assignment).substr(equals + 1);
+            uint32_t parsed = 0;
+            if (std::from_chars(digits.data(), digits.data() + digits.size(), parsed).ec != std::errc {}) {
+                return {};
+            }
+            const auto option = std::ranges::find(options, name, &ShaderOption::name);
+            if (option == options.end() || parsed >= option->value_count) {
+                return {};
+            }
+            key = with(key, static_cast<size_t>(option - options.begin()), parsed);
+        }
+        return key;
+    }
+
+    std::map<std::string, std::vector<std::string>> read_permutation_manifest(const std::filesystem::path& path) {
+        std::map<std::string, std::vector<std::string>> manifest;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream stream(line);
+            std::string pipeline;
+            if (!(stream >> pipeline) || pipeline.starts_with('#')) {
+                continue;
+            }
+            std::string options;
+            std::getline(stream >> std::ws, options);
+            manifest[pipeline].push_back(options);
+        }
+        return manifest;
+    }
+
+    bool write_permutation_manifest(const std::filesystem::path& path, const std::map<std::string, std::vector<std::string>>& manifest) {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << "# Pipeline permutations seen in use, built in the background at startup.\n";
+        for (const auto& [pipeline, entries] : manifest) {
+            for (const std::string& options : entries) {
+                file << pipeline << ' ' << options << '\n';
+            }
+        }
+        return static_cast<bool>(file);
+    }
+}
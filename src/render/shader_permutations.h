@@ -0,0 +1,64 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+#include "graphics/vulkan/vulkan_shader_compiler.h"
+
+namespace Posideon {
+    enum class ShaderOptionKind : uint8_t {
+        // Compiled into a separate module, for options that change interfaces or buffer layouts.
+        Define,
+        // Shares one module, the value is folded in when the pipeline is created.
+        Specialization
+    };
+
+    struct ShaderOption {
+        std::string name;
+        ShaderOptionKind kind = ShaderOptionKind::Define;
+        uint32_t value_count = 2;
+        uint32_t constant_id = 0;
+    };
+
+    // Option values packed into one integer, each option taking just enough bits for its value count.
+    using PermutationKey = uint32_t;
+
+    struct ShaderSpecialization {
+        std::vector<VkSpecializationMapEntry> entries;
+        std::vector<uint32_t> data;
+
+        // Points into this object, which has to outlive pipeline creation.
+        [[nodiscard]] VkSpecializationInfo info() const;
+    };
+
+    // The options one pipeline varies along. Defines are set to their value in every stage, specialization
+    // constants are passed to every stage and ignored by those that do not declare the id.
+    struct PipelinePermutations {
+        std::string name;
+        std::vector<ShaderOption> options;
+
+        [[nodiscard]] uint32_t value(PermutationKey key, size_t option) const;
+        [[nodiscard]] PermutationKey with(PermutationKey key, size_t option, uint32_t value) const;
+        [[nodiscard]] std::vector<ShaderDefine> defines(PermutationKey key) const;
+        // The key with every specialization option cleared. Keys with the same module key share their modules.
+        [[nodiscard]] PermutationKey module_key(PermutationKey key) const;
+        [[nodiscard]] ShaderSpecialization specialization(PermutationKey key) const;
+        // "QUANTIZED_VERTICES=1 DEBUG_VIEW=2", parse() accepts the same form and leaves missing options at 0.
+        [[nodiscard]] std::string format(PermutationKey key) const;
+        [[nodiscard]] std::optional<PermutationKey> parse(std::string_view text) const;
+    };
+
+    // The manifest lists the permutations seen in use, one per line as "<pipeline> OPTION=value ...", so the
+    // next run can build them before the first frame needs them. Entries are kept as text grouped by pipeline
+    // name, PipelinePermutations::parse turns them into keys.
+    [[nodiscard]] std::map<std::string, std::vector<std::string>> read_permutation_manifest(const std::filesystem::path& path);
+    bool write_permutation_manifest(const std::filesystem::path& path, const std::map<std::string, std::vector<std::string>>& manifest);
+}
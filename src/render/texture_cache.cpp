@@ -0,0 +1,76 @@
+#include "texture_cache.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace Posideon {
+    uint32_t mip_level_count(uint32_t width, uint32_t height) {
+        return static_cast<uint32_t>(std::bit_width(std::max({ width, height, 1u })));
+    }
+
+    void TextureCache::init(const VulkanDevice& device) {
+        m_device = &device;
+    }
+
+    void TextureCache::destroy() {
+        m_names.clear();
+        m_textures.clear();
+        for (const auto& [descriptor, sampler] : m_samplers) {
+            m_device->destroy_sampler(sampler);
+        }
+        m_samplers.clear();
+    }
+
+    TextureHandle TextureCache::add(std::string name, UniqueImage image, uint32_t mip_levels) {
+        const TextureHandle handle { static_cast<uint32_t>(m_textures.size()) };
+        m_names.emplace(name, handle);
+        m_textures.push_back(Texture { .name = std::move(name), .image = std::move(image), .mip_levels = mip_levels });
+        return handle;
+    }
+
+    void TextureCache::replace(TextureHandle texture, UniqueImage image, uint32_t mip_levels) {
+        m_textures[texture.index].image = std::move(image);
+        m_textures[texture.index].mip_levels = mip_levels;
+    }
+
+    std::optional<TextureHandle> TextureCache::find(const std::string& name) const {
+        const auto texture = m_names.find(name);
+        if (texture == m_names.end()) {
+            return {};
+        }
+        return texture->second;
+    }
+
+    VkSampler TextureCache::sampler(const SamplerDescriptor& descriptor) {
+        for (const auto& [cached, sampler] : m_samplers) {
+            if (cached == descriptor) {
+                return sampler;
+            }
+        }
+
+        const VkSamplerCreateInfo create_info {
+            .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+            .magFilter = descriptor.filter,
+            .minFilter = descriptor.filter,
+            .mipmapMode = descriptor.mipmap_mode,
+            .addressModeU = descriptor.address_mode,
+            .addressModeV = descriptor.address_mode,
+            .addressModeW = descriptor.address_mode,
+            .anisotropyEnable = descriptor.max_anisotropy > 0.0f ? VK_TRUE : VK_FALSE,
+            .maxAnisotropy = descriptor.max_anisotropy,
+            .minLod = 0.0f,
+            .maxLod = VK_LOD_CLAMP_NONE,
+        };
+        const VkSampler sampler = m_device->create_sampler(create_info, "texture_sampler");
+        m_samplers.emplace_back(descriptor, sampler);
+        return sampler;
+    }
+
+    VkDescriptorImageInfo TextureCache::descriptor(TextureHandle texture, VkSampler sampler) const {
+        return VkDescriptorImageInfo {
+            .sampler = sampler,
+            .imageView = m_textures[texture.index].image->image_view,
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        };
+    }
+}
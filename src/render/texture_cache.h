@@ -0,0 +1,61 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "graphics/vulkan/vulkan_resources.h"
+
+namespace Posideon {
+    struct TextureHandle {
+        uint32_t index = UINT32_MAX;
+
+        [[nodiscard]] bool valid() const { return index != UINT32_MAX; }
+    };
+
+    struct SamplerDescriptor {
+        VkFilter filter = VK_FILTER_LINEAR;
+        VkSamplerMipmapMode mipmap_mode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        VkSamplerAddressMode address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        float max_anisotropy = 0.0f;
+
+        bool operator==(const SamplerDescriptor&) const = default;
+    };
+
+    [[nodiscard]] uint32_t mip_level_count(uint32_t width, uint32_t height);
+
+    // Owns uploaded textures by name and deduplicates samplers, so materials only hold handles. Uploading
+    // goes through Renderer::upload_textures, which batches a whole set into one submit.
+    class TextureCache {
+        struct Texture {
+            std::string name;
+            UniqueImage image;
+            uint32_t mip_levels;
+        };
+
+        const VulkanDevice* m_device = nullptr;
+        std::vector<Texture> m_textures;
+        std::unordered_map<std::string, TextureHandle> m_names;
+        std::vector<std::pair<SamplerDescriptor, VkSampler>> m_samplers;
+
+    public:
+        void init(const VulkanDevice& device);
+        void destroy();
+
+        TextureHandle add(std::string name, UniqueImage image, uint32_t mip_levels);
+        // The previous image is retired, frames in flight keep sampling it until they complete.
+        void replace(TextureHandle texture, UniqueImage image, uint32_t mip_levels);
+        [[nodiscard]] std::optional<TextureHandle> find(const std::string& name) const;
+        [[nodiscard]] const VulkanImage& image(TextureHandle texture) const { return m_textures[texture.index].image.get(); }
+        [[nodiscard]] uint32_t mip_levels(TextureHandle texture) const { return m_textures[texture.index].mip_levels; }
+        [[nodiscard]] size_t size() const { return m_textures.size(); }
+
+        [[nodiscard]] VkSampler sampler(const SamplerDescriptor& descriptor = {});
+        [[nodiscard]] VkDescriptorImageInfo descriptor(TextureHandle texture, VkSampler sampler) const;
+    };
+}
@@ -0,0 +1,229 @@
+#include "texture_streamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace Posideon {
+    namespace {
+        // Copy offsets into the staging buffer must be a multiple of the block size, 16 covers every BC format.
+        constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+        VkDeviceSize align_staging(VkDeviceSize offset) {
+            return (offset + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+        }
+
+        uint64_t level_size(const CompressedTexture& texture, uint32_t level) {
+            const uint64_t end = level + 1 < texture.level_offsets.size() ? texture.level_offsets[level + 1] : texture.data.size();
+            return end - texture.level_offsets[level];
+        }
+
+        VkExtent2D level_extent(const CompressedTexture& texture, uint32_t level) {
+            return { std::max(texture.width >> level, 1u), std::max(texture.height >> level, 1u) };
+        }
+    }
+
+    uint32_t feedback_mip(uint32_t request, uint32_t width, uint32_t height) {
+        const float footprint = static_cast<float>(request) / 16.0f - 32.0f;
+        const float lod = footprint + std::log2(static_cast<float>(std::max({ width, height, 1u })));
+        return lod <= 0.0f ? 0u : static_cast<uint32_t>(lod);
+    }
+
+    void TextureStreamer::init(VulkanDevice& device) {
+        m_device = &device;
+        // Under memory pressure the budget shrinks below what is resident by the requested bytes, so the next
+        // update drops the stalest levels first. It never goes below the tails, which are not evicted.
+        device.register_evictor(MemoryCategory::Texture, [this](uint64_t bytes_to_free) {
+            uint64_t tails = 0;
+            for (const StreamedTexture& texture : m_textures) {
+                tails += resident_size(texture, texture.tail_mip);
+            }
+            const uint64_t budget = std::min(m_pressure_budget, m_resident_bytes);
+            const uint64_t freed = std::min(bytes_to_free, budget - std::min(budget, tails));
+            m_pressure_budget = budget - freed;
+            m_pressure_frame = m_frame;
+            return freed;
+        });
+    }
+
+    void TextureStreamer::destroy() {
+        m_textures.clear();
+        m_resident_bytes = 0;
+        m_pressure_budget = UINT64_MAX;
+    }
+
+    uint64_t TextureStreamer::resident_size(const StreamedTexture& texture, uint32_t mip) const {
+        return texture.source.data.size() - texture.source.level_offsets[mip];
+    }
+
+    uint32_t TextureStreamer::initial_mip(const CompressedTexture& texture) const {
+        uint32_t mip = 0;
+        while (mip + 1 < texture.level_offsets.size() && std::max(texture.width >> mip, texture.height >> mip) > tail_size) {
+            mip++;
+        }
+        return mip;
+    }
+
+    void TextureStreamer::add(TextureHandle handle, CompressedTexture source, uint32_t resident_mip) {
+        if (handle.index >= MAX_STREAMED_TEXTURES) {
+            return;
+        }
+        const uint32_t tail_mip = initial_mip(source);
+        StreamedTexture& texture = m_textures.emplace_back(StreamedTexture {
+            .handle = handle,
+            .source = std::move(source),
+            .resident_mip = resident_mip,
+            .tail_mip = tail_mip,
+            .requested_mip = tail_mip,
+        });
+        m_resident_bytes += resident_size(texture, resident_mip);
+    }
+
+    void TextureStreamer::read_feedback(std::span<uint32_t> requests, uint64_t frame) {
+        for (StreamedTexture& texture : m_textures) {
+            const uint32_t request = requests[texture.handle.index];
+            if (request != NO_TEXTURE_FEEDBACK) {
+                texture.requested_mip = std::min(feedback_mip(request, texture.source.width, texture.source.height), texture.tail_mip);
+                texture.last_requested_frame = frame;
+            }
+        }
+        std::fill(requests.begin(), requests.end(), NO_TEXTURE_FEEDBACK);
+    }
+
+    void TextureStreamer::update(TextureCache& cache, const VulkanCommandEncoder& encoder, uint64_t frame) {
+        m_frame = frame;
+        if (m_pressure_budget != UINT64_MAX && frame - m_pressure_frame > pressure_hold_frames) {
+            m_pressure_budget += max_upload_bytes_per_frame;
+            if (m_pressure_budget >= budget_bytes) {
+                m_pressure_budget = UINT64_MAX;
+            }
+        }
+        if (m_textures.empty()) {
+            return;
+        }
+
+        std::vector<uint32_t> targets(m_textures.size());
+        uint64_t total = 0;
+        for (size_t i = 0; i < m_textures.size(); i++) {
+            const StreamedTexture& texture = m_textures[i];
+            targets[i] = frame - texture.last_requested_frame > evict_after_frames ? texture.tail_mip : texture.requested_mip;
+            total += resident_size(texture, targets[i]);
+        }
+
+        const uint64_t budget = std::min(budget_bytes, m_pressure_budget);
+
+        // Stalest first, and among equally fresh textures the one asking for the finest level.
+        std::vector<uint32_t> order(m_textures.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            if (m_textures[a].last_requested_frame != m_textures[b].last_requested_frame) {
+                return m_textures[a].last_requested_frame < m_textures[b].last_requested_frame;
+            }
+            return targets[a] < targets[b];
+        });
+        // Over budget every texture gives up one level per pass in that order, until it fits or all are at their tail.
+        bool coarsened = true;
+        while (total > budget && coarsened) {
+            coarsened = false;
+            for (const uint32_t i : order) {
+                if (total <= budget) {
+                    break;
+                }
+                const StreamedTexture& texture = m_textures[i];
+                if (targets[i] < texture.tail_mip) {
+                    total -= resident_size(texture, targets[i]) - resident_size(texture, targets[i] + 1);
+                    targets[i]++;
+                    coarsened = true;
+                }
+            }
+        }
+
+        // Freshest requests stream in first. Levels are added from the coarse end, and a texture always gets
+        // at least one level when nothing else was uploaded this frame, so a large top level cannot starve.
+        std::vector<std::pair<uint32_t, uint32_t>> stream_ins;
+        VkDeviceSize upload_bytes = 0;
+        for (auto i = order.rbegin(); i != order.rend(); ++i) {
+            const StreamedTexture& texture = m_textures[*i];
+            uint32_t mip = texture.resident_mip;
+            while (mip > targets[*i]) {
+                const VkDeviceSize size = align_staging(level_size(texture.source, mip - 1));
+                if (upload_bytes + size > max_upload_bytes_per_frame && upload_bytes > 0) {
+                    break;
+                }
+                upload_bytes += size;
+                mip--;
+            }
+            if (mip < texture.resident_mip) {
+                stream_ins.emplace_back(*i, mip);
+            }
+        }
+
+        const bool evicting = std::any_of(order.begin(), order.end(), [&](uint32_t i) { return targets[i] > m_textures[i].resident_mip; });
+        if (!evicting && stream_ins.empty()) {
+            return;
+        }
+
+        const auto label = encoder.scoped_label("texture_streaming");
+        VkDeviceSize staging_offset = 0;
+        for (uint32_t i = 0; i < m_textures.size(); i++) {
+            if (targets[i] > m_textures[i].resident_mip) {
+                m_resident_bytes -= resident_size(m_textures[i], m_textures[i].resident_mip) - resident_size(m_textures[i], targets[i]);
+                relocate(m_textures[i], targets[i], cache, encoder, nullptr, staging_offset);
+            }
+        }
+        if (stream_ins.empty()) {
+            return;
+        }
+
+        // Released through the deletion queue once this frame retires.
+        const UniqueBuffer staging(*m_device, m_device->create_buffer(
+            upload_bytes,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_MEMORY_USAGE_CPU_ONLY,
+            MemoryCategory::Staging,
+            "texture_streaming_staging"
+        ));
+        for (const auto& [i, mip] : stream_ins) {
+            m_resident_bytes += resident_size(m_textures[i], mip) - resident_size(m_textures[i], m_textures[i].resident_mip);
+            relocate(m_textures[i], mip, cache, encoder, &staging.get(), staging_offset);
+        }
+    }
+
+    void TextureStreamer::relocate(StreamedTexture& texture, uint32_t mip, TextureCache& cache, const VulkanCommandEncoder& encoder,
+                                   const VulkanBuffer* staging, VkDeviceSize& staging_offset) const {
+        const CompressedTexture& source = texture.source;
+        const uint32_t level_count = static_cast<uint32_t>(source.level_offsets.size());
+        const VkExtent2D extent = level_extent(source, mip);
+        UniqueImage image(*m_device, m_device->create_image({
+            .image_type = VK_IMAGE_TYPE_2D,
+            .format = source.format,
+            .width = extent.width,
+            .height = extent.height,
+            .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .initial_layout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .image_view_type = VK_IMAGE_VIEW_TYPE_2D,
+            .aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mip_levels = level_count - mip,
+        }, MemoryCategory::Texture, source.name.c_str()));
+
+        const VkImage previous = cache.image(texture.handle).image;
+        encoder.transition_image(image->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        encoder.transition_image(previous, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+        // Levels both images hold are copied on the GPU, only newly streamed levels come from the CPU copy.
+        for (uint32_t level = std::max(mip, texture.resident_mip); level < level_count; level++) {
+            encoder.copy_image_level(previous, image->image, level_extent(source, level), level - texture.resident_mip, level - mip);
+        }
+        for (uint32_t level = mip; level < texture.resident_mip; level++) {
+            const uint64_t size = level_size(source, level);
+            memcpy(static_cast<char*>(staging->allocation_info.pMappedData) + staging_offset, source.data.data() + source.level_offsets[level], size);
+            encoder.copy_buffer_to_image(staging->buffer, image->image, level_extent(source, level), staging_offset, level - mip);
+            staging_offset = align_staging(staging_offset + size);
+        }
+        encoder.transition_image(image->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        cache.replace(texture.handle, std::move(image), level_count - mip);
+        texture.resident_mip = mip;
+    }
+}
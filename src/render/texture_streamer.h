@@ -0,0 +1,75 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "assets/ktx2_loader.h"
+#include "graphics/vulkan/vulkan_command_encoder.h"
+#include "graphics/vulkan/vulkan_resources.h"
+#include "render/texture_cache.h"
+
+namespace Posideon {
+    // Feedback slots are indexed by texture cache handle, textures past the last slot are never streamed.
+    static constexpr uint32_t MAX_STREAMED_TEXTURES = 4096;
+    static constexpr uint32_t NO_TEXTURE_FEEDBACK = UINT32_MAX;
+
+    // mesh.frag writes atomicMin of the pixel footprint in uv space as log2(footprint) + 32 in 12.4 fixed
+    // point, so requests do not depend on which mips are resident. Converts one back to a mip level.
+    [[nodiscard]] uint32_t feedback_mip(uint32_t request, uint32_t width, uint32_t height);
+
+    // Mip streaming for block compressed textures. Every streamed texture keeps its mip tail resident and
+    // holds the whole chain on the CPU. Shaders report the finest level each texture was sampled at into a
+    // per-frame feedback buffer, read back once the frame's fence retires. update then moves textures
+    // towards the requested levels within budget_bytes, at most max_upload_bytes_per_frame per frame, by
+    // recreating the image on the frame's command buffer. The previous image goes through the deletion
+    // queue, so descriptors have to be fetched from the cache again after an update.
+    class TextureStreamer {
+        struct StreamedTexture {
+            TextureHandle handle;
+            CompressedTexture source;
+            // Finest level on the GPU, the tail level is the finest one that is never evicted.
+            uint32_t resident_mip;
+            uint32_t tail_mip;
+            uint32_t requested_mip;
+            uint64_t last_requested_frame = 0;
+        };
+
+        VulkanDevice* m_device = nullptr;
+        std::vector<StreamedTexture> m_textures;
+        // Budget lowered by memory pressure. It is held until no pressure has been reported for
+        // pressure_hold_frames and then grows back by max_upload_bytes_per_frame a frame.
+        uint64_t m_pressure_budget = UINT64_MAX;
+        uint64_t m_pressure_frame = 0;
+        uint64_t m_frame = 0;
+        uint64_t m_resident_bytes = 0;
+
+        [[nodiscard]] uint64_t resident_size(const StreamedTexture& texture, uint32_t mip) const;
+        void relocate(StreamedTexture& texture, uint32_t mip, TextureCache& cache, const VulkanCommandEncoder& encoder,
+            const VulkanBuffer* staging, VkDeviceSize& staging_offset) const;
+
+    public:
+        uint64_t budget_bytes = 512ull * 1024 * 1024;
+        VkDeviceSize max_upload_bytes_per_frame = 16 * 1024 * 1024;
+        // Levels at or below this size in both dimensions form the tail.
+        uint32_t tail_size = 64;
+        // Frames without a request before a texture falls back to its tail.
+        uint32_t evict_after_frames = 120;
+        uint32_t pressure_hold_frames = 120;
+
+        void init(VulkanDevice& device);
+        void destroy();
+
+        // First level of the tail, textures are uploaded from here and streamed in when this is above zero.
+        [[nodiscard]] uint32_t initial_mip(const CompressedTexture& texture) const;
+        void add(TextureHandle handle, CompressedTexture source, uint32_t resident_mip);
+
+        // Consumes the requests of a retired frame and resets them for the next use of the buffer.
+        void read_feedback(std::span<uint32_t> requests, uint64_t frame);
+        void update(TextureCache& cache, const VulkanCommandEncoder& encoder, uint64_t frame);
+
+        [[nodiscard]] uint64_t resident_bytes() const { return m_resident_bytes; }
+        [[nodiscard]] size_t size() const { return m_textures.size(); }
+    };
+}
@@ -0,0 +1,41 @@
+#include "bounds.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Posideon {
+    MeshBounds asset_bounds(const GltfAsset& asset) {
+        glm::vec3 center = asset.surface_lods.empty() ? glm::vec3(0.0f) : asset.surface_lods[0].center;
+        float radius = asset.surface_lods.empty() ? 0.0f : asset.surface_lods[0].radius;
+        for (const SurfaceLods& surface : asset.surface_lods) {
+            const float distance = glm::length(surface.center - center);
+            if (radius >= distance + surface.radius) {
+                continue;
+            }
+            if (surface.radius >= distance + radius) {
+                center = surface.center;
+                radius = surface.radius;
+                continue;
+            }
+            const float merged = (distance + radius + surface.radius) * 0.5f;
+            center += (surface.center - center) * ((merged - radius) / distance);
+            radius = merged;
+        }
+        return MeshBounds { .center = center, .radius = radius, .extents = glm::vec3(radius) };
+    }
+
+    MeshBounds transform_bounds(const MeshBounds& bounds, const glm::mat4& model) {
+        const float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+        // Extents of the rotated box along the world axes, from the absolute upper 3x3.
+        const glm::vec3 extents {
+            std::abs(model[0].x) * bounds.extents.x + std::abs(model[1].x) * bounds.extents.y + std::abs(model[2].x) * bounds.extents.z,
+            std::abs(model[0].y) * bounds.extents.x + std::abs(model[1].y) * bounds.extents.y + std::abs(model[2].y) * bounds.extents.z,
+            std::abs(model[0].z) * bounds.extents.x + std::abs(model[1].z) * bounds.extents.y + std::abs(model[2].z) * bounds.extents.z,
+        };
+        return MeshBounds {
+            .center = model * glm::vec4(bounds.center, 1.0f),
+            .radius = bounds.radius * scale,
+            .extents = extents,
+        };
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "defines.h"
+#include <glm/glm.hpp>
+
+#include "assets/gltf_loader.h"
+
+namespace Posideon {
+    // Model space bounds of an entity's mesh, as a sphere and an AABB sharing the same center.
+    struct MeshBounds {
+        glm::vec3 center { 0.0f };
+        float radius = 0.0f;
+        glm::vec3 extents { 0.0f };
+    };
+
+    // Smallest merged sphere around every surface of the asset. Surfaces only carry spheres, so the box is
+    // the cube enclosing it.
+    [[nodiscard]] MeshBounds asset_bounds(const GltfAsset& asset);
+    [[nodiscard]] MeshBounds transform_bounds(const MeshBounds& bounds, const glm::mat4& model);
+}
@@ -0,0 +1,398 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace Posideon {
+    namespace {
+        constexpr uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+        constexpr uint32_t MAX_SAH_BINS = 32;
+        // Nodes this small become leaves when no split beats the leaf cost, larger ones fall back to a median split.
+        constexpr uint32_t MAX_FALLBACK_LEAF = 16;
+
+        Aabb empty_aabb() {
+            return Aabb { glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) };
+        }
+
+        void grow(Aabb& bounds, const Aabb& other) {
+            bounds.min = glm::min(bounds.min, other.min);
+            bounds.max = glm::max(bounds.max, other.max);
+        }
+
+        void grow(Aabb& bounds, const glm::vec3& point) {
+            bounds.min = glm::min(bounds.min, point);
+            bounds.max = glm::max(bounds.max, point);
+        }
+
+        float surface_area(const Aabb& bounds) {
+            const glm::vec3 size = bounds.max - bounds.min;
+            if (size.x < 0.0f || size.y < 0.0f || size.z < 0.0f) {
+                return 0.0f;
+            }
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        glm::vec3 centroid(const Aabb& bounds) {
+            return (bounds.min + bounds.max) * 0.5f;
+        }
+
+        bool overlaps(const Aabb& a, const Aabb& b) {
+            return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+                a.min.y <= b.max.y && a.max.y >= b.min.y &&
+                a.min.z <= b.max.z && a.max.z >= b.min.z;
+        }
+
+        enum class Containment {
+            Outside,
+            Intersecting,
+            Inside
+        };
+
+        Containment classify(const Frustum& frustum, const Aabb& bounds) {
+            const glm::vec3 center = centroid(bounds);
+            const glm::vec3 extents = (bounds.max - bounds.min) * 0.5f;
+            Containment result = Containment::Inside;
+            for (const glm::vec4& plane : frustum.planes) {
+                const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+                const float reach = std::abs(plane.x) * extents.x + std::abs(plane.y) * extents.y + std::abs(plane.z) * extents.z;
+                if (distance < -reach) {
+                    return Containment::Outside;
+                }
+                if (distance < reach) {
+                    result = Containment::Intersecting;
+                }
+            }
+            return result;
+        }
+
+        // Entry distance of the ray into the box, or infinity when it misses within max_distance.
+        float intersect(const Ray& ray, const glm::vec3& inverse_direction, const Aabb& bounds) {
+            const glm::vec3 t0 = (bounds.min - ray.origin) * inverse_direction;
+            const glm::vec3 t1 = (bounds.max - ray.origin) * inverse_direction;
+            const glm::vec3 near = glm::min(t0, t1);
+            const glm::vec3 far = glm::max(t0, t1);
+            const float enter = std::max({ near.x, near.y, near.z, 0.0f });
+            const float exit = std::min({ far.x, far.y, far.z, ray.max_distance });
+            return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+        }
+    }
+
+    void Bvh::clear() {
+        m_nodes.clear();
+        m_objects.clear();
+        m_bounds.clear();
+        m_ids.clear();
+        m_object_slots.clear();
+        m_object_leaves.clear();
+        m_dirty_leaves.clear();
+        m_node_dirty.clear();
+        m_refit_levels.clear();
+        m_build_cost = 0.0f;
+        m_area_sum = 0.0;
+    }
+
+    void Bvh::build(std::span<const Aabb> bounds, std::span<const uint64_t> ids) {
+        clear();
+        m_ids.assign(ids.begin(), ids.end());
+        const uint32_t object_count = static_cast<uint32_t>(bounds.size());
+        if (object_count == 0) {
+            return;
+        }
+
+        m_objects.resize(object_count);
+        std::iota(m_objects.begin(), m_objects.end(), 0);
+        m_object_leaves.resize(object_count);
+        m_nodes.reserve(2 * static_cast<size_t>(object_count));
+        m_nodes.push_back(Node { .bounds = empty_aabb(), .first = 0, .count = object_count, .parent = NO_PARENT, .depth = 0 });
+
+        const uint32_t bin_count = std::clamp(settings.sah_bins, 2u, MAX_SAH_BINS);
+        std::vector<uint32_t> stack { 0 };
+        while (!stack.empty()) {
+            const uint32_t node_index = stack.back();
+            stack.pop_back();
+            const uint32_t first = m_nodes[node_index].first;
+            const uint32_t count = m_nodes[node_index].count;
+
+            Aabb node_bounds = empty_aabb();
+            Aabb centroid_bounds = empty_aabb();
+            for (uint32_t i = first; i < first + count; i++) {
+                grow(node_bounds, bounds[m_objects[i]]);
+                grow(centroid_bounds, centroid(bounds[m_objects[i]]));
+            }
+            m_nodes[node_index].bounds = node_bounds;
+
+            const auto make_leaf = [&] {
+                for (uint32_t i = first; i < first + count; i++) {
+                    m_object_leaves[m_objects[i]] = node_index;
+                }
+            };
+            if (count <= settings.max_leaf_objects) {
+                make_leaf();
+                continue;
+            }
+
+            // Binned SAH, the split cost is compared against keeping every object in one leaf.
+            float best_cost = surface_area(node_bounds) * static_cast<float>(count);
+            int32_t best_axis = -1;
+            uint32_t best_split = 0;
+            for (int32_t axis = 0; axis < 3; axis++) {
+                const float extent = centroid_bounds.max[axis] - centroid_bounds.min[axis];
+                if (extent <= 0.0f) {
+                    continue;
+                }
+                const float scale = static_cast<float>(bin_count) / extent;
+
+                std::array<Aabb, MAX_SAH_BINS> bin_bounds;
+                std::array<uint32_t, MAX_SAH_BINS> bin_objects {};
+                bin_bounds.fill(empty_aabb());
+                for (uint32_t i = first; i < first + count; i++) {
+                    const Aabb& object_bounds = bounds[m_objects[i]];
+                    const uint32_t bin = std::min(bin_count - 1, static_cast<uint32_t>((centroid(object_bounds)[axis] - centroid_bounds.min[axis]) * scale));
+                    grow(bin_bounds[bin], object_bounds);
+                    bin_objects[bin]++;
+                }
+
+                std::array<float, MAX_SAH_BINS> right_cost {};
+                Aabb right = empty_aabb();
+                uint32_t right_count = 0;
+                for (uint32_t bin = bin_count - 1; bin > 0; bin--) {
+                    grow(right, bin_bounds[bin]);
+                    right_count += bin_objects[bin];
+                    right_cost[bin] = surface_area(right) * static_cast<float>(right_count);
+                }
+
+                Aabb left = empty_aabb();
+                uint32_t left_count = 0;
+                for (uint32_t split = 1; split < bin_count; split++) {
+                    grow(left, bin_bounds[split - 1]);
+                    left_count += bin_objects[split - 1];
+                    const float split_cost = surface_area(left) * static_cast<float>(left_count) + right_cost[split];
+                    if (left_count > 0 && left_count < count && split_cost < best_cost) {
+                        best_cost = split_cost;
+                        best_axis = axis;
+                        best_split = split;
+                    }
+                }
+            }
+
+            uint32_t left_count = 0;
+            if (best_axis >= 0) {
+                const float scale = static_cast<float>(bin_count) / (centroid_bounds.max[best_axis] - centroid_bounds.min[best_axis]);
+                const auto middle = std::partition(m_objects.begin() + first, m_objects.begin() + first + count, [&](uint32_t object) {
+                    const float offset = centroid(bounds[object])[best_axis] - centroid_bounds.min[best_axis];
+                    return std::min(bin_count - 1, static_cast<uint32_t>(offset * scale)) < best_split;
+                });
+                left_count = static_cast<uint32_t>(middle - (m_objects.begin() + first));
+            } else if (count <= MAX_FALLBACK_LEAF) {
+                make_leaf();
+                continue;
+            } else {
+                const glm::vec3 extent = centroid_bounds.max - centroid_bounds.min;
+                const int32_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+                left_count = count / 2;
+                std::nth_element(m_objects.begin() + first, m_objects.begin() + first + left_count, m_objects.begin() + first + count, [&](uint32_t a, uint32_t b) {
+                    return centroid(bounds[a])[axis] < centroid(bounds[b])[axis];
+                });
+            }
+
+            const uint32_t left_index = static_cast<uint32_t>(m_nodes.size());
+            const uint32_t depth = m_nodes[node_index].depth + 1;
+            m_nodes.push_back(Node { .bounds = empty_aabb(), .first = first, .count = left_count, .parent = node_index, .depth = depth });
+            m_nodes.push_back(Node { .bounds = empty_aabb(), .first = first + left_count, .count = count - left_count, .parent = node_index, .depth = depth });
+            m_nodes[node_index].first = left_index;
+            m_nodes[node_index].count = 0;
+            stack.push_back(left_index);
+            stack.push_back(left_index + 1);
+        }
+
+        // Object bounds are stored in leaf order so refits and queries read them contiguously.
+        m_bounds.resize(object_count);
+        m_object_slots.resize(object_count);
+        for (uint32_t slot = 0; slot < object_count; slot++) {
+            m_bounds[slot] = bounds[m_objects[slot]];
+            m_object_slots[m_objects[slot]] = slot;
+        }
+        m_node_dirty.assign(m_nodes.size(), false);
+        for (const Node& node : m_nodes) {
+            m_area_sum += node_cost(node);
+        }
+        m_build_cost = tree_cost();
+    }
+
+    void Bvh::update(uint32_t object, const Aabb& bounds) {
+        m_bounds[m_object_slots[object]] = bounds;
+        m_dirty_leaves.push_back(m_object_leaves[object]);
+    }
+
+    void Bvh::refit() {
+        // Collect the union of the paths above dirty leaves, each node once, bucketed by depth so every
+        // node is recomputed after its children.
+        for (const uint32_t leaf : m_dirty_leaves) {
+            for (uint32_t node = leaf; node != NO_PARENT && !m_node_dirty[node]; node = m_nodes[node].parent) {
+                m_node_dirty[node] = true;
+                if (m_nodes[node].depth >= m_refit_levels.size()) {
+                    m_refit_levels.resize(m_nodes[node].depth + 1);
+                }
+                m_refit_levels[m_nodes[node].depth].push_back(node);
+            }
+        }
+        m_dirty_leaves.clear();
+
+        for (auto level = m_refit_levels.rbegin(); level != m_refit_levels.rend(); ++level) {
+            for (const uint32_t node_index : *level) {
+                Node& node = m_nodes[node_index];
+                m_node_dirty[node_index] = false;
+                m_area_sum -= node_cost(node);
+                if (node.count > 0) {
+                    Aabb bounds = empty_aabb();
+                    for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                        grow(bounds, m_bounds[i]);
+                    }
+                    node.bounds = bounds;
+                } else {
+                    node.bounds = m_nodes[node.first].bounds;
+                    grow(node.bounds, m_nodes[node.first + 1].bounds);
+                }
+                m_area_sum += node_cost(node);
+            }
+            level->clear();
+        }
+    }
+
+    float Bvh::node_cost(const Node& node) {
+        return surface_area(node.bounds) * static_cast<float>(node.count > 0 ? node.count : 1);
+    }
+
+    float Bvh::tree_cost() const {
+        if (m_nodes.empty()) {
+            return 0.0f;
+        }
+        return static_cast<float>(m_area_sum) / std::max(surface_area(m_nodes[0].bounds), std::numeric_limits<float>::min());
+    }
+
+    float Bvh::cost_ratio() const {
+        return m_build_cost > 0.0f ? tree_cost() / m_build_cost : 1.0f;
+    }
+
+    void Bvh::query_frustum(const Frustum& frustum, std::vector<uint32_t>& results) const {
+        if (m_nodes.empty()) {
+            return;
+        }
+
+        struct Entry {
+            uint32_t node;
+            bool inside;
+        };
+        std::vector<Entry> stack { { 0, false } };
+        while (!stack.empty()) {
+            const Entry entry = stack.back();
+            stack.pop_back();
+            const Node& node = m_nodes[entry.node];
+
+            bool inside = entry.inside;
+            if (!inside) {
+                const Containment containment = classify(frustum, node.bounds);
+                if (containment == Containment::Outside) {
+                    continue;
+                }
+                inside = containment == Containment::Inside;
+            }
+
+            if (node.count > 0) {
+                for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                    if (inside || classify(frustum, m_bounds[i]) != Containment::Outside) {
+                        results.push_back(m_objects[i]);
+                    }
+                }
+            } else {
+                stack.push_back({ node.first, inside });
+                stack.push_back({ node.first + 1, inside });
+            }
+        }
+    }
+
+    void Bvh::query_aabb(const Aabb& bounds, std::vector<uint32_t>& results) const {
+        if (m_nodes.empty()) {
+            return;
+        }
+
+        std::vector<uint32_t> stack { 0 };
+        while (!stack.empty()) {
+            const Node& node = m_nodes[stack.back()];
+            stack.pop_back();
+            if (!overlaps(node.bounds, bounds)) {
+                continue;
+            }
+
+            if (node.count > 0) {
+                for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                    if (overlaps(m_bounds[i], bounds)) {
+                        results.push_back(m_objects[i]);
+                    }
+                }
+            } else {
+                stack.push_back(node.first);
+                stack.push_back(node.first + 1);
+            }
+        }
+    }
+
+    std::optional<RayHit> Bvh::raycast(const Ray& ray) const {
+        if (m_nodes.empty()) {
+            return {};
+        }
+
+        const glm::vec3 inverse_direction = 1.0f / ray.direction;
+        std::optional<RayHit> closest;
+        float closest_distance = std::numeric_limits<float>::infinity();
+
+        struct Entry {
+            uint32_t node;
+            float distance;
+        };
+        std::vector<Entry> stack;
+        const float root_distance = intersect(ray, inverse_direction, m_nodes[0].bounds);
+        if (root_distance != std::numeric_limits<float>::infinity()) {
+            stack.push_back({ 0, root_distance });
+        }
+        while (!stack.empty()) {
+            const Entry entry = stack.back();
+            stack.pop_back();
+            if (entry.distance >= closest_distance) {
+                continue;
+            }
+            const Node& node = m_nodes[entry.node];
+
+            if (node.count > 0) {
+                for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                    const float distance = intersect(ray, inverse_direction, m_bounds[i]);
+                    if (distance < closest_distance) {
+                        closest_distance = distance;
+                        closest = RayHit { .object = m_objects[i], .distance = distance };
+                    }
+                }
+                continue;
+            }
+
+            // Push the farther child first so the nearer one is visited first and tightens the bound.
+            float left = intersect(ray, inverse_direction, m_nodes[node.first].bounds);
+            float right = intersect(ray, inverse_direction, m_nodes[node.first + 1].bounds);
+            uint32_t near_node = node.first;
+            uint32_t far_node = node.first + 1;
+            if (right < left) {
+                std::swap(left, right);
+                std::swap(near_node, far_node);
+            }
+            if (right < closest_distance) {
+                stack.push_back({ far_node, right });
+            }
+            if (left < closest_distance) {
+                stack.push_back({ near_node, left });
+            }
+        }
+        return closest;
+    }
+}
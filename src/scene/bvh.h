@@ -0,0 +1,88 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "render/frustum_culling.h"
+
+namespace Posideon {
+    struct Aabb {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    struct Ray {
+        glm::vec3 origin;
+        glm::vec3 direction;
+        float max_distance;
+    };
+
+    struct RayHit {
+        uint32_t object;
+        float distance;
+    };
+
+    struct BvhSettings {
+        uint32_t sah_bins = 12;
+        uint32_t max_leaf_objects = 4;
+    };
+
+    // Binary BVH over object AABBs, built with binned SAH. Objects keep their index from build() so moving
+    // objects can be updated in place and refitted along their leaf's path to the root. Refitting keeps
+    // the topology, so callers should rebuild once the tree cost drifts far from the build cost.
+    class Bvh {
+        struct Node {
+            Aabb bounds;
+            // Index of the left child for interior nodes, the right child follows it. First entry in
+            // m_objects for leaves.
+            uint32_t first;
+            uint32_t count;
+            uint32_t parent;
+            uint32_t depth;
+        };
+
+        std::vector<Node> m_nodes;
+        // Object index per leaf slot, and the object bounds in the same slot order.
+        std::vector<uint32_t> m_objects;
+        std::vector<Aabb> m_bounds;
+        std::vector<uint64_t> m_ids;
+        std::vector<uint32_t> m_object_slots;
+        std::vector<uint32_t> m_object_leaves;
+        std::vector<uint32_t> m_dirty_leaves;
+        std::vector<bool> m_node_dirty;
+        std::vector<std::vector<uint32_t>> m_refit_levels;
+        float m_build_cost = 0.0f;
+        // Sum of surface area times object count (one for interior nodes) over every node. Refit adjusts it
+        // for the nodes it touches, so the cost never needs a walk over the whole tree after build().
+        double m_area_sum = 0.0;
+
+        [[nodiscard]] static float node_cost(const Node& node);
+        [[nodiscard]] float tree_cost() const;
+
+    public:
+        BvhSettings settings;
+
+        void build(std::span<const Aabb> bounds, std::span<const uint64_t> ids);
+        void clear();
+
+        void update(uint32_t object, const Aabb& bounds);
+        // Refits only the nodes above leaves touched by update() since the last refit.
+        void refit();
+        // SAH cost of the current tree relative to the cost right after build().
+        [[nodiscard]] float cost_ratio() const;
+
+        [[nodiscard]] size_t size() const { return m_ids.size(); }
+        [[nodiscard]] bool empty() const { return m_ids.empty(); }
+        [[nodiscard]] uint64_t id(uint32_t object) const { return m_ids[object]; }
+
+        // Queries append object indices, use id() to map them back.
+        void query_frustum(const Frustum& frustum, std::vector<uint32_t>& results) const;
+        void query_aabb(const Aabb& bounds, std::vector<uint32_t>& results) const;
+        // Closest object whose bounds the ray enters, measured to the entry point.
+        [[nodiscard]] std::optional<RayHit> raycast(const Ray& ray) const;
+    };
+}
@@ -0,0 +1,28 @@
+#include "gltf_scene.h"
+
+#include <vector>
+
+#include "scene/mesh_renderer.h"
+#include "scene/transform.h"
+
+namespace Posideon {
+    flecs::entity instantiate_gltf_scene(flecs::world& world, const GltfScene& scene, const glm::mat4& transform) {
+        flecs::entity root = world.entity().set<LocalTransform>(LocalTransform { .matrix = transform });
+
+        // glTF names are not unique among siblings, so nodes are left unnamed rather than colliding in flecs.
+        std::vector<flecs::entity> entities;
+        entities.reserve(scene.nodes.size());
+        for (const BakedNode& node : scene.nodes) {
+            const flecs::entity parent = node.parent < 0 ? root : entities[node.parent];
+            flecs::entity entity = world.entity()
+                .child_of(parent)
+                .set<LocalTransform>(LocalTransform { .matrix = node.local });
+            if (node.mesh >= 0) {
+                const std::shared_ptr<GltfAsset>& asset = scene.meshes[node.mesh];
+                entity.set<MeshRenderer>(MeshRenderer { .asset = asset, .texture = asset->texture });
+            }
+            entities.push_back(entity);
+        }
+        return root;
+    }
+}
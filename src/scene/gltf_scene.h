@@ -0,0 +1,14 @@
+#pragma once
+
+#include "defines.h"
+#include <flecs.h>
+#include <glm/glm.hpp>
+
+#include "assets/gltf_loader.h"
+
+namespace Posideon {
+    // Creates one entity per node under a new root entity placed at transform. Node entities are parented
+    // with ChildOf and carry the node's LocalTransform, nodes with a mesh get a MeshRenderer sharing the
+    // scene's GltfAsset so repeated references batch into instanced draws instead of separate uploads.
+    flecs::entity instantiate_gltf_scene(flecs::world& world, const GltfScene& scene, const glm::mat4& transform = glm::mat4(1.0f));
+}
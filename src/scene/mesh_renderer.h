@@ -0,0 +1,18 @@
+#pragma once
+
+#include "defines.h"
+#include <memory>
+#include <glm/glm.hpp>
+
+#include "assets/gltf_loader.h"
+
+namespace Posideon {
+    // Draws the asset at the entity's Transform. The texture is the one its sampling is reported for in
+    // the streaming feedback.
+    struct MeshRenderer {
+        std::shared_ptr<GltfAsset> asset;
+        glm::vec4 color { 1.0f };
+        uint32_t material_id = 0;
+        TextureHandle texture;
+    };
+}
@@ -0,0 +1,70 @@
+#include "scene_bvh.h"
+
+#include "scene/bounds.h"
+#include "scene/mesh_renderer.h"
+#include "scene/transform.h"
+
+namespace Posideon {
+    namespace {
+        Aabb world_aabb(const Transform& transform, const MeshBounds& bounds) {
+            const MeshBounds world_bounds = transform_bounds(bounds, transform.model);
+            return Aabb { world_bounds.center - world_bounds.extents, world_bounds.center + world_bounds.extents };
+        }
+    }
+
+    SceneBvh::SceneBvh(flecs::world& world) {
+        m_on_set = world.observer<const Transform, const MeshBounds>()
+            .event(flecs::OnSet)
+            .each([this](flecs::entity entity, const Transform& transform, const MeshBounds& bounds) {
+                const auto object = m_objects.find(entity.id());
+                if (object == m_objects.end()) {
+                    m_rebuild = true;
+                    return;
+                }
+                m_bvh.update(object->second, world_aabb(transform, bounds));
+            });
+        m_on_remove = world.observer<const Transform, const MeshBounds>()
+            .event(flecs::OnRemove)
+            .each([this](flecs::entity, const Transform&, const MeshBounds&) {
+                m_rebuild = true;
+            });
+        m_on_mesh = world.observer<const MeshRenderer>()
+            .event(flecs::OnSet)
+            .each([](flecs::entity entity, const MeshRenderer& mesh) {
+                entity.set<MeshBounds>(asset_bounds(*mesh.asset));
+            });
+    }
+
+    SceneBvh::~SceneBvh() {
+        m_on_set.destruct();
+        m_on_remove.destruct();
+        m_on_mesh.destruct();
+    }
+
+    void SceneBvh::update(flecs::world& world) {
+        if (!m_rebuild) {
+            m_bvh.refit();
+            m_rebuild = m_bvh.cost_ratio() > rebuild_threshold;
+        }
+        if (m_rebuild) {
+            rebuild(world);
+        }
+    }
+
+    void SceneBvh::rebuild(flecs::world& world) {
+        std::vector<Aabb> bounds;
+        std::vector<uint64_t> ids;
+        world.each([&](flecs::entity entity, const Transform& transform, const MeshBounds& mesh_bounds) {
+            bounds.push_back(world_aabb(transform, mesh_bounds));
+            ids.push_back(entity.id());
+        });
+
+        m_bvh.build(bounds, ids);
+        m_objects.clear();
+        m_objects.reserve(ids.size());
+        for (uint32_t i = 0; i < ids.size(); i++) {
+            m_objects.emplace(ids[i], i);
+        }
+        m_rebuild = false;
+    }
+}
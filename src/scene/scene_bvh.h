@@ -0,0 +1,38 @@
+#pragma once
+
+#include "defines.h"
+#include <unordered_map>
+#include <vector>
+#include <flecs.h>
+
+#include "scene/bvh.h"
+
+namespace Posideon {
+    // Keeps a Bvh over the world space bounds of every entity with a Transform and MeshBounds. Transform
+    // changes on known entities are refitted, entities appearing or disappearing trigger a rebuild, as does
+    // the refitted tree growing past rebuild_threshold times its build cost. Setting a MeshRenderer attaches
+    // the MeshBounds of its asset, so every drawn entity ends up in the tree.
+    class SceneBvh {
+        Bvh m_bvh;
+        std::unordered_map<uint64_t, uint32_t> m_objects;
+        bool m_rebuild = true;
+        flecs::observer m_on_set;
+        flecs::observer m_on_remove;
+        flecs::observer m_on_mesh;
+
+        void rebuild(flecs::world& world);
+
+    public:
+        float rebuild_threshold = 1.5f;
+
+        explicit SceneBvh(flecs::world& world);
+        SceneBvh(const SceneBvh&) = delete;
+        SceneBvh& operator=(const SceneBvh&) = delete;
+        ~SceneBvh();
+
+        void update(flecs::world& world);
+
+        [[nodiscard]] const Bvh& bvh() const { return m_bvh; }
+        [[nodiscard]] flecs::entity entity(flecs::world& world, uint32_t object) const { return world.entity(m_bvh.id(object)); }
+    };
+}
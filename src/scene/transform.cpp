@@ -0,0 +1,31 @@
+#include "transform.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define POSIDEON_TRANSFORM_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace Posideon {
+    glm::mat4 multiply_transforms(const glm::mat4& parent, const glm::mat4& local) {
+#if defined(POSIDEON_TRANSFORM_SSE)
+        // Column j of the result is the parent's columns weighted by the components of local column j.
+        const __m128 p0 = _mm_loadu_ps(&parent[0][0]);
+        const __m128 p1 = _mm_loadu_ps(&parent[1][0]);
+        const __m128 p2 = _mm_loadu_ps(&parent[2][0]);
+        const __m128 p3 = _mm_loadu_ps(&parent[3][0]);
+
+        glm::mat4 result;
+        for (int column = 0; column < 4; column++) {
+            const glm::vec4& l = local[column];
+            __m128 sum = _mm_mul_ps(p0, _mm_set1_ps(l.x));
+            sum = _mm_add_ps(sum, _mm_mul_ps(p1, _mm_set1_ps(l.y)));
+            sum = _mm_add_ps(sum, _mm_mul_ps(p2, _mm_set1_ps(l.z)));
+            sum = _mm_add_ps(sum, _mm_mul_ps(p3, _mm_set1_ps(l.w)));
+            _mm_storeu_ps(&result[column][0], sum);
+        }
+        return result;
+#else
+        return parent * local;
+#endif
+    }
+}
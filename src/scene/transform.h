@@ -0,0 +1,20 @@
+#pragma once
+
+#include "defines.h"
+#include <glm/glm.hpp>
+
+namespace Posideon {
+    // Relative to the ChildOf parent, or to the world for entities without one. Setting it marks the entity
+    // and its subtree for TransformHierarchy to recompute.
+    struct LocalTransform {
+        glm::mat4 matrix { 1.0f };
+    };
+
+    // World space transform. Entities with a LocalTransform get one automatically and should treat it as
+    // read only, it is overwritten by the next propagation.
+    struct Transform {
+        glm::mat4 model { 1.0f };
+    };
+
+    [[nodiscard]] glm::mat4 multiply_transforms(const glm::mat4& parent, const glm::mat4& local);
+}
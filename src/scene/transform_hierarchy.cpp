@@ -0,0 +1,105 @@
+#include "transform_hierarchy.h"
+
+#include "core/job_system.h"
+#include "scene/transform.h"
+
+namespace Posideon {
+    namespace {
+        constexpr uint32_t PROPAGATION_MIN_CHUNK = 256;
+    }
+
+    TransformHierarchy::TransformHierarchy(flecs::world& world) {
+        world.component<LocalTransform>().add(flecs::With, world.component<Transform>());
+
+        m_on_set = world.observer<const LocalTransform>()
+            .event(flecs::OnSet)
+            .each([this](flecs::entity entity, const LocalTransform&) {
+                mark_dirty(entity);
+            });
+        m_on_parent = world.observer()
+            .with(flecs::ChildOf, flecs::Wildcard)
+            .event(flecs::OnAdd)
+            .each([this](flecs::iter& it, size_t row) {
+                mark_dirty(it.entity(row));
+            });
+    }
+
+    TransformHierarchy::~TransformHierarchy() {
+        m_on_set.destruct();
+        m_on_parent.destruct();
+    }
+
+    void TransformHierarchy::mark_dirty(flecs::entity entity) {
+        if (m_dirty_set.insert(entity.id()).second) {
+            m_dirty.push_back(entity);
+        }
+    }
+
+    void TransformHierarchy::push_item(flecs::entity entity, const glm::mat4* parent) {
+        m_items.push_back(PropagationItem {
+            .parent = parent,
+            .local = &entity.get<LocalTransform>()->matrix,
+            .world = &entity.get_mut<Transform>()->model,
+        });
+        m_entities.push_back(entity);
+    }
+
+    void TransformHierarchy::update(JobSystem& jobs) {
+        m_items.clear();
+        m_entities.clear();
+        m_level_offsets.clear();
+        if (m_dirty.empty()) {
+            return;
+        }
+
+        // Roots are dirty entities without a dirty ancestor, everything below them is recomputed anyway.
+        for (flecs::entity entity : m_dirty) {
+            if (!entity.is_alive() || !entity.has<LocalTransform>()) {
+                continue;
+            }
+            const flecs::entity parent = entity.parent();
+            bool covered = false;
+            for (flecs::entity ancestor = parent; ancestor && ancestor.has<LocalTransform>() && !covered; ancestor = ancestor.parent()) {
+                covered = m_dirty_set.contains(ancestor.id());
+            }
+            if (!covered) {
+                const Transform* parent_transform = parent ? parent.get<Transform>() : nullptr;
+                push_item(entity, parent_transform ? &parent_transform->model : nullptr);
+            }
+        }
+        m_dirty.clear();
+        m_dirty_set.clear();
+
+        // Gather every level up front, component pointers stay valid as nothing changes structurally below.
+        uint32_t level_begin = 0;
+        while (level_begin < m_items.size()) {
+            m_level_offsets.push_back(level_begin);
+            const uint32_t level_end = static_cast<uint32_t>(m_items.size());
+            for (uint32_t i = level_begin; i < level_end; i++) {
+                const glm::mat4* world = m_items[i].world;
+                m_entities[i].children([&](flecs::entity child) {
+                    if (child.has<LocalTransform>()) {
+                        push_item(child, world);
+                    }
+                });
+            }
+            level_begin = level_end;
+        }
+        m_level_offsets.push_back(static_cast<uint32_t>(m_items.size()));
+
+        for (size_t level = 0; level + 1 < m_level_offsets.size(); level++) {
+            const uint32_t offset = m_level_offsets[level];
+            jobs.parallel_for(m_level_offsets[level + 1] - offset, PROPAGATION_MIN_CHUNK, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t i = offset + begin; i < offset + end; i++) {
+                    const PropagationItem& item = m_items[i];
+                    *item.world = item.parent ? multiply_transforms(*item.parent, *item.local) : *item.local;
+                }
+            });
+        }
+
+        // Observers of Transform, such as the scene BVH, only see writes that are flagged as modified.
+        for (flecs::entity entity : m_entities) {
+            entity.modified<Transform>();
+        }
+    }
+}
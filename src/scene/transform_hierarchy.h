@@ -0,0 +1,46 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+#include <flecs.h>
+#include <glm/glm.hpp>
+
+namespace Posideon {
+    class JobSystem;
+
+    // Propagates LocalTransform through ChildOf hierarchies into Transform. Entities whose LocalTransform is
+    // set or that are reparented are marked dirty, each update recomputes only the subtrees below dirty
+    // entities, breadth first so that every level can be processed in parallel once its parents are final.
+    // Children without a LocalTransform are not part of the hierarchy and stop the descent.
+    class TransformHierarchy {
+        struct PropagationItem {
+            const glm::mat4* parent;
+            const glm::mat4* local;
+            glm::mat4* world;
+        };
+
+        std::vector<flecs::entity> m_dirty;
+        std::unordered_set<uint64_t> m_dirty_set;
+        std::vector<PropagationItem> m_items;
+        std::vector<flecs::entity> m_entities;
+        std::vector<uint32_t> m_level_offsets;
+        flecs::observer m_on_set;
+        flecs::observer m_on_parent;
+
+        void mark_dirty(flecs::entity entity);
+        void push_item(flecs::entity entity, const glm::mat4* parent);
+
+    public:
+        explicit TransformHierarchy(flecs::world& world);
+        TransformHierarchy(const TransformHierarchy&) = delete;
+        TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+        ~TransformHierarchy();
+
+        void update(JobSystem& jobs);
+
+        // Entities recomputed by the last update.
+        [[nodiscard]] uint32_t updated_count() const { return static_cast<uint32_t>(m_entities.size()); }
+    };
+}
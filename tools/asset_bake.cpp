@@ -0,0 +1,104 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <fastgltf/parser.hpp>
+
+#include "assets/gltf_images.h"
+#include "assets/ktx2_loader.h"
+#include "assets/texture_bake.h"
+#include "core/job_system.h"
+
+using namespace Posideon;
+
+// Fills the texture cache ahead of time so the runtime never decodes a PNG or JPEG.
+//     asset_bake scene.glb ...                               every image of the scene, usage taken from its materials
+//     asset_bake --usage normal|data|single|color image.png  standalone images, colour unless told otherwise
+namespace {
+    uint32_t baked = 0;
+    uint32_t failed = 0;
+
+    void bake(std::span<const uint8_t> bytes, TextureUsage usage, const std::filesystem::path& cache_directory, const std::string& name, JobSystem& jobs) {
+        if (bytes.empty() || is_ktx2(bytes)) {
+            return;
+        }
+        const auto start = std::chrono::high_resolution_clock::now();
+        const std::optional<CompressedTexture> texture = bake_texture(bytes, usage, cache_directory, jobs);
+        const auto end = std::chrono::high_resolution_clock::now();
+        if (!texture) {
+            printf("%s: failed to decode\n", name.c_str());
+            failed++;
+            return;
+        }
+        printf("%s: %ux%u, %zu levels, %.1f ms\n", name.c_str(), texture->width, texture->height, texture->level_offsets.size(),
+            std::chrono::duration<double, std::milli>(end - start).count());
+        baked++;
+    }
+
+    void bake_gltf(const std::filesystem::path& path, JobSystem& jobs) {
+        fastgltf::GltfDataBuffer data;
+        if (!data.loadFromFile(path)) {
+            printf("%s: cannot be read\n", path.string().c_str());
+            failed++;
+            return;
+        }
+        constexpr auto gltf_options = fastgltf::Options::LoadGLBBuffers | fastgltf::Options::LoadExternalBuffers;
+        fastgltf::Parser parser {};
+        auto load = path.extension() == ".gltf" ? parser.loadGLTF(&data, path.parent_path(), gltf_options) : parser.loadBinaryGLTF(&data, path.parent_path(), gltf_options);
+        if (!load) {
+            printf("%s: not a valid glTF file\n", path.string().c_str());
+            failed++;
+            return;
+        }
+        const fastgltf::Asset gltf = std::move(load.get());
+
+        const std::vector<TextureUsage> usages = gltf_image_usages(gltf);
+        std::vector<uint8_t> storage;
+        for (size_t i = 0; i < gltf.images.size(); i++) {
+            const std::span<const uint8_t> bytes = gltf_image_bytes(gltf, gltf.images[i], path.parent_path(), storage);
+            bake(bytes, usages[i], texture_cache_directory(), path.string() + "#image" + std::to_string(i), jobs);
+        }
+    }
+
+    void bake_image(const std::filesystem::path& path, TextureUsage usage, JobSystem& jobs) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            printf("%s: cannot be read\n", path.string().c_str());
+            failed++;
+            return;
+        }
+        std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        bake(bytes, usage, texture_cache_directory(), path.string(), jobs);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("usage: asset_bake [--usage color|normal|data|single] <file.glb|file.gltf|image>...\n");
+        return 1;
+    }
+
+    JobSystem jobs;
+    TextureUsage usage = TextureUsage::Color;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--usage") == 0 && i + 1 < argc) {
+            const std::string value = argv[++i];
+            usage = value == "normal" ? TextureUsage::Normal : value == "data" ? TextureUsage::Data :
+                value == "single" ? TextureUsage::SingleChannel : TextureUsage::Color;
+            continue;
+        }
+        const std::filesystem::path path = argv[i];
+        if (path.extension() == ".glb" || path.extension() == ".gltf") {
+            bake_gltf(path, jobs);
+        } else {
+            bake_image(path, usage, jobs);
+        }
+    }
+
+    printf("%u textures baked, %u failed\n", baked, failed);
+    return failed == 0 ? 0 : 1;
+}